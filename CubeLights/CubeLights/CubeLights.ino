@@ -93,6 +93,8 @@ void setup()
 
   /* Setup the sensors */
   initializePins();
+  sensor_photo_init();
+  sensor_cap_init();
 
   DEBUG2_VALUE("* Setup complete for CUBE_NUMBER=", CUBE_NUMBER);
   DEBUG2_VALUELN(" Build=", CUBE_LIGHT_BUILD);
@@ -107,9 +109,9 @@ void setup()
 void loop()
 {
   /* Check the sensor values */
-  //sensor_photo();
+  sensor_photo();
   sensor_cap();
-  //  sensor_range();
+  sensor_range();
 
   handle_messages();
 
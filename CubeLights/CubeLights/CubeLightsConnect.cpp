@@ -28,6 +28,8 @@
 #include "PixelUtil.h"
 #include "RS485Utils.h"
 #include "MPR121.h"
+#include "MessageRing.h"
+#include "MessageBatch.h"
 
 #include "SquareStructure.h"
 #include "CubeLights.h"
@@ -37,10 +39,12 @@
 RS485Socket rs485;
 uint16_t my_address = 0;
 
-#define SEND_BUFFER_SIZE RS485_BUFFER_TOTAL(sizeof (msg_hdr_t) + sizeof (msg_max_t) + 16) // XXX: Could this be smaller?
+#define SEND_DATA_SIZE (sizeof (msg_hdr_t) + sizeof (msg_max_t) + 16) // XXX: Could this be smaller?
+#define SEND_BUFFER_SIZE RS485_BUFFER_TOTAL(SEND_DATA_SIZE)
 
 byte databuffer[SEND_BUFFER_SIZE];
 byte *send_buffer; // Pointer to use for start of send data
+MessageBatch hmtl_batch(NULL, 0); // Batched commands, within send_buffer
 
 /*
  * There appears to be some time needed between sending a message and checking
@@ -58,6 +62,7 @@ void initializeConnect() {
 
   rs485.setup();
   send_buffer = rs485.initBuffer(databuffer);
+  hmtl_batch = MessageBatch(send_buffer, SEND_DATA_SIZE);
 
   DEBUG2_VALUE("Initialized RS485. address=", my_address);
   DEBUG2_VALUELN(" bufsize=", SEND_BUFFER_SIZE);
@@ -92,47 +97,121 @@ void sendLong(long value, byte address) {
   last_sent_time = millis();
 }
 
-void sendHMTLValue(uint16_t address, uint8_t output, int value) {
-  DEBUG5_PRINTLN("sendHMTLValue");
-  hmtl_send_value(&rs485, send_buffer, SEND_BUFFER_SIZE,
-		  address, output, value);
+/*
+ * HMTL commands are sent as soon as they are made, unless a batch has been
+ * started with beginHMTLBatch().  The commands made until sendHMTLBatch() are
+ * then sent together as a single message, which the receivers unpack in the
+ * order the commands were made.  The batch is built in the send buffer, so
+ * nothing else may be sent while it is open.
+ */
+boolean batching = false;
+
+void beginHMTLBatch() {
+  hmtl_batch.clear();
+  batching = true;
+}
+
+boolean sendHMTLBatch() {
+  batching = false;
+  uint16_t len = hmtl_batch.finish();
+  if (len == 0) return false;
+
+  rs485.sendMsgTo(hmtl_batch.address(), send_buffer, len);
   last_sent_time = millis();
+  return true;
 }
 
-void sendHMTLBlink(uint16_t address, uint8_t output,
-		   uint16_t on_period, uint32_t on_color,
-		   uint16_t off_period, uint32_t off_color) {
-  DEBUG5_PRINTLN("sendHMTLBlink");
-  hmtl_send_blink(&rs485, send_buffer, SEND_BUFFER_SIZE,
-		  address, output,
-		  on_period, on_color,
-		  off_period, off_color);
+/* Where to format the next command, and the room there is for it */
+byte *hmtlMsgBuffer() {
+  return batching ? hmtl_batch.tail() : send_buffer;
+}
+
+uint16_t hmtlMsgSpace() {
+  return batching ? hmtl_batch.space() : SEND_DATA_SIZE;
+}
+
+/* Send the command formatted by the caller or add it to the open batch */
+boolean sendHMTLMsg(uint16_t len) {
+  if (batching) return hmtl_batch.add(len);
+
+  if (len == 0) {
+    DEBUG1_PRINTLN("Failed to format msg");
+    return false;
+  }
+  rs485.sendMsgTo(((msg_hdr_t *)send_buffer)->address, send_buffer, len);
   last_sent_time = millis();
+  return true;
+}
+
+boolean sendHMTLValue(uint16_t address, uint8_t output, int value) {
+  DEBUG5_PRINTLN("sendHMTLValue");
+  return sendHMTLMsg(hmtl_value_fmt(hmtlMsgBuffer(), hmtlMsgSpace(),
+                                    address, output, value));
+}
+
+boolean sendHMTLBlink(uint16_t address, uint8_t output,
+		      uint16_t on_period, uint32_t on_color,
+		      uint16_t off_period, uint32_t off_color) {
+  DEBUG5_PRINTLN("sendHMTLBlink");
+  return sendHMTLMsg(hmtl_blink_fmt(hmtlMsgBuffer(), hmtlMsgSpace(),
+                                    address, output,
+                                    on_period, on_color,
+                                    off_period, off_color));
 }
 
-void sendHMTLTimedChange(uint16_t address, uint8_t output,
-			 uint32_t change_period,
-			 uint32_t start_color,
-			 uint32_t stop_color) {
+boolean sendHMTLTimedChange(uint16_t address, uint8_t output,
+			    uint32_t change_period,
+			    uint32_t start_color,
+			    uint32_t stop_color) {
   DEBUG5_PRINTLN("sendHMTLTimedChange");
-  hmtl_send_timed_change(&rs485, send_buffer, SEND_BUFFER_SIZE,
-			 address, output,
-			 change_period,
-			 start_color,
-			 stop_color);
-  last_sent_time = millis();
+  return sendHMTLMsg(hmtl_timed_change_fmt(hmtlMsgBuffer(), hmtlMsgSpace(),
+                                           address, output,
+                                           change_period,
+                                           start_color,
+                                           stop_color));
 }
 
-void sendHMTLSensorRequest(uint16_t address) {
+boolean sendHMTLSensorRequest(uint16_t address) {
   DEBUG5_VALUELN("sendHMTLSensorRequest:", millis());
-  hmtl_send_sensor_request(&rs485, send_buffer, SEND_BUFFER_SIZE, address);
-  last_sent_time = millis();
+  uint16_t len = 0;
+  if (hmtlMsgSpace() >= sizeof (msg_hdr_t)) {
+    hmtl_msg_fmt((msg_hdr_t *)hmtlMsgBuffer(), address, sizeof (msg_hdr_t),
+                 MSG_TYPE_SENSOR, 0);
+    len = sizeof (msg_hdr_t);
+  }
+  return sendHMTLMsg(len);
 }
 
 
 unsigned long sensor_check_time = 0;
 msg_hdr_t *sensor_msg = NULL;
 
+/*
+ * Received messages are copied out of the RS485 buffer so that they remain
+ * intact while being handled.  The modes read them through recv_views, which
+ * are released at the start of the following loop.
+ */
+#define RECV_SLOTS 3
+#define RECV_SLOT_SIZE (sizeof (msg_hdr_t) + sizeof (msg_max_t) + 16)
+byte recv_buffer[MESSAGE_RING_SIZE(RECV_SLOTS, RECV_SLOT_SIZE)];
+MessageRing recv_ring(recv_buffer, RECV_SLOTS, RECV_SLOT_SIZE);
+message_view_t recv_views[RECV_SLOTS];
+byte recv_count = 0;
+
+/* Returns true if the data looks like an HMTL message */
+boolean is_hmtl_msg(const byte *data, uint16_t length) {
+  return ((length >= sizeof (msg_hdr_t)) &&
+          (((msg_hdr_t *)data)->startcode == HMTL_MSG_START));
+}
+
+/* Handle a message for this module */
+void handle_msg(msg_hdr_t *msg_hdr) {
+  DEBUG4_VALUE("Recv type:", msg_hdr->type);
+  if (msg_hdr->type == MSG_TYPE_SENSOR) {
+    sensor_msg = msg_hdr;
+  }
+}
+
 /*
  * RS485 Message handling
  */
@@ -140,14 +219,45 @@ void handle_messages() {
   unsigned long now = millis();
   sensor_msg = NULL;
 
+  /* Everything received last loop has been handled */
+  for (byte i = 0; i < recv_count; i++) {
+    recv_ring.release(&recv_views[i]);
+  }
+  recv_count = 0;
+
   if (now - last_sent_time > MIN_SEND_TO_READ_MS) {
-    /* Check for messages */
+    /* Store every message that has arrived, or as many as there is room for */
     unsigned int msglen;
-    msg_hdr_t *msg_hdr = hmtl_socket_getmsg(&rs485, &msglen, my_address);
-    if (msg_hdr) {
-      DEBUG4_VALUE("Recv type:", msg_hdr->type);
-      if (msg_hdr->type == MSG_TYPE_SENSOR) {
-        sensor_msg = msg_hdr;
+    const byte *data;
+    while (!recv_ring.full() &&
+           ((data = rs485.getMsg(my_address, &msglen)) != NULL)) {
+      recv_ring.push(data, msglen);
+    }
+    if (recv_ring.full()) {
+      // Anything further is left in the socket until the next loop
+      recv_ring.noteFull();
+      DEBUG4_VALUELN("Recv ring full:", recv_ring.stats.full);
+    }
+
+    for (byte i = 0; i < recv_ring.count(); i++) {
+      if (!recv_ring.view(i, &recv_views[recv_count])) continue;
+      message_view_t *view = &recv_views[recv_count++];
+      if (!is_hmtl_msg(view->data, view->length)) continue;
+
+      msg_hdr_t *msg_hdr = (msg_hdr_t *)view->data;
+      if (msg_hdr->type != MSG_TYPE_BATCH) {
+        handle_msg(msg_hdr);
+        continue;
+      }
+
+      /* Each message of a batch is handled as if it had arrived alone */
+      if (msg_hdr->length > view->length) continue;
+      msg_hdr_t *msg = NULL;
+      while ((msg = MessageBatch::unpack(msg_hdr, msg)) != NULL) {
+        if ((msg->address == my_address) ||
+            (msg->address == SOCKET_ADDR_ANY)) {
+          handle_msg(msg);
+        }
       }
     }
     DEBUG_PRINT_END();
@@ -158,6 +268,5 @@ void handle_messages() {
   if (now >= sensor_check_time) {
     sendHMTLSensorRequest(ADDRESS_SOUND_UNIT);
     sensor_check_time = now + 250;
-    last_sent_time = now;
   }
 }
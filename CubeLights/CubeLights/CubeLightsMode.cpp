@@ -41,6 +41,7 @@ uint8_t validModes[] = {
   //, MODE_SOUND_TEST
   , MODE_SOUND_HMTL
   //, MODE_STROBE
+  , MODE_RIPPLES
 };
 #define VALID_MODES (sizeof (validModes) / sizeof (uint8_t))
 
@@ -65,6 +66,7 @@ square_mode_t modeFunctions[] = {
   NULL, //squaresSoundTest,
   squaresSoundHMTL,
   NULL, //squaresStrobe
+  squaresRipples,
 };
 #define NUM_MODES (sizeof (modeFunctions) / sizeof (square_mode_t))
 
@@ -89,7 +91,8 @@ uint16_t modePeriods[] = {
   500,  // MODE_SIMPLE_LIFE
   100,  // MODE_SOUND_TEST
   100,  // MODE_SOUND_TEST2
-  1     // MODE_STROBE
+  1,    // MODE_STROBE
+  20    // MODE_RIPPLES
 };
 
 #ifndef CUBE_START_MODE
@@ -132,7 +135,7 @@ void set_mode(uint8_t place, uint8_t new_mode) {
     DEBUG3_VALUELN("=", current_modes[place]);
 
     // Reset the brightness
-    FastLED.setBrightness(255);
+    squarePower.setBrightness(255);
   }
 }
 
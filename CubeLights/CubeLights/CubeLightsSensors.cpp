@@ -13,6 +13,8 @@
 #include <NewPing.h>
 #include <Wire.h>
 #include "MPR121.h"
+#include "MedianFilter.h"
+#include "AdcScan.h"
 
 #include "CubeLights.h"
 #include "CubeConfig.h"
@@ -21,83 +23,286 @@
 /* ***** Range sensor *********************************************************/
 
 NewPing sonar(PING_TRIG_PIN, PING_ECHO_PIN, PING_MAX_CM);
+MedianFilter range_filter;
 
-int range_cm = 10;
+volatile boolean ping_received = false;
+volatile unsigned int ping_echo_us = 0;
+boolean ping_pending = false;
+
+/*
+ * Called from NewPing's timer interrupt while a ping is outstanding
+ */
+void ping_echo_check(void)
+{
+  // WARNING: Its unsafe to put print statements in an interrupt handler
+  if (sonar.check_timer()) {
+    ping_echo_us = sonar.ping_result;
+    ping_received = true;
+  }
+}
+
+/*
+ * Start a ping every PING_DELAY_MS and collect the results of previous pings
+ * as they arrive, without waiting on the echo.
+ */
+int range_cm = PING_MAX_CM;
 void sensor_range(void)
 {
-  static unsigned long nextPing = millis();
+  static unsigned long nextPing = 0;
   unsigned long now = millis();
+
+  if (ping_received) {
+    noInterrupts();
+    unsigned int echo_us = ping_echo_us;
+    ping_received = false;
+    interrupts();
+
+    int new_range = echo_us / US_ROUNDTRIP_CM;
+    if (new_range == 0) new_range = PING_MAX_CM;
+    range_filter.add(new_range);
+    ping_pending = false;
+  }
+
   if (now >= nextPing) {
     nextPing = now + PING_DELAY_MS;
 
-    int new_range = sonar.ping_cm();
-    if (new_range == 0) new_range = PING_MAX_CM;
-    if (new_range != range_cm) {
-      DEBUG4_COMMAND(
-                     if (abs(new_range - range_cm) > 5) {
-                       DEBUG4_VALUE(" Ping cm:", new_range);
-                       DEBUG4_VALUE(" old_cm:", range_cm);
-                       DEBUG4_VALUELN(" time:", millis() - now);
-                     }
-                     );
-      range_cm = new_range;
+    if (ping_pending) {
+      // No echo was received within the maximum distance
+      range_filter.add(PING_MAX_CM);
     }
+    ping_pending = true;
+    sonar.ping_timer(ping_echo_check);
+  }
+
+  int new_range = range_filter.value();
+  if ((range_filter.count() > 0) && (new_range != range_cm)) {
+    DEBUG4_COMMAND(
+                   if (abs(new_range - range_cm) > 5) {
+                     DEBUG4_VALUE(" Ping cm:", new_range);
+                     DEBUG4_VALUELN(" old_cm:", range_cm);
+                   }
+                   );
+    range_cm = new_range;
   }
 }
 
 /* ***** Photo sensor *********************************************************/
 
-#if 0
 uint16_t photo_value = 1024;
 boolean photo_dark = false;
-void sensor_photo(void)
-{
-  static unsigned long next_photo_sense = millis();
-  unsigned long now = millis();
 
-  if (now > next_photo_sense) {
-    next_photo_sense = now + PHOTO_DELAY_MS;
+byte photo_channel;
+byte photo_sequence = 0;
+
+/*
+ * The photo sensor is read by the ADC scanner on Timer0 overflows rather than
+ * by waiting on analogRead()
+ */
+void sensor_photo_init(void)
+{
+  adcScan.begin(ADC_SCAN_AVCC, ADC_SCAN_TIMER0);
+  photo_channel = adcScan.add(PHOTO_PIN, 1000 / PHOTO_DELAY_MS, 2);
+}
 
-    photo_value = analogRead(PHOTO_PIN);
+void sensor_photo(void)
+{
+  if (adcScan.updated(photo_channel, &photo_sequence)) {
+    photo_value = adcScan.value(photo_channel);
     if (photo_value > PHOTO_THRESHOLD_HIGH) {
       photo_dark = false;
     } else if (photo_value < PHOTO_THRESHOLD_LOW) {
-      photo_dark = false;
+      photo_dark = true;
     }
     DEBUG4_VALUE(" Photo:", photo_value);
   }
 }
-#endif
 
 /* ***** Capacitive Sensors ***************************************************/
 
 MPR121 touch_sensor; // MPR121 must be initialized after Wire.begin();
+#if CAP_NUM_DEVICES > 1
+MPR121 touch_sensor_2;
+#endif
 
-void sensor_cap(void) 
+MPR121 *touch_devices[CAP_NUM_DEVICES] = {
+  &touch_sensor,
+#if CAP_NUM_DEVICES > 1
+  &touch_sensor_2,
+#endif
+};
+
+/*
+ * Electrodes that are next to each other for swipes, indexed by electrode
+ */
+#if CUBE_NUMBER == BIG_CUBE
+// XXX: Assumes the pads on each device are wired in order
+const byte cap_swipe_next[CAP_NUM_ELECTRODES] PROGMEM = {
+  1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, TOUCH_NO_SENSOR,
+  13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, TOUCH_NO_SENSOR,
+};
+#else
+const byte cap_swipe_next[CAP_NUM_ELECTRODES] PROGMEM = {
+  1, TOUCH_NO_SENSOR, TOUCH_NO_SENSOR, TOUCH_NO_SENSOR,
+  TOUCH_NO_SENSOR, TOUCH_NO_SENSOR, TOUCH_NO_SENSOR, TOUCH_NO_SENSOR,
+  TOUCH_NO_SENSOR, TOUCH_NO_SENSOR, TOUCH_NO_SENSOR, TOUCH_NO_SENSOR,
+};
+#endif
+
+TouchEventQueue touch_events;
+touch_state_t touch_states[CAP_NUM_ELECTRODES];
+TouchGestures touch_gestures(CAP_NUM_ELECTRODES, touch_states,
+                             CAP_DOUBLE_MS, CAP_LONG_MS);
+
+volatile boolean cap_triggered = false;
+volatile unsigned long cap_trigger_ms = 0;
+
+/*
+ * The MPR121 pulls its IRQ line low when the touch state changes.  The I2C
+ * read can't be done from the interrupt handler as Wire relies on interrupts
+ * itself, so this only records when the change happened.
+ */
+void cap_interrupt(void)
 {
-#if 0
-  if (touch_sensor.useInterrupt) {
-    if (!touch_sensor.triggered) return;
-  } else {
-    /* Determine if its time to perform a check */
-    static long next_check = millis();
-    long now = millis();
-    if (now < next_check) return;
-    next_check = now + CAP_DELAY_MS;
+  // WARNING: Its unsafe to put print statements in an interrupt handler
+  if (!cap_triggered) {
+    cap_trigger_ms = millis();
+    cap_triggered = true;
+  }
+}
+
+void sensor_cap_init(void)
+{
+  pinMode(CAP_IRQ_PIN, INPUT_PULLUP);
+  attachInterrupt(CAP_IRQ_INTERRUPT, cap_interrupt, FALLING);
+
+#if CAP_NUM_DEVICES > 1
+  touch_sensor_2 = MPR121(CAP_IRQ_PIN_2, // triggered/interupt pin
+                          false,         // interrupt mode?
+                          CAP_ADDRESS_2,
+                          true,          // use touch times
+                          false          // use auto config and reconfig
+                          );
+  for (byte i = 0; i < MPR121::MAX_SENSORS; i++) {
+    touch_sensor_2.setThreshold(i, 15, 2);
   }
 #endif
 
-  if (touch_sensor.readTouchInputs()) {
+  touch_gestures.setSwipes(cap_swipe_next, CAP_SWIPE_MS);
+}
+
+/*
+ * Read a device and queue an event for each electrode that changed
+ */
+void sensor_cap_read(byte device, unsigned long ms)
+{
+  MPR121 *sensor = touch_devices[device];
+
+  if (sensor->readTouchInputs()) {
+    for (byte i = 0; i < MPR121::MAX_SENSORS; i++) {
+      if (sensor->changed(i)) {
+        if (!touch_events.push(ms, device * MPR121::MAX_SENSORS + i,
+                               sensor->touched(i))) {
+          DEBUG1_PRINTLN("Touch queue full");
+        }
+      }
+    }
+
     DEBUG4_COMMAND(
-                   DEBUG4_PRINT("Cap:");
+                   DEBUG4_VALUE("Cap", device);
+                   DEBUG4_PRINT(":");
                    for (byte i = 0; i < MPR121::MAX_SENSORS; i++) {
-                     DEBUG4_VALUE(" ", touch_sensor.touched(i));
+                     DEBUG4_VALUE(" ", sensor->touched(i));
                    }
-                   DEBUG4_VALUELN(" ms:", millis());
+                   DEBUG4_VALUELN(" ms:", ms);
                    );
   }
 }
 
+void sensor_cap(void) 
+{
+  /*
+   * The IRQ line stays low until the sensor is read, so check it as well in
+   * case the edge happened before the interrupt was attached.
+   */
+  if (cap_triggered || (digitalRead(CAP_IRQ_PIN) == LOW)) {
+    noInterrupts();
+    unsigned long ms = cap_triggered ? cap_trigger_ms : millis();
+    cap_triggered = false;
+    interrupts();
+
+    sensor_cap_read(0, ms);
+  }
+
+#if CAP_NUM_DEVICES > 1
+  /* The additional devices' IRQ lines are polled */
+  if (digitalRead(CAP_IRQ_PIN_2) == LOW) {
+    sensor_cap_read(1, millis());
+  }
+#endif
+}
+
+/*
+ * Gestures completed during the current loop
+ */
+touch_gesture_t sensor_gestures[CAP_MAX_GESTURES];
+byte num_sensor_gestures = 0;
+
+/*
+ * Move events from the queue into this loop's gestures.  Only one change per
+ * electrode is handled each loop so that a touch and its release are seen as
+ * separate changes.
+ */
+void update_gestures(unsigned long now) {
+  uint32_t changed = 0;
+  touch_event_t event;
+
+  num_sensor_gestures = 0;
+  while ((num_sensor_gestures < CAP_MAX_GESTURES) &&
+         touch_events.peek(&event)) {
+    uint32_t bit = (uint32_t)1 << event.sensor;
+    if (changed & bit) break;
+
+    byte gestures = touch_gestures.event(&event);
+    touch_events.pop();
+
+    if (gestures) {
+      changed |= bit;
+      sensor_gestures[num_sensor_gestures].sensor = event.sensor;
+      sensor_gestures[num_sensor_gestures].gestures = gestures;
+      num_sensor_gestures++;
+    }
+  }
+
+  /* Long presses depend only on time, so can be added after the events */
+  byte remaining = CAP_MAX_GESTURES - num_sensor_gestures;
+  num_sensor_gestures += touch_gestures.poll(now,
+                                             &sensor_gestures[num_sensor_gestures],
+                                             remaining);
+}
+
+byte check_gestures(byte electrode) {
+  byte gestures = 0;
+  for (byte i = 0; i < num_sensor_gestures; i++) {
+    if (sensor_gestures[i].sensor == electrode) {
+      gestures |= sensor_gestures[i].gestures;
+    }
+  }
+  return gestures;
+}
+
+/*
+ * Convert the gestures for an electrode into sensor 1's SENSE_* bits
+ */
+uint32_t sense_touch(byte electrode) {
+  byte gestures = check_gestures(electrode);
+  uint32_t state = 0;
+  if (touch_gestures.touched(electrode)) state |= SENSE_TOUCH_1;
+  if (gestures & (TOUCH_PRESS | TOUCH_RELEASE)) state |= SENSE_CHANGE_1;
+  if (gestures & TOUCH_DOUBLE) state |= SENSE_DOUBLE_1;
+  if (gestures & TOUCH_LONG) state |= SENSE_LONG_1;
+  return state;
+}
+
 /* ***** Handle sensor input *************************************************/
 
 /* Bit mask of the complete sensor state */
@@ -132,64 +337,52 @@ void handle_sensors() {
   else if (range_cm < PING_MID_CM) sensor_state |= SENSE_RANGE_MID;
   else if (range_cm < PING_MAX_CM) sensor_state |= SENSE_RANGE_LONG;
 
-  // Sensor 1
-  if (touch_sensor.touched(CAP_SENSOR_1)) sensor_state |= SENSE_TOUCH_1;
-  if (touch_sensor.changed(CAP_SENSOR_1)) sensor_state |= SENSE_CHANGE_1;
-  if (CHECK_TAP_1()) {
-    // Detect double tap on individual sensors
-    static unsigned long taptime1 = 0;
-    if (now - taptime1 < CAP_DOUBLE_MS) {
-      sensor_state |= SENSE_DOUBLE_1;
-      DEBUG4_VALUELN("Double tap1 ms:", now - taptime1);
-    }
-    taptime1 = now;
-  }
-  // XXX - Detect long touch?
-
-  // Sensor 2
-  if (touch_sensor.touched(CAP_SENSOR_2)) sensor_state |= SENSE_TOUCH_2;
-  if (touch_sensor.changed(CAP_SENSOR_2)) sensor_state |= SENSE_CHANGE_2;
-  if (CHECK_TAP_2()) {
-    // Detect double tap on individual sensors
-    static unsigned long taptime2 = 0;
-    if (now - taptime2 < CAP_DOUBLE_MS) {
-      sensor_state |= SENSE_DOUBLE_2;
-      DEBUG4_VALUELN("Double tap2 ms:", now - taptime2);
-    }
-    taptime2 = now;
+  // Flag when the range moves into a different band
+  static uint32_t prev_range = 0;
+  uint32_t range = sensor_state & SENSE_RANGE_ALL;
+  if (range != prev_range) {
+    sensor_state |= SENSE_RANGE_CHANGE;
+    prev_range = range;
   }
-  // XXX - Detect long touch?
 
-  static unsigned long doubleTime = 0;
+  // Touch sensors, sensor 2's bits are sensor 1's shifted up by 4
+  update_gestures(now);
+  sensor_state |= sense_touch(CAP_SENSOR_1);
+  sensor_state |= sense_touch(CAP_SENSOR_2) << 4;
+
+  DEBUG4_COMMAND(
+                 if (CHECK_DOUBLE_1()) DEBUG4_PRINTLN("Double tap1");
+                 if (CHECK_DOUBLE_2()) DEBUG4_PRINTLN("Double tap2");
+                 );
 
   // Both became touched (could be one then the other)
+  static boolean longBoth = false;
   if (CHECK_TAP_BOTH()) {
     static unsigned long taptime = 0;
-    if (now - taptime < CAP_DOUBLE_MS) {
+    unsigned long bothtime = max(touch_gestures.pressedMs(CAP_SENSOR_1),
+                                 touch_gestures.pressedMs(CAP_SENSOR_2));
+    if (bothtime - taptime < CAP_DOUBLE_MS) {
       // Rapid double tap
       sensor_state |= SENSE_DOUBLE_BOTH;
-      DEBUG4_VALUELN("Double tap ms:", now - taptime);
+      DEBUG4_VALUELN("Double tap ms:", bothtime - taptime);
     }
 
-    doubleTime = now;
-    taptime = now;
+    taptime = bothtime;
+    longBoth = false;
   }
 
   // Detect a long touch on both
   if (CHECK_TOUCH_BOTH()) {
-    if ((doubleTime > 0) && ((now - doubleTime) > 750)) {
+    unsigned long bothtime = max(touch_gestures.pressedMs(CAP_SENSOR_1),
+                                 touch_gestures.pressedMs(CAP_SENSOR_2));
+    if (!longBoth && (now - bothtime > CAP_LONG_MS)) {
       // Long touch period
       DEBUG4_PRINTLN("Long double touch");
       sensor_state |= SENSE_LONG_BOTH;
-      doubleTime = 0;
+      longBoth = true;
     }
   }
 
-  // Neither sensor is touched
-  if (CHECK_TOUCH_NONE()) {
-    doubleTime = 0;
-  }
-
   /****************************************************************************
    * Handling
    */
@@ -303,8 +496,9 @@ void sensor_mode_poofer_control(boolean entered, boolean exited) {
   unsigned long now = millis();
 
 #define PILOT_OFF      0
-#define PILOT_IGNITING 1
-#define PILOT_ON       2
+#define PILOT_WARMING  1
+#define PILOT_IGNITING 2
+#define PILOT_ON       3
   static byte pilot_state = PILOT_OFF;
 
   if (exited) {
@@ -325,6 +519,12 @@ void sensor_mode_poofer_control(boolean entered, boolean exited) {
     return;
   }
 
+  /*
+   * Everything sent to the poofer on this call goes out as one message, such
+   * as the light and igniter commands when the mode is entered.
+   */
+  beginHMTLBatch();
+
   if (entered) {
     // Just entered mode changing state
 
@@ -332,17 +532,7 @@ void sensor_mode_poofer_control(boolean entered, boolean exited) {
     sendHMTLValue(ADDRESS_POOFER_UNIT, LIGHT_OUTPUT, 255);
 
     if (pilot_state == PILOT_OFF) {
-      /* If the pilot hadn't previously been ignited, do so now */
-      DEBUG4_PRINTLN("Igniting pilot light");
-
-      delay(10); // XXX - For some reason we need a delay between transmissions
-
-      /* Turn on the hot surface igniter */
-      sendHMTLTimedChange(ADDRESS_POOFER_UNIT, IGNITER_OUTPUT,
-                          30000, 0xFFFFFFFF, 0);
-
-      last_send = now;
-	
+      /* The pilot hadn't previously been ignited, which is started below */
       modeConfigs[FINAL_MODE].fgColor = pixel_color(255, 0, 0);
     } else {
       modeConfigs[FINAL_MODE].fgColor = pixel_color(0, 255, 0);
@@ -355,10 +545,22 @@ void sensor_mode_poofer_control(boolean entered, boolean exited) {
                     modeConfigs[FINAL_MODE].data.u32s[0]);
   }
 
+  /*
+   * Each step of the ignition only advances once its command has been added
+   * to the batch, so that a dropped command is retried rather than skipped.
+   */
   if (pilot_state == PILOT_OFF) {
-    if (now - last_send > 5000) {
+    /* Turn on the hot surface igniter */
+    if (sendHMTLTimedChange(ADDRESS_POOFER_UNIT, IGNITER_OUTPUT,
+                            30000, 0xFFFFFFFF, 0)) {
+      DEBUG4_PRINTLN("Igniting pilot light");
+      pilot_state = PILOT_WARMING;
+      last_send = now;
+    }
+  } else if (pilot_state == PILOT_WARMING) {
+    if ((now - last_send > 5000) &&
+        sendHMTLValue(ADDRESS_POOFER_UNIT, PILOT_VALVE, 255)) {
       /* Once the igniter has had time to warm up, open the pilot valve */
-      sendHMTLValue(ADDRESS_POOFER_UNIT, PILOT_VALVE, 255);
       pilot_state = PILOT_IGNITING;
       modeConfigs[FINAL_MODE].data.u32s[0] =
         FACE_LED_MASK(0xFF, ((1 << 6) | (1 << 8)));
@@ -381,10 +583,10 @@ void sensor_mode_poofer_control(boolean entered, boolean exited) {
         last_send = 0;
       }
 
-      if (now - last_send > REFRESH_PERIOD) {
+      if ((now - last_send > REFRESH_PERIOD) &&
+          sendHMTLTimedChange(ADDRESS_POOFER_UNIT, POOF_OUTPUT,
+                              250, 0xFFFFFFFF, 0)) {
         /* Send a brief on value, repeated calls will keep the valve open */
-        sendHMTLTimedChange(ADDRESS_POOFER_UNIT, POOF_OUTPUT,
-                            250, 0xFFFFFFFF, 0);
         last_send = now;
         DEBUG4_PRINTLN("Sending poof");
       }
@@ -404,6 +606,7 @@ void sensor_mode_poofer_control(boolean entered, boolean exited) {
     }
   }
 
+  sendHMTLBatch();
 }
 
 void sensor_mode_mode_control(boolean entered, boolean exited) {
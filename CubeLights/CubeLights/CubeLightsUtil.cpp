@@ -15,6 +15,12 @@
 
 #include "CubeConfig.h"
 #include "CubeLights.h"
+#include "Ripples.h"
+#include "Palette.h"
+
+/* Colors for the modes, read from tables in flash */
+Palette wheel_palette(PALETTE_WHEEL);
+Palette heat_palette(PALETTE_HEAT);
 
 void initializePins() {
   /* Turn on input pullup on analog light sensor pin */
@@ -51,7 +57,7 @@ void randomSquares(Square *squares, int size) {
 
 void wheelSquares(Square *squares, int size) {
   for (int tri = 0; tri < size; tri++) {
-    squares[tri].setColor(pixel_wheel(map(tri, 0, size - 1, 0, 255)));
+    squares[tri].setColor(wheel_palette.pixel(map(tri, 0, size - 1, 0, 255)));
   }
 }
 
@@ -397,7 +403,7 @@ void squaresAllOn(Square *squares, int size,
         if (sensor->sensor_type == HMTL_SENSOR_POT) {
           uint16_t *level = ((uint16_t *)&sensor->data);
           DEBUG5_VALUELN("Set brightness:", *level);
-          FastLED.setBrightness(map(*level, 0, 1023, 0, 255));
+          squarePower.setBrightness(map(*level, 0, 1023, 0, 255));
           break;
         }
       }
@@ -524,7 +530,7 @@ void squaresCrawl(Square *squares, int size,
       timeincrement = timeincrement / 4;
     arg->next_time += timeincrement;
 
-    face->setColor(led, pixel_wheel(color++));
+    face->setColor(led, wheel_palette.pixel(color++));
 
     byte newled = led;
     Square *newface = face;
@@ -627,17 +633,9 @@ typedef struct {
 } vector_t;
 
 vector_t followVector(vector_t vector, Square *squares) {
-  // Get the current face
-  Square *face = &squares[FACE_FROM_COMBO(vector.led_in_face)];
-
-  // Get the next face and led along the vector
-  uint16_t next = face->ledTowards(LED_FROM_COMBO(vector.led_in_face),
-				   vector.direction);
-  Square *next_face = &squares[FACE_FROM_COMBO(next)];
-  vector.led_in_face = next;
-  if (face != next_face) {
-    vector.direction = REV_DIRECTION(next_face->matchEdge(face));
-  }
+  // Get the next face and led along the vector, and the vector's direction
+  // on that face
+  vector.led_in_face = squareStep(vector.led_in_face, &vector.direction);
   return vector;
 }
 
@@ -685,7 +683,7 @@ void squaresVectors(Square *squares, int size,
 
       // Set the new led
       next_face->setColor(LED_FROM_COMBO(next_vector.led_in_face), 
-			  pixel_wheel(color_index));
+			  wheel_palette.pixel(color_index));
     
       // Iterate backwards from the vector head to set colors
       vector_t reverse_vector = vectors[v];
@@ -693,7 +691,7 @@ void squaresVectors(Square *squares, int size,
       Square *curr_face = face;
       for (byte i = 1; i <reverse_vector.length; i++) {
 	curr_face->setColor(LED_FROM_COMBO(reverse_vector.led_in_face), 
-			    pixel_wheel(color_index - 10 * i));
+			    wheel_palette.pixel(color_index - 10 * i));
 	reverse_vector = followVector(reverse_vector, squares);
 	curr_face = &squares[FACE_FROM_COMBO(reverse_vector.led_in_face)];
       }
@@ -787,7 +785,7 @@ void squaresSimpleLife(Square *squares, int size,
       byte face = random(size - 1);
       byte led = random(Square::NUM_LEDS);
       byte c = random((byte)-1);
-      squares[face].setColor(led, pixel_wheel(c));
+      squares[face].setColor(led, wheel_palette.pixel(c));
 
       arg->data.u32s[SIMPLE_LIFE_SPLASH] = now;
 
@@ -846,8 +844,16 @@ void squaresSoundTest(Square *squares, int size, pattern_args_t *arg) {
   } else if (lastSend != 0) {
     // Check for a response
     unsigned long elapsed = millis() - lastSend;
-    unsigned int msglen;
-    const byte *data = rs485.getMsg(my_address, &msglen);
+    // The response is raw data rather than an HMTL message
+    uint16_t msglen = 0;
+    const byte *data = NULL;
+    for (byte i = 0; i < recv_count; i++) {
+      if (!is_hmtl_msg(recv_views[i].data, recv_views[i].length)) {
+        data = recv_views[i].data;
+        msglen = recv_views[i].length;
+        break;
+      }
+    }
     if (data != NULL) {
       DEBUG5_PRINT(" value:");
 #ifdef SOUND_LEVELED
@@ -859,7 +865,7 @@ void squaresSoundTest(Square *squares, int size, pattern_args_t *arg) {
       byte face = 0;
       byte col = 0;
       uint32_t total = 0;
-      while ((unsigned int)valptr - (unsigned int)data < msglen) {
+      while ((const byte *)valptr - data < msglen) {
 #ifdef SOUND_LEVELED
         uint8_t val = *valptr;
 #else
@@ -871,7 +877,7 @@ void squaresSoundTest(Square *squares, int size, pattern_args_t *arg) {
         uint32_t newcolor;
         if (val) {
           byte heat = (val > 15 ? 255 : val * val);
-          newcolor = pixel_heat(heat);
+          newcolor = heat_palette.pixel(heat);
         } else {
           newcolor = 0;
         }
@@ -893,7 +899,7 @@ void squaresSoundTest(Square *squares, int size, pattern_args_t *arg) {
 
       byte heat = total > 15 ? 255 : total * total;
 
-      squares[CUBE_TOP].setColor(pixel_heat(heat));
+      squares[CUBE_TOP].setColor(heat_palette.pixel(heat));
       DEBUG5_VALUE(" avg:", total);
       DEBUG_PRINT_END();
 
@@ -970,7 +976,7 @@ void squaresSoundHMTL(Square *squares, int size, pattern_args_t *arg) {
       uint32_t newcolor;
       if (val) {
         byte heat = (val > 15 ? 255 : val * val);
-        newcolor = pixel_heat(heat);
+        newcolor = heat_palette.pixel(heat);
       } else {
         newcolor = 0;
       }
@@ -990,7 +996,7 @@ void squaresSoundHMTL(Square *squares, int size, pattern_args_t *arg) {
 
     byte heat = total > 15 ? 255 : total * total;
 
-    squares[CUBE_TOP].setColor(pixel_heat(heat));
+    squares[CUBE_TOP].setColor(heat_palette.pixel(heat));
     DEBUG5_VALUE(" avg:", total);
     DEBUG_PRINT_END();
 
@@ -1141,3 +1147,45 @@ void squaresStrobe(Square *squares, int size,
 #endif    
   }
 }
+
+/*
+ * Ripples spreading from touches or random LEDs
+ */
+byte ripple_distances[RIPPLE_MAX * NUM_SQUARES * Square::NUM_LEDS];
+Ripples ripples;
+
+#define RIPPLES_SPLASH 0
+void squaresRipples(Square *squares, int size, pattern_args_t *arg) {
+  unsigned long now = millis();
+
+  if (arg->next_time == 0) {
+    arg->next_time = now;
+    arg->data.u32s[RIPPLES_SPLASH] = 0;
+
+    ripples = Ripples(squareLedNeighbor, size * Square::NUM_LEDS,
+                      ripple_distances, 150, 2, 1500);
+    setAllSquares(squares, size, arg->bgColor);
+  }
+
+  if (CHECK_TAP_1() || CHECK_TAP_2() ||
+      (now - arg->data.u32s[RIPPLES_SPLASH] > 3000)) {
+    geo_led_t led = random(size * Square::NUM_LEDS);
+    ripples.splash(led, wheel_palette.color(random(256)), now);
+    arg->data.u32s[RIPPLES_SPLASH] = now;
+  }
+
+  if (now > arg->next_time) {
+    arg->next_time += arg->periodms;
+
+    ripples.update(now);
+
+    geo_led_t led = 0;
+    CRGB bg = arg->bgColor;
+    for (byte face = 0; face < size; face++) {
+      for (byte l = 0; l < Square::NUM_LEDS; l++) {
+        CRGB color = bg + ripples.color(led++);
+        squares[face].setColor(l, color.r, color.g, color.b);
+      }
+    }
+  }
+}
@@ -15,18 +15,33 @@
 #define CUBE_NUMBER ADAM_CUBE
 #endif
 
-#define CUBE_VERSION 1
+/*
+ * Version history:
+ *   1 - Initial version
+ *   2 - Squares include the position of their center
+ *   3 - Cube config includes the LED calibration and power budget
+ */
+#define CUBE_VERSION 3
 
 // Touch sensor trigger and release values
 #if CUBE_NUMBER == BIG_CUBE
 #warning CUBE_NUMBER IS SET TO BIG_CUBE!!!
   #define CAP_SENSOR_1 11
   #define CAP_SENSOR_2 9
+
+  #define CAP_NUM_DEVICES 2
+  #define CAP_IRQ_PIN_2   5    // IRQ of the second MPR121, polled
+  #define CAP_ADDRESS_2   0x5B // ADD=VCC
 #else
   #define CAP_SENSOR_1 0
   #define CAP_SENSOR_2 1
+
+  #define CAP_NUM_DEVICES 1
 #endif
 
+// Electrodes are numbered device * MPR121::MAX_SENSORS + electrode
+#define CAP_NUM_ELECTRODES (CAP_NUM_DEVICES * 12)
+
 // Some pixel strands may need to start after the initial LED
 #if CUBE_NUMBER == ADAM_CUBE
   #define FIRST_LED 1
@@ -69,6 +69,9 @@ void readHMTLConfiguration(config_hdr_t *config,
 
   /* Read in the CubeLight specific configuration */
   offset = readCubeConfiguration(squares, NUM_SQUARES, offset);
+
+  /* Cache the LED neighbors now that the edges are known */
+  buildSquareSteps(squares, NUM_SQUARES);
 }
 
 /*
@@ -81,7 +84,16 @@ int readCubeConfiguration(Square *squares, int numSquares, int offset) {
   offset = EEPROM_safe_read(offset, bytes, CONFIG_BUFFER_SZ);
   cube_config_t *config = (cube_config_t *)bytes;
   DEBUG2_VALUE("Read version=", config->version);
-  // XXX - What to do with config?
+
+  // Earlier versions didn't clear the reserved bytes
+  if (config->version >= 3) {
+    squareCalibration.set(&config->calibration);
+    squarePower.setBudget(config->power_budget_ma);
+  }
+
+  // Squares written before version 2 don't include their centers
+  int recordSize = (config->version >= 2) ? CONFIG_BUFFER_SZ
+                                          : SQUARE_CONFIG_V1_SZ;
 
   // Read all squares and initialize them
   for (int face = 0; face < numSquares; face++) {
@@ -90,7 +102,7 @@ int readCubeConfiguration(Square *squares, int numSquares, int offset) {
       DEBUG_ERR("Failed to read squares data");
       break;
     }
-    squares[face].fromBytes(bytes, CONFIG_BUFFER_SZ, squares, numSquares);
+    squares[face].fromBytes(bytes, recordSize, squares, numSquares);
 
     DEBUG2_VALUE("face=", face);
     DEBUG2_VALUE(" offset=", offset);
@@ -109,8 +121,11 @@ int writeCubeConfiguration(Square *squares, int numSquares, int offset) {
   byte bytes[CONFIG_BUFFER_SZ];
 
   // Write the overall configuration
+  memset(bytes, 0, sizeof (cube_config_t));
   cube_config_t *config = (cube_config_t *)bytes;
   config->version = CUBE_VERSION;
+  config->calibration = *squareCalibration.get();
+  config->power_budget_ma = squarePower.getBudget();
   offset = EEPROM_safe_write(offset, bytes, sizeof (cube_config_t));
 
   // Write square info
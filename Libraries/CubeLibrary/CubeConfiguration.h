@@ -11,10 +11,13 @@
 
 typedef struct {
   byte version;
-  byte reserved[7];
+  color_calibration_t calibration; // Only valid from version 3
+  uint16_t power_budget_ma;        // Only valid from version 3
+  byte reserved[1];
 } cube_config_t;
 
 #define CONFIG_BUFFER_SZ 32 // Buffer size for reading and writing configs
+#define SQUARE_CONFIG_V1_SZ 14 // Size of a square's config before version 2
 
 void readHMTLConfiguration(config_hdr_t *config, 
                            output_hdr_t *outputs[],
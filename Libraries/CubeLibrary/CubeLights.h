@@ -8,6 +8,8 @@
 
 #include "RS485Utils.h"
 #include "MPR121.h"
+#include "TouchEvents.h"
+#include "MessageRing.h"
 
 #include "HMTLMessaging.h"
 
@@ -52,12 +54,12 @@ extern uint32_t sensor_state;
 #define SENSE_TOUCH_1     0x00000001
 #define SENSE_CHANGE_1    0x00000002
 #define SENSE_DOUBLE_1    0x00000004
-#define SENSE_LONG_1      0x00000008 // XXX - Need to implement
+#define SENSE_LONG_1      0x00000008
 
 #define SENSE_TOUCH_2     0x00000010
 #define SENSE_CHANGE_2    0x00000020
 #define SENSE_DOUBLE_2    0x00000040
-#define SENSE_LONG_2      0x00000080 // XXX - Need to implement
+#define SENSE_LONG_2      0x00000080
 
 #define SENSE_DOUBLE_BOTH 0x01000000 // XXX - Can these be just combos?
 #define SENSE_LONG_BOTH   0x02000000 // XXX - Can these be just combos?
@@ -65,9 +67,11 @@ extern uint32_t sensor_state;
 #define SENSE_RANGE_SHORT 0x10000000
 #define SENSE_RANGE_MID   0x20000000
 #define SENSE_RANGE_LONG  0x40000000
+#define SENSE_RANGE_CHANGE 0x80000000
 
 #define SENSE_TOUCH_ALL   0x00000011
 #define SENSE_CHANGE_ALL  0x00000022
+#define SENSE_RANGE_ALL   0x70000000
 
 #define CHECK_TOUCH_1()     (sensor_state & SENSE_TOUCH_1)
 #define CHECK_CHANGE_1()    (sensor_state & SENSE_CHANGE_1)
@@ -87,6 +91,7 @@ extern uint32_t sensor_state;
 #define CHECK_RANGE_SHORT() (sensor_state & SENSE_RANGE_SHORT)
 #define CHECK_RANGE_MID()   (sensor_state & SENSE_RANGE_MID)
 #define CHECK_RANGE_LONG()  (sensor_state & SENSE_RANGE_LONG)
+#define CHECK_RANGE_CHANGE() (sensor_state & SENSE_RANGE_CHANGE)
 #define CHECK_RANGE_MAX()   (sensor_state & SENSE_RANGE_MASENSOR_STATE)
 
 #define CHECK_TOUCH_BOTH()  ((sensor_state & SENSE_TOUCH_ALL) == SENSE_TOUCH_ALL)
@@ -113,10 +118,10 @@ void handle_sensors();
 #define PING_MID_CM   50
 #define PING_MAX_CM 100   /* Maximum distance in cm, limits the sensor delay */
 
-#define PING_DELAY_MS 250 /* Minimum time between readings */
+#define PING_DELAY_MS 50  /* Time between pings, must allow echoes to fade */
 
-extern int range_cm; /* Last value of the range finger */
-void sensor_range(void);  /* Update the range finder value */
+extern int range_cm; /* Median of the recent range finder values */
+void sensor_range(void);  /* Start pings and collect their results */
 
 /***** Photo sensor *****/
 #define PHOTO_PIN A0
@@ -126,16 +131,34 @@ void sensor_range(void);  /* Update the range finder value */
 
 extern uint16_t photo_value; /* Last value of the photo sensor */
 extern boolean photo_dark;   /* If its "dark" based on threshold values */
+void sensor_photo_init(void); /* Start reading the sensor in the background */
 void sensor_photo(void);     /* Update the photo sensor values */
 
 /***** Capacitive side sensors *****/
 extern MPR121 touch_sensor;
 
-#define CAP_DELAY_MS 250    /* Minimum time between readings */
+#define CAP_IRQ_PIN       2 /* MPR121 IRQ line, pulled low on a change */
+#define CAP_IRQ_INTERRUPT 0 /* External interrupt for CAP_IRQ_PIN */
+
 #define CAP_DOUBLE_MS 750   /* Max milliseconds for a double-tap */
+#define CAP_LONG_MS   750   /* Min milliseconds for a long touch */
+
+#define CAP_SWIPE_MS  250   /* Max milliseconds between pads in a swipe */
+
+extern TouchEventQueue touch_events; /* Changes not yet handled */
+extern TouchGestures touch_gestures;
 void sensor_cap_init(void);
 void sensor_cap(void);
 
+/*
+ * Gestures (TOUCH_* from TouchEvents.h) completed during the current loop,
+ * for the sensor modes to act on any of the electrodes.
+ */
+#define CAP_MAX_GESTURES 8
+extern touch_gesture_t sensor_gestures[];
+extern byte num_sensor_gestures;
+byte check_gestures(byte electrode); /* All gestures of one electrode */
+
 
 /* Sensor modes */
 typedef void (*sensor_mode_t)(boolean entered, boolean exited);
@@ -154,17 +177,30 @@ void initializeConnect();
 void sendByte(byte value, byte address);
 void sendInt(int value, byte address);
 void sendLong(long value, byte address);
-void sendHMTLValue(uint16_t address, uint8_t offset, int value);
-void sendHMTLBlink(uint16_t address, uint8_t output,
-		   uint16_t on_period, uint32_t on_color,
-		   uint16_t off_period, uint32_t off_color);
-void sendHMTLTimedChange(uint16_t address, uint8_t output,
-			 uint32_t change_period,
-			 uint32_t start_color, uint32_t stop_color);
-void sendHMTLSensorRequest(uint16_t address);
+/*
+ * HMTL commands, which return false if the command couldn't be formatted or
+ * didn't fit in the open batch.  Between beginHMTLBatch() and sendHMTLBatch()
+ * they are collected and sent as a single message.
+ */
+void beginHMTLBatch();
+boolean sendHMTLBatch();
+boolean sendHMTLValue(uint16_t address, uint8_t offset, int value);
+boolean sendHMTLBlink(uint16_t address, uint8_t output,
+		      uint16_t on_period, uint32_t on_color,
+		      uint16_t off_period, uint32_t off_color);
+boolean sendHMTLTimedChange(uint16_t address, uint8_t output,
+			    uint32_t change_period,
+			    uint32_t start_color, uint32_t stop_color);
+boolean sendHMTLSensorRequest(uint16_t address);
 
 extern unsigned long sensor_check_time;
 extern msg_hdr_t *sensor_msg;
+
+/* Messages received this loop, released at the start of the next */
+extern MessageRing recv_ring;
+extern message_view_t recv_views[];
+extern byte recv_count;
+boolean is_hmtl_msg(const byte *data, uint16_t length);
 void handle_messages();
 
 /***** Cube light modes *******************************************************/
@@ -224,6 +260,7 @@ extern uint16_t followupPeriods[];
 #define MODE_SOUND_TEST     17
 #define MODE_SOUND_HMTL     18
 #define MODE_STROBE         19
+#define MODE_RIPPLES        20
 
 void squaresTestPattern(Square *squares, int size, pattern_args_t *arg);
 void squaresSetupPattern(Square *squares, int size, pattern_args_t *arg);
@@ -243,6 +280,7 @@ void squaresSimpleLife(Square *squares, int size, pattern_args_t *arg);
 void squaresSoundTest(Square *squares, int size, pattern_args_t *arg);
 void squaresSoundHMTL(Square *squares, int size, pattern_args_t *arg);
 void squaresStrobe(Square *squares, int size, pattern_args_t *arg);
+void squaresRipples(Square *squares, int size, pattern_args_t *arg);
 
 
 void squaresLightCenter(Square *squares, int size, pattern_args_t *arg);
@@ -4,11 +4,28 @@
 #include "Debug.h"
 
 #include "PixelUtil.h"
+#include "Spatial.h"
 #include "SquareStructure.h"
 
 // XXX: Relying on an array allocated by the main sketch feels icky
 extern Square *squares;
 
+ColorCalibration squareCalibration;
+PowerGovernor squarePower;
+
+/*
+ * Precomputed result of stepping from every LED in every direction, see
+ * buildSquareSteps().  Each entry packs the global index of the next LED in
+ * the upper bits and the direction of travel after the step in the lower two.
+ */
+#define STEP_PACK(led, direction) ((led) << 2 | (direction))
+#define STEP_LED(step)            ((step) >> 2)
+#define STEP_DIRECTION(step)      ((step) & 0x3)
+#define STEP_NONE                 0xFF
+
+byte square_steps[SQUARE_STEP_FACES * Square::NUM_LEDS][Square::NUM_EDGES];
+boolean square_steps_valid = false;
+
 
 Square::Square(unsigned int _id) {
   updated = false;
@@ -25,6 +42,8 @@ Square::Square(unsigned int _id) {
     }
   }
 
+  setCenter(GEO_NO_COORD, GEO_NO_COORD, GEO_NO_COORD);
+
   DEBUG3_VALUELN("Created Square ", id);
 }
 
@@ -35,6 +54,7 @@ Square *Square::getEdge(byte edge) {
 
 void Square::setEdge(byte edge, Square *square) {
   edges[edge] = square->id;
+  square_steps_valid = false;
 }
 
 Square *Square::getVertex(byte vertex, byte index) {
@@ -378,6 +398,21 @@ byte Square::ledInDirection(byte led, byte direction) {
  * Returns the square and led in a given direction from a led in this square
  */
 uint16_t Square::ledTowards(byte led, byte direction) {
+  if (square_steps_valid) {
+    byte step = square_steps[id * NUM_LEDS + led][direction];
+    if (step == STEP_NONE) return FACE_AND_LED(id, NO_LED);
+    return FACE_AND_LED(STEP_LED(step) / NUM_LEDS, STEP_LED(step) % NUM_LEDS);
+  }
+
+  return walkTowards(led, direction, NULL);
+}
+
+/*
+ * Walk the geometry to find the square and led in a given direction from a
+ * led in this square.  If new_direction is set it will be updated with the
+ * direction of travel on the square that was stepped onto.
+ */
+uint16_t Square::walkTowards(byte led, byte direction, byte *new_direction) {
   /*
    * Get LED in the appropriate direction, which will also detect if the led
    * is the last in that direction.
@@ -390,6 +425,9 @@ uint16_t Square::ledTowards(byte led, byte direction) {
    */
   Square *next_square = getEdge(direction);
   next_led = next_square->matchLED(this, led);
+  if (new_direction != NULL) {
+    *new_direction = REV_DIRECTION(next_square->matchEdge(this));
+  }
   return FACE_AND_LED(next_square->id, next_led);
 }
 
@@ -413,6 +451,35 @@ uint16_t Square::ledAwayFrom(Square *square, byte led) {
 
 
 
+/*
+ * Return the approximate position of an LED.  The LEDs are in a 3x3 grid
+ * across the face, so this offsets the center of the square by a third of the
+ * distance between the centers of the squares on opposite edges.
+ */
+geo_point_t Square::ledPoint(byte led) {
+  geo_point_t point = center;
+
+  for (byte axis = 0; axis < 2; axis++) {
+    /* Columns are offset towards the right edge, rows to the bottom */
+    byte toward = (axis == 0) ? RIGHT : BOTTOM;
+    byte away = (axis == 0) ? LEFT : TOP;
+    int8_t offset = (axis == 0) ? (led % SQUARE_LED_COLS) - 1
+                                : (led / SQUARE_LED_COLS) - 1;
+    if ((offset == 0) || (edges[toward] == NO_ID) || (edges[away] == NO_ID))
+      continue;
+
+    Square *a = getEdge(toward);
+    Square *b = getEdge(away);
+    if (!a->hasCenter() || !b->hasCenter()) continue;
+
+    point.x += offset * ((int16_t)a->center.x - b->center.x) / 3;
+    point.y += offset * ((int16_t)a->center.y - b->center.y) / 3;
+    point.z += offset * ((int16_t)a->center.z - b->center.z) / 3;
+  }
+
+  return point;
+}
+
 /******************************************************************************
  * Serialization functions
  *
@@ -420,8 +487,9 @@ uint16_t Square::ledAwayFrom(Square *square, byte led) {
  *   ID             1B
  *   IDs of edges   4B
  *   pixels         9B
+ *   center         3B (version 2+)
  *   ------------  ---
- *   Total         14B 
+ *   Total         17B 
  */
 int Square::toBytes(byte *bytes, int size) {
   int i = 0;
@@ -439,6 +507,11 @@ int Square::toBytes(byte *bytes, int size) {
     bytes[i++] = leds[led].pixel;
   }
 
+  // Write out the center
+  bytes[i++] = center.x;
+  bytes[i++] = center.y;
+  bytes[i++] = center.z;
+
   return i;
 }
 
@@ -454,11 +527,17 @@ void Square::fromBytes(byte *bytes, int size, Geometry *squares,
     int id = bytes[i++];
     edges[face] = id;
   }
+  square_steps_valid = false;
 
   // Read the pixel values
   for (int led = 0; led < NUM_LEDS; led++ ) {
     leds[led].pixel = bytes[i++];
   }
+
+  // Older configurations don't include the center
+  if (size >= i + 3) {
+    setCenter(bytes[i], bytes[i + 1], bytes[i + 2]);
+  }
 }
 
 void Square::print() {
@@ -468,6 +547,85 @@ void Square::print() {
 }
 
 
+/*
+ * Precompute the step from every LED in every direction so that ledTowards()
+ * and squareStep() don't need to walk the edges.  This must be called again
+ * after the edges are changed, until then the slower lookups are used.
+ */
+void buildSquareSteps(Square *squares, int numSquares) {
+  if (numSquares > SQUARE_STEP_FACES) {
+    DEBUG_ERR("buildSquareSteps: too many squares");
+    return;
+  }
+
+  square_steps_valid = false;
+
+  for (int face = 0; face < numSquares; face++) {
+    for (byte led = 0; led < Square::NUM_LEDS; led++) {
+      for (byte direction = 0; direction < Square::NUM_EDGES; direction++) {
+        byte *step = &square_steps[face * Square::NUM_LEDS + led][direction];
+        if ((squares[face].ledInDirection(led, direction) == Square::NO_LED) &&
+            (squares[face].edges[direction] == Square::NO_ID)) {
+          *step = STEP_NONE;
+          continue;
+        }
+
+        byte next_direction = direction;
+        uint16_t next = squares[face].walkTowards(led, direction,
+                                                  &next_direction);
+        *step = STEP_PACK(FACE_FROM_COMBO(next) * Square::NUM_LEDS +
+                          LED_FROM_COMBO(next), next_direction);
+      }
+    }
+  }
+
+  square_steps_valid = true;
+}
+
+/*
+ * Step from an LED in the given direction, updating the direction when the
+ * step crosses onto another square.
+ */
+uint16_t squareStep(uint16_t faceled, byte *direction) {
+  Square *face = &squares[FACE_FROM_COMBO(faceled)];
+  byte led = LED_FROM_COMBO(faceled);
+
+  if (square_steps_valid) {
+    byte step = square_steps[face->id * Square::NUM_LEDS + led][*direction];
+    if (step == STEP_NONE) return FACE_AND_LED(face->id, Square::NO_LED);
+    *direction = STEP_DIRECTION(step);
+    return FACE_AND_LED(STEP_LED(step) / Square::NUM_LEDS,
+                        STEP_LED(step) % Square::NUM_LEDS);
+  }
+
+  return face->walkTowards(led, *direction, direction);
+}
+
+/*
+ * Return the LED in each direction from an LED indexed as
+ * square * Square::NUM_LEDS + led.
+ */
+geo_led_t squareLedNeighbor(geo_led_t led, byte direction) {
+  uint16_t next = squares[led / Square::NUM_LEDS].ledTowards(
+          led % Square::NUM_LEDS, direction);
+  if (LED_FROM_COMBO(next) >= Square::NUM_LEDS) return Square::NO_LED;
+  return FACE_FROM_COMBO(next) * Square::NUM_LEDS + LED_FROM_COMBO(next);
+}
+
+/*
+ * Fill a lookup table with a projection of every LED's position, indexed by
+ * square * Square::NUM_LEDS + led.
+ */
+void buildSquareLUT(Square *squares, int numSquares,
+                    byte projection, geo_point_t origin, byte *lut) {
+  for (int face = 0; face < numSquares; face++) {
+    for (byte led = 0; led < Square::NUM_LEDS; led++) {
+      lut[face * Square::NUM_LEDS + led] =
+              spatialProject(squares[face].ledPoint(led), projection, origin);
+    }
+  }
+}
+
 /* Send updated values to a Pixel chain */
 void updateSquarePixels(Square *squares, int numSquares,
 			  PixelUtil *pixels) {
@@ -477,14 +635,18 @@ void updateSquarePixels(Square *squares, int numSquares,
     if (squares[tri].updated) {
       update = true;
       for (byte led = 0; led < Square::NUM_LEDS; led++) {
-	pixels->setPixelRGB(&(squares[tri].leds[led]));
+	PRGB *rgb = &(squares[tri].leds[led]);
+	uint32_t previous = pixels->getColor(rgb->pixel);
+	squareCalibration.setPixel(pixels, rgb);
+	squarePower.change(previous, pixels->getColor(rgb->pixel));
       }
       squares[tri].updated = false;
       updated++;
     }
   }
 
-  if (update) {
+  /* A change of brightness must be sent even if no square changed */
+  if (squarePower.apply() || update) {
     pixels->update();
     DEBUG5_VALUELN("Updated squares:", updated);
   }
@@ -512,7 +674,17 @@ void makeEdge(Square *squares, int tri, int edge, int neighbor) {
  * | 5 |
  * +---+
  *
+ * The centers have x towards the right face, y towards the back face, and z
+ * towards the top.
  */
+const int8_t cubeCenters[6][3] PROGMEM = {
+  {   0, -90,   0 }, // CUBE_FRONT
+  {  90,   0,   0 }, // CUBE_RIGHT
+  {   0,  90,   0 }, // CUBE_BACK
+  { -90,   0,   0 }, // CUBE_LEFT
+  {   0,   0,  90 }, // CUBE_TOP
+  {   0,   0, -90 }, // CUBE_BOTTOM
+};
 
 
 Square squareArray[6];
@@ -523,6 +695,11 @@ Square* buildCube(int *numSquares, int numLeds, int firstLed) {
 
   int led = firstLed;
 
+  // Edges are stored as the neighbor's id, so set every id before linking
+  for (int face = 0; face < squareCount; face++) {
+    squares[face].id = face;
+  }
+
   // XXX: Build topology
   *numSquares = 0;
   makeEdge(squares, 0, Square::TOP,    4);
@@ -589,5 +766,11 @@ Square* buildCube(int *numSquares, int numLeds, int firstLed) {
   if (*numSquares == squareCount) goto CUBE_DONE;
 
  CUBE_DONE:
+  for (int face = 0; face < *numSquares; face++) {
+    squares[face].setCenter((int8_t)pgm_read_byte(&cubeCenters[face][0]),
+                            (int8_t)pgm_read_byte(&cubeCenters[face][1]),
+                            (int8_t)pgm_read_byte(&cubeCenters[face][2]));
+  }
+
   return squares;
 }
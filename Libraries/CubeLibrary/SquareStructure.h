@@ -22,6 +22,7 @@
 
 #include "PixelUtil.h"
 #include "Geometry.h"
+#include "PowerGovernor.h"
 
 class Square : public Geometry {
  public:
@@ -87,6 +88,9 @@ class Square : public Geometry {
 
   uint16_t ledAwayFrom(Square *square, byte led);
   uint16_t ledTowards(byte led, byte direction);
+  uint16_t walkTowards(byte led, byte direction, byte *new_direction);
+
+  geo_point_t ledPoint(byte led);
 
   void print();
 
@@ -105,12 +109,41 @@ class Square : public Geometry {
  protected:
   byte edges[NUM_EDGES];
   byte vertices[NUM_VERTICES][VERTEX_ORDER];
+
+  friend void buildSquareSteps(Square *squares, int numSquares);
 };
 
+/* Calibration applied as square colors are copied to the pixels */
+extern ColorCalibration squareCalibration;
+
+/* Limit on the current drawn by the squares' pixels */
+extern PowerGovernor squarePower;
+
 /* Send updated values to a Pixel chain */
 void updateSquarePixels(Square *squares, int numSquares,
 			  PixelUtil *pixels);
 
+/*
+ * Precompute the neighbor of every LED in every direction, which is then used
+ * by ledTowards(), ledAwayFrom() and squareStep().  Call once the edges are
+ * configured.
+ */
+#define SQUARE_STEP_FACES 6
+void buildSquareSteps(Square *squares, int numSquares);
+
+/*
+ * Step from a FACE_AND_LED in a direction, updating the direction to the
+ * direction of travel on the new face if the step crosses an edge.
+ */
+uint16_t squareStep(uint16_t faceled, byte *direction);
+
+/* Neighbors of an LED in the global squares, for use with LedGraph.h */
+geo_led_t squareLedNeighbor(geo_led_t led, byte direction);
+
+/* Fill a table with a spatial projection (see Spatial.h) of every LED */
+void buildSquareLUT(Square *squares, int numSquares,
+                    byte projection, geo_point_t origin, byte *lut);
+
 /* Allocate and return a fully connected cube */
 #define CUBE_FRONT  0
 #define CUBE_RIGHT  1
@@ -0,0 +1,196 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#ifndef DEBUG_LEVEL
+  #define DEBUG_LEVEL DEBUG_MID
+#endif
+#include "Debug.h"
+
+#include "AdcScan.h"
+
+AdcScan adcScan;
+
+ISR(ADC_vect) {
+  adcScan.sample(ADC);
+}
+
+/* Convert an Arduino analog pin to its ADC channel */
+static byte adc_mux(byte pin) {
+  if (pin >= A0) pin -= A0;
+  return pin & 0x07;
+}
+
+AdcScan::AdcScan() {
+  numChannels = 0;
+  rate = ADC_SCAN_FREE_RUN_HZ;
+  pipelined = true;
+  selected = ADC_SCAN_NONE;
+  converting = ADC_SCAN_NONE;
+  burstChannel = ADC_SCAN_NONE;
+  burstRemaining = 0;
+  captureBuffer = NULL;
+  captureLength = 0;
+  captureStarted = 0;
+  captureDone = 0;
+}
+
+void AdcScan::begin(byte _reference, byte trigger) {
+  reference = _reference;
+
+  /*
+   * When free running the next conversion starts as soon as one completes,
+   * so the input chosen by the interrupt is used for the conversion after.
+   * A Timer0 trigger only starts it on the next overflow.
+   */
+  if (trigger == ADC_SCAN_TIMER0) {
+    rate = ADC_SCAN_TIMER0_HZ;
+    pipelined = false;
+    ADCSRB = _BV(ADTS2);           // Timer/Counter0 overflow
+  } else {
+    rate = ADC_SCAN_FREE_RUN_HZ;
+    pipelined = true;
+    ADCSRB = 0;                    // Free running
+  }
+
+  ADMUX = reference;
+  ADCSRA = _BV(ADEN)  |            // ADC enable
+           _BV(ADSC)  |            // ADC start
+           _BV(ADATE) |            // Auto trigger
+           _BV(ADIE)  |            // Interrupt enable
+           _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0); // 128:1
+
+  DEBUG3_VALUELN("ADC scan hz:", rate);
+}
+
+byte AdcScan::add(byte pin, uint16_t rate_hz, byte shift) {
+  if (numChannels >= ADC_SCAN_MAX_CHANNELS) {
+    DEBUG1_PRINTLN("ADC scan: too many channels");
+    return ADC_SCAN_NONE;
+  }
+  if (shift > 6) shift = 6;
+
+  adc_channel_t channel;
+  channel.mux = adc_mux(pin);
+  channel.shift = shift;
+  channel.interval = (rate_hz > 0) ? rate / rate_hz : 0;
+  channel.wait = 0;
+  channel.sum = 0;
+  channel.count = 0;
+  channel.value = 0;
+  channel.sequence = 0;
+
+  DIDR0 |= _BV(channel.mux);       // Turn off the pin's digital input
+
+  noInterrupts();
+  channels[numChannels] = channel;
+  numChannels++;
+  interrupts();
+
+  DEBUG3_VALUE("ADC scan mux:", channel.mux);
+  DEBUG3_VALUELN(" interval:", channel.interval);
+  return numChannels - 1;
+}
+
+uint16_t AdcScan::value(byte handle) {
+  adc_channel_t *channel = &channels[handle];
+
+  /* Read again if a new reading was published during the read */
+  byte sequence;
+  uint16_t result;
+  do {
+    sequence = channel->sequence;
+    result = channel->value;
+  } while (sequence != channel->sequence);
+
+  return result;
+}
+
+boolean AdcScan::updated(byte handle, byte *sequence) {
+  byte current = channels[handle].sequence;
+  if (current == *sequence) return false;
+  *sequence = current;
+  return true;
+}
+
+void AdcScan::capture(byte pin, int16_t *buffer, uint16_t length) {
+  noInterrupts();
+  captureBuffer = buffer;
+  captureMux = adc_mux(pin);
+  captureStarted = 0;
+  captureDone = 0;
+  captureLength = length;
+  interrupts();
+}
+
+void AdcScan::select(byte input) {
+  selected = input;
+
+  byte mux;
+  if (input == ADC_SCAN_CAPTURE) mux = captureMux;
+  else if (input < numChannels) mux = channels[input].mux;
+  else return;
+
+  ADMUX = reference | mux;
+}
+
+/* Choose the input for the next conversion to start */
+byte AdcScan::schedule() {
+  if (captureStarted < captureLength) {
+    captureStarted++;
+    return ADC_SCAN_CAPTURE;
+  }
+
+  if (burstRemaining > 0) {
+    burstRemaining--;
+    return burstChannel;
+  }
+
+  /* Start after the last channel read so that every channel gets a turn */
+  byte i = burstChannel;
+  for (byte checked = 0; checked < numChannels; checked++) {
+    i = (i + 1 < numChannels) ? i + 1 : 0;
+    adc_channel_t *channel = &channels[i];
+    if ((channel->interval > 0) && (channel->wait == 0)) {
+      channel->wait = channel->interval;
+      burstChannel = i;
+      burstRemaining = (1 << channel->shift) - 1;
+      return i;
+    }
+  }
+
+  return ADC_SCAN_NONE;
+}
+
+void AdcScan::sample(uint16_t value) {
+  byte input = converting;
+  if (pipelined) converting = selected;
+
+  if (input == ADC_SCAN_CAPTURE) {
+    if (captureDone < captureLength) {
+      captureBuffer[captureDone] = value;
+      captureDone++;
+    }
+  } else if (input < numChannels) {
+    adc_channel_t *channel = &channels[input];
+    channel->sum += value;
+    if (++channel->count >= (1 << channel->shift)) {
+      channel->value = channel->sum >> channel->shift;
+      channel->sequence++;
+      channel->sum = 0;
+      channel->count = 0;
+    }
+  }
+
+  for (byte i = 0; i < numChannels; i++) {
+    if (channels[i].wait > 0) channels[i].wait--;
+  }
+
+  byte next = schedule();
+  select(next);
+  if (!pipelined) converting = next;
+}
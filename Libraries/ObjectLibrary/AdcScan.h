@@ -0,0 +1,112 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Background sampling of the analog inputs.
+ *
+ * The scanner owns the ADC and its interrupt.  Conversions are triggered
+ * continuously, either free running at ~9.6kHz or on each Timer0 overflow at
+ * ~1kHz, and the interrupt assigns each conversion to an input:
+ *
+ *  - A capture takes consecutive samples of one input into a buffer, for
+ *    signals such as audio that need an even sample rate.  It has priority
+ *    over everything else until the buffer is full.
+ *  - Each scanned input is read at its own rate, averaging a burst of
+ *    samples into each reading.
+ *
+ * The main loop never waits on a conversion.  Readings are published with a
+ * sequence number so that they can be read without disabling interrupts.
+ ******************************************************************************/
+
+#ifndef ADCSCAN_H
+#define ADCSCAN_H
+
+#include <Arduino.h>
+
+#define ADC_SCAN_MAX_CHANNELS 4
+
+/* Voltage references */
+#define ADC_SCAN_AREF 0            // External AREF pin
+#define ADC_SCAN_AVCC _BV(REFS0)   // AVcc, as used by analogRead()
+
+/* Conversion triggers and the resulting conversions per second */
+#define ADC_SCAN_FREE_RUN 0
+#define ADC_SCAN_TIMER0   1
+#define ADC_SCAN_FREE_RUN_HZ 9615  // 16MHz / 128 / 13 cycles
+#define ADC_SCAN_TIMER0_HZ   976   // 16MHz / 64 / 256
+
+#define ADC_SCAN_NONE    0xFF      // Conversion that isn't used
+#define ADC_SCAN_CAPTURE 0xFE      // Conversion for the capture buffer
+
+typedef struct {
+  byte mux;                  // ADC input
+  byte shift;                // Log2 of the samples averaged per reading
+  uint16_t interval;         // Conversions between readings
+  uint16_t wait;             // Conversions until the next reading
+
+  uint16_t sum;              // Samples of the reading in progress
+  byte count;
+
+  volatile uint16_t value;   // Last reading
+  volatile byte sequence;    // Incremented after each new reading
+} adc_channel_t;
+
+class AdcScan {
+ public:
+  AdcScan();
+
+  /*
+   * Take over the ADC with a reference and trigger.  Inputs should be added
+   * after this, and analogRead() can't be used once the scan is running.
+   */
+  void begin(byte reference, byte trigger);
+
+  /*
+   * Scan an input (a channel number or A0-A7) rate_hz times a second,
+   * averaging 2^shift samples for each reading, up to 64.  Returns the
+   * channel's handle.
+   */
+  byte add(byte pin, uint16_t rate_hz, byte shift);
+
+  /* Latest reading of a channel, 0 until the first */
+  uint16_t value(byte handle);
+
+  /* Returns true if there is a reading newer than *sequence and updates it */
+  boolean updated(byte handle, byte *sequence);
+
+  /* Start capturing length samples of an input into buffer */
+  void capture(byte pin, int16_t *buffer, uint16_t length);
+
+  /* Returns true once the capture buffer is full */
+  boolean captured() { return captureDone >= captureLength; }
+
+  /* Called from the ADC interrupt with each conversion */
+  void sample(uint16_t value);
+
+ private:
+  adc_channel_t channels[ADC_SCAN_MAX_CHANNELS];
+  byte numChannels;
+  byte reference;
+  uint16_t rate;
+  boolean pipelined;   // The next conversion starts before the interrupt
+
+  volatile byte selected;   // Input the ADC is set to
+  volatile byte converting; // Input of the conversion in progress
+  byte burstChannel;        // Channel being read
+  byte burstRemaining;      // Samples of its reading left to start
+
+  int16_t *captureBuffer;
+  byte captureMux;
+  volatile uint16_t captureLength;
+  volatile uint16_t captureStarted;
+  volatile uint16_t captureDone;
+
+  void select(byte input);
+  byte schedule();
+};
+
+/* The scanner, there is only the one ADC */
+extern AdcScan adcScan;
+
+#endif
@@ -0,0 +1,65 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+#ifndef DEBUG_LEVEL
+  #define DEBUG_LEVEL DEBUG_MID
+#endif
+#include "Debug.h"
+
+#include "Animation.h"
+
+Animation::Animation(const byte *data) {
+  hdr = (const animation_hdr_t *)data;
+  palette = data + sizeof (animation_hdr_t);
+
+  uint16_t colors = pgm_read_byte(&hdr->paletteSize);
+  if (colors == 0) colors = 256;
+  frames = palette + colors * 3;
+
+  restart();
+
+  DEBUG4_VALUE("Animation leds:", numLeds());
+  DEBUG4_VALUELN(" frames:", numFrames());
+}
+
+void Animation::restart() {
+  pos = frames;
+  current = 0;
+}
+
+void Animation::frame(led_set_color_t set, geo_led_t maxLeds) {
+  if (current >= numFrames()) restart();
+
+  uint16_t total = numLeds();
+  const byte *data = pos;
+  uint16_t led = 0;
+
+  while (led < total) {
+    byte run = pgm_read_byte(data++);
+    uint16_t length = (run & ANIMATION_RUN_MASK) + 1;
+
+    if (run & ANIMATION_RUN) {
+      const byte *rgb = &palette[pgm_read_byte(data++) * 3];
+      CRGB color(pgm_read_byte(&rgb[0]),
+                 pgm_read_byte(&rgb[1]),
+                 pgm_read_byte(&rgb[2]));
+
+      uint16_t end = led + length;
+      if (end > maxLeds) end = (led < maxLeds) ? maxLeds : led;
+      for (uint16_t i = led; i < end; i++) {
+        set(i, color);
+      }
+    }
+
+    led += length;
+  }
+
+  pos = data;
+  current++;
+}
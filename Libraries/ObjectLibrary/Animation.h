@@ -0,0 +1,72 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Playback of animations stored in flash.
+ *
+ * An animation is a header, a palette, and then the frames.  Each frame is
+ * a sequence of runs covering every LED in order:
+ *
+ *   0nnnnnnn         - The next n+1 LEDs are unchanged from the last frame
+ *   1nnnnnnn <color> - The next n+1 LEDs are set to a palette color
+ *
+ * The first frame sets every LED so that playback can loop back to it.  The
+ * frames are decoded directly from flash into the LEDs one frame at a time,
+ * so playing an animation takes only a few bytes of RAM however long it is.
+ *
+ * Animations are written by utilities/AnimationEncoder from frames rendered
+ * by the 'g' command or from any other RGB frames.
+ ******************************************************************************/
+
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+#include "LedGraph.h"
+
+#define ANIMATION_RUN      0x80 // Run sets a color, otherwise it skips LEDs
+#define ANIMATION_RUN_MASK 0x7F // Length of the run minus one
+
+typedef struct {
+  uint16_t numLeds;
+  uint16_t numFrames;
+  uint16_t period_ms;
+  uint8_t paletteSize; // Colors in the palette, 0 for 256
+} animation_hdr_t;
+
+/* Function to set the color of an LED */
+typedef void (*led_set_color_t)(geo_led_t led, CRGB color);
+
+class Animation {
+ public:
+  Animation() {};
+
+  /* data is a PROGMEM animation */
+  Animation(const byte *data);
+
+  /*
+   * Decode the next frame, setting the color of the changed LEDs below
+   * numLeds.  After the last frame playback starts again from the first.
+   */
+  void frame(led_set_color_t set, geo_led_t numLeds);
+
+  /* Start again from the first frame */
+  void restart();
+
+  uint16_t numLeds() { return pgm_read_word(&hdr->numLeds); }
+  uint16_t numFrames() { return pgm_read_word(&hdr->numFrames); }
+  uint16_t period() { return pgm_read_word(&hdr->period_ms); }
+
+ private:
+  const animation_hdr_t *hdr;
+  const byte *palette;
+  const byte *frames;
+
+  const byte *pos;  // Start of the next frame
+  uint16_t current; // Index of the next frame
+};
+
+#endif
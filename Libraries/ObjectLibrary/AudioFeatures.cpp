@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#ifndef DEBUG_LEVEL
+  #define DEBUG_LEVEL DEBUG_MID
+#endif
+#include "Debug.h"
+
+#include "AudioFeatures.h"
+
+AudioFeatures::AudioFeatures() {
+  memset(bands, 0, sizeof (bands));
+  memset(peaks, 0, sizeof (peaks));
+  gain = AUDIO_MIN_GAIN;
+  level = 0;
+  average = 0;
+  beatCount = 0;
+  beat_ms = 0;
+  last_ms = 0;
+}
+
+void AudioFeatures::update(const uint16_t *values, byte count,
+                           unsigned long now) {
+  if (count > AUDIO_BANDS) count = AUDIO_BANDS;
+
+  /* The gain jumps up to a louder band and relaxes slowly after it */
+  uint16_t loudest = 0;
+  for (byte b = 0; b < count; b++) {
+    if (values[b] > loudest) loudest = values[b];
+  }
+  if (loudest > gain) {
+    gain = loudest;
+  } else {
+    gain -= (gain - loudest) >> 6;
+    if (gain < AUDIO_MIN_GAIN) gain = AUDIO_MIN_GAIN;
+  }
+
+  uint16_t total = 0;
+  for (byte b = 0; b < AUDIO_BANDS; b++) {
+    byte value = 0;
+    if (b < count) {
+      value = (values[b] >= gain) ? 255 : (uint32_t)values[b] * 255 / gain;
+    }
+    bands[b] = value;
+    total += value;
+
+    byte fallen = (peaks[b] > AUDIO_PEAK_FALL) ? peaks[b] - AUDIO_PEAK_FALL
+                                               : 0;
+    peaks[b] = (value > fallen) ? value : fallen;
+  }
+
+  /* Short and long term averages of the energy, a beat is a jump over both */
+  uint16_t energy = (total / AUDIO_BANDS) << 8;
+  level += ((int32_t)energy - level) >> 1;
+  average += ((int32_t)energy - average) >> 4;
+
+  if ((energy > average + (average >> 1)) && (energy > (32 << 8)) &&
+      (now - beat_ms >= AUDIO_BEAT_MIN_MS)) {
+    beatCount++;
+    beat_ms = now;
+    DEBUG4_VALUELN("Beat:", beatCount);
+  }
+
+  last_ms = now;
+}
@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Features of the sound levels reported by a sound unit.
+ *
+ * Each report of the frequency bands updates the features once, and modes
+ * read them on every frame whether or not a new report has arrived.  Band
+ * levels are scaled by an automatic gain that follows the loudest recent
+ * band, so the features span 0-255 for quiet and loud rooms alike.
+ ******************************************************************************/
+
+#ifndef AUDIOFEATURES_H
+#define AUDIOFEATURES_H
+
+#include <Arduino.h>
+
+#define AUDIO_BANDS 8
+
+#define AUDIO_MIN_GAIN     16   // Lowest band value treated as full scale
+#define AUDIO_PEAK_FALL    8    // Levels a held peak falls per report
+#define AUDIO_BEAT_MIN_MS  200  // Shortest time between beats
+#define AUDIO_TIMEOUT_MS   1000 // Time without reports before sound is off
+
+class AudioFeatures {
+ public:
+  AudioFeatures();
+
+  /* Add a report of count band values received at now */
+  void update(const uint16_t *values, byte count, unsigned long now);
+
+  /* Latest level of a band */
+  byte band(byte b) { return bands[b]; }
+
+  /* Highest recent level of a band, falling slowly */
+  byte peak(byte b) { return peaks[b]; }
+
+  /* Smoothed level over all bands */
+  byte energy() { return level >> 8; }
+
+  /* Incremented on each beat, a mode keeps the last value it saw */
+  byte beats() { return beatCount; }
+
+  /* Returns true if a beat occurred within ms of now */
+  boolean beat(unsigned long now, uint16_t ms) {
+    return (beatCount != 0) && (now - beat_ms < ms);
+  }
+
+  /* Returns true if reports are arriving */
+  boolean active(unsigned long now) {
+    return (last_ms != 0) && (now - last_ms < AUDIO_TIMEOUT_MS);
+  }
+
+ private:
+  byte bands[AUDIO_BANDS];
+  byte peaks[AUDIO_BANDS];
+  uint16_t gain;       // Band value scaled to full
+  uint16_t level;      // Smoothed energy, 8.8 fixed point
+  uint16_t average;    // Long term energy for beats, 8.8 fixed point
+  byte beatCount;
+  unsigned long beat_ms;
+  unsigned long last_ms;
+};
+
+#endif
@@ -0,0 +1,100 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+//#define DEBUG_LEVEL DEBUG_HIGH
+#include "Debug.h"
+
+#include "ClockSync.h"
+
+ClockSync::ClockSync() {
+  offset = 0;
+  latency = 0;
+  measured = false;
+  last_ping_ms = 0;
+  reference = CLOCK_SYNC_NO_ORIGIN;
+  remote = false;
+  last_beacon_ms = 0;
+}
+
+void ClockSync::setReference(uint16_t origin) {
+  /* Keep the current shared time so that nothing jumps */
+  reference = origin;
+  remote = false;
+}
+
+boolean ClockSync::hasRemoteReference(unsigned long local_ms) {
+  return remote && (local_ms - last_beacon_ms < CLOCK_SYNC_TIMEOUT_MS);
+}
+
+void ClockSync::beacon(uint16_t origin, unsigned long remote_ms,
+                       unsigned long local_ms) {
+  boolean step = (origin != reference);
+  if (step) {
+    /* The latency to a new reference has to be measured again */
+    latency = 0;
+    measured = false;
+  }
+  adjust(origin, remote_ms, local_ms, step);
+}
+
+void ClockSync::adjust(uint16_t origin, unsigned long remote_ms,
+                       unsigned long local_ms, boolean step) {
+  long delta = (long)(remote_ms + latency - ms(local_ms));
+  remote = true;
+  last_beacon_ms = local_ms;
+
+  if (step || (abs(delta) > CLOCK_SYNC_STEP_MS)) {
+    /* New reference or a large jump, take its time directly */
+    offset += delta;
+    reference = origin;
+    DEBUG4_VALUE("ClockSync: step origin:", origin);
+    DEBUG4_VALUELN(" delta:", delta);
+  } else {
+    /* Move halfway towards the reference to smooth out jitter */
+    offset += delta / 2;
+    DEBUG5_VALUELN("ClockSync: delta:", delta);
+  }
+}
+
+void ClockSync::echo(uint16_t origin, unsigned long remote_ms,
+                     uint16_t sent_ms, unsigned long local_ms) {
+  if (origin != reference) return;
+
+  uint16_t rtt = (uint16_t)local_ms - sent_ms;
+  if (rtt > CLOCK_SYNC_MAX_RTT_MS) {
+    DEBUG4_VALUELN("ClockSync: slow rtt:", rtt);
+    return;
+  }
+
+  /*
+   * The first measurement corrects the whole of the time the beacons had
+   * been behind, later ones are smoothed like the offset so that one slow
+   * answer doesn't skew it.
+   */
+  boolean step = !measured;
+  if (measured) {
+    latency = (latency + rtt / 2) / 2;
+  } else {
+    latency = rtt / 2;
+    measured = true;
+  }
+  DEBUG4_VALUELN("ClockSync: latency:", latency);
+
+  adjust(origin, remote_ms, local_ms, step);
+}
+
+boolean ClockSync::ping(unsigned long local_ms) {
+  if (!hasRemoteReference(local_ms)) return false;
+
+  /* Until there is an answer every beacon is followed by a ping */
+  if (measured && (local_ms - last_ping_ms < CLOCK_SYNC_PING_MS)) {
+    return false;
+  }
+  last_ping_ms = local_ms;
+  return true;
+}
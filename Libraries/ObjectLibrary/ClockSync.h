@@ -0,0 +1,95 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Shared clock between modules, kept in step by periodic beacons.
+ *
+ * One module at a time acts as the reference and broadcasts its clock.  The
+ * others track the offset between that clock and their own.  Small
+ * differences are smoothed over several beacons so that jitter in delivery
+ * doesn't make animations stutter, while large ones (a new reference, a
+ * module that was reset) are applied at once.
+ *
+ * The time a beacon spends in transit is measured by each of the others
+ * with a ping to the reference, which answers with its clock.  Half of the
+ * round trip, which includes any relays between them and the time the
+ * reference takes to get to the ping, is added to the reference's clock in
+ * every beacon.  Until a round trip has been measured the others run behind
+ * the reference by the time it takes to deliver a beacon.
+ ******************************************************************************/
+
+#ifndef CLOCKSYNC_H
+#define CLOCKSYNC_H
+
+#include <Arduino.h>
+
+/* The broadcast address, which no module has */
+#define CLOCK_SYNC_NO_ORIGIN 0xFFFF
+
+/* Differences larger than this are applied immediately rather than smoothed */
+#define CLOCK_SYNC_STEP_MS 100
+
+/* A remote reference that hasn't sent a beacon for this long is gone */
+#define CLOCK_SYNC_TIMEOUT_MS 15000
+
+/* Interval between measurements of the round trip to the reference */
+#define CLOCK_SYNC_PING_MS 60000
+
+/* Round trips longer than this are too uneven to estimate latency from */
+#define CLOCK_SYNC_MAX_RTT_MS 250
+
+class ClockSync {
+ public:
+  ClockSync();
+
+  /*
+   * Handle a beacon from origin with its clock at the time it was sent, and
+   * the local clock when it was received.
+   */
+  void beacon(uint16_t origin, unsigned long remote_ms,
+              unsigned long local_ms);
+
+  /*
+   * Handle the reference's answer to a ping, with its clock when it answered
+   * and the low bits of the local clock when the ping was sent.
+   */
+  void echo(uint16_t origin, unsigned long remote_ms, uint16_t sent_ms,
+            unsigned long local_ms);
+
+  /*
+   * Returns true if a ping should be sent to the reference now to measure
+   * the round trip, and counts it as sent.
+   */
+  boolean ping(unsigned long local_ms);
+
+  /* Convert a local time to the shared clock */
+  unsigned long ms(unsigned long local_ms) { return local_ms + offset; }
+
+  /* Become the reference for other modules */
+  void setReference(uint16_t origin);
+
+  boolean isReference(uint16_t origin) { return reference == origin; }
+  uint16_t getReference() { return reference; }
+
+  /* Returns true if another module is the reference and is still beaconing */
+  boolean hasRemoteReference(unsigned long local_ms);
+
+  /* Estimated time for a beacon to arrive from the reference */
+  uint16_t getLatency() { return latency; }
+
+ private:
+  /* Move towards the reference's time, all at once if step is set */
+  void adjust(uint16_t origin, unsigned long remote_ms,
+              unsigned long local_ms, boolean step);
+
+  long offset;
+  uint16_t latency;
+  boolean measured;             // Latency is from a round trip to reference
+  unsigned long last_ping_ms;
+  uint16_t reference;
+  boolean remote;
+  unsigned long last_beacon_ms; // Local time of the last beacon
+};
+
+#endif
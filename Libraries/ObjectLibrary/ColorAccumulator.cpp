@@ -0,0 +1,109 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+#ifndef DEBUG_LEVEL
+  #define DEBUG_LEVEL DEBUG_MID
+#endif
+#include "Debug.h"
+
+#include "ColorAccumulator.h"
+
+/*
+ * Dither thresholds, the 4-bit values in bit-reversed order so that each run
+ * of frames spreads its thresholds evenly over the range.  Over 16 frames an
+ * LED is compared against every threshold once.
+ */
+#define DITHER_FRAMES 16
+static const byte dither_thresholds[DITHER_FRAMES] PROGMEM = {
+        0x08, 0x88, 0x48, 0xC8, 0x28, 0xA8, 0x68, 0xE8,
+        0x18, 0x98, 0x58, 0xD8, 0x38, 0xB8, 0x78, 0xF8
+};
+
+/* Offset of each LED's place in the thresholds, coprime with DITHER_FRAMES */
+#define DITHER_LED_STEP 7
+
+ColorAccumulator::ColorAccumulator(geo_led_t _numLeds, byte *buffer) {
+  numLeds = _numLeds;
+  colors = (color16_t *)buffer;
+  frame = 0;
+
+  memset(colors, 0, numLeds * sizeof (color16_t));
+}
+
+void ColorAccumulator::set(geo_led_t led, CRGB color) {
+  colors[led].r = (uint16_t)color.r << 8;
+  colors[led].g = (uint16_t)color.g << 8;
+  colors[led].b = (uint16_t)color.b << 8;
+}
+
+void ColorAccumulator::setAll(CRGB color) {
+  for (geo_led_t led = 0; led < numLeds; led++) {
+    set(led, color);
+  }
+}
+
+static uint16_t add_channel(uint16_t value, int16_t increment) {
+  int32_t result = (int32_t)value + increment;
+  if (result < 0) return 0;
+  if (result > 0xFFFF) return 0xFFFF;
+  return result;
+}
+
+static uint16_t add_level(uint16_t value, byte level) {
+  uint32_t result = (uint32_t)value + ((uint16_t)level << 8);
+  if (result > 0xFFFF) return 0xFFFF;
+  return result;
+}
+
+void ColorAccumulator::add(geo_led_t led, CRGB color) {
+  colors[led].r = add_level(colors[led].r, color.r);
+  colors[led].g = add_level(colors[led].g, color.g);
+  colors[led].b = add_level(colors[led].b, color.b);
+}
+
+void ColorAccumulator::incrementAll(int16_t r, int16_t g, int16_t b) {
+  for (geo_led_t led = 0; led < numLeds; led++) {
+    colors[led].r = add_channel(colors[led].r, r);
+    colors[led].g = add_channel(colors[led].g, g);
+    colors[led].b = add_channel(colors[led].b, b);
+  }
+}
+
+void ColorAccumulator::scaleAll(uint16_t scale) {
+  for (geo_led_t led = 0; led < numLeds; led++) {
+    colors[led].r = ((uint32_t)colors[led].r * scale) >> 16;
+    colors[led].g = ((uint32_t)colors[led].g * scale) >> 16;
+    colors[led].b = ((uint32_t)colors[led].b * scale) >> 16;
+  }
+}
+
+static uint16_t fade_channel(uint16_t value, byte target, byte amount) {
+  int32_t delta = (((int32_t)target << 8) - value) * amount;
+  return value + (delta / 256);
+}
+
+void ColorAccumulator::fadeTowards(geo_led_t led, CRGB color, byte amount) {
+  colors[led].r = fade_channel(colors[led].r, color.r, amount);
+  colors[led].g = fade_channel(colors[led].g, color.g, amount);
+  colors[led].b = fade_channel(colors[led].b, color.b, amount);
+}
+
+static byte dither_channel(uint16_t value, byte threshold) {
+  byte level = value >> 8;
+  if (((value & 0xFF) > threshold) && (level < 255)) level++;
+  return level;
+}
+
+CRGB ColorAccumulator::value(geo_led_t led) {
+  byte threshold = pgm_read_byte(
+          &dither_thresholds[(frame + led * DITHER_LED_STEP) % DITHER_FRAMES]);
+  return CRGB(dither_channel(colors[led].r, threshold),
+              dither_channel(colors[led].g, threshold),
+              dither_channel(colors[led].b, threshold));
+}
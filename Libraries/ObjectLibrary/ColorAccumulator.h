@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Colors kept with 16 bits per channel and shown with temporal dithering.
+ *
+ * Each channel is an 8.8 fixed point level, so a fade can move by fractions
+ * of a level per step instead of stalling or banding at low brightness.  When
+ * the colors are read out the fraction is compared against a threshold that
+ * changes every frame and is offset for each LED, so an LED between two 8-bit
+ * levels alternates between them in proportion to its fraction and
+ * neighboring LEDs don't flicker in step.
+ ******************************************************************************/
+
+#ifndef COLORACCUMULATOR_H
+#define COLORACCUMULATOR_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+#include "LedGraph.h"
+
+typedef struct {
+  uint16_t r;
+  uint16_t g;
+  uint16_t b;
+} color16_t;
+
+/* Bytes of buffer required for a number of LEDs */
+#define COLOR_ACCUMULATOR_BUFFER_SIZE(leds) ((leds) * sizeof (color16_t))
+
+class ColorAccumulator {
+ public:
+  ColorAccumulator() {};
+
+  /* buffer must be at least COLOR_ACCUMULATOR_BUFFER_SIZE(numLeds) bytes */
+  ColorAccumulator(geo_led_t numLeds, byte *buffer);
+
+  void set(geo_led_t led, CRGB color);
+  void setAll(CRGB color);
+
+  /* Add a color to an LED, saturating at full brightness */
+  void add(geo_led_t led, CRGB color);
+
+  /* Adjust every LED by an amount in 1/256ths of a level */
+  void incrementAll(int16_t r, int16_t g, int16_t b);
+
+  /* Scale every LED by scale/65536 */
+  void scaleAll(uint16_t scale);
+
+  /* Move an LED amount/256 of the way towards a color */
+  void fadeTowards(geo_led_t led, CRGB color, byte amount);
+
+  /* Advance the dither pattern for the next frame */
+  void nextFrame() { frame++; }
+
+  /* Color of an LED rounded to 8 bits with the current dither pattern */
+  CRGB value(geo_led_t led);
+
+  geo_led_t numLeds;
+
+ private:
+  color16_t *colors;
+  byte frame;
+};
+
+#endif
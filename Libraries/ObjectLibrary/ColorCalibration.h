@@ -0,0 +1,59 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Gamma correction and white balance for a strand of LEDs.
+ *
+ * Modes work with linear colors and the calibration is applied only as the
+ * colors of changed LEDs are copied to the pixels, so each channel costs one
+ * read from a gamma curve in flash and one multiply for its balance.  The
+ * calibration is stored with the geometry's configuration since it depends
+ * on the strand that object was built with.
+ ******************************************************************************/
+
+#ifndef COLORCALIBRATION_H
+#define COLORCALIBRATION_H
+
+#include <Arduino.h>
+
+#include "PixelUtil.h"
+
+/* Gamma curves */
+#define CALIBRATION_LINEAR     0
+#define CALIBRATION_GAMMA_18   1
+#define CALIBRATION_GAMMA_22   2
+#define CALIBRATION_GAMMA_28   3
+#define CALIBRATION_NUM_CURVES 4
+
+/*
+ * Calibration as stored in a configuration.  All zeros leaves colors
+ * unchanged, so configurations written before calibration existed are valid.
+ */
+typedef struct {
+  byte curve;  // One of the CALIBRATION_ curves
+  byte dim[3]; // Amount each of red, green and blue is reduced by of 255
+} color_calibration_t;
+
+class ColorCalibration {
+ public:
+  ColorCalibration();
+
+  void set(const color_calibration_t *config);
+  const color_calibration_t *get() { return &config; }
+
+  /* Set an LED's pixel to its calibrated color */
+  void setPixel(PixelUtil *pixels, PRGB *rgb);
+
+ private:
+  color_calibration_t config;
+  const byte *curve; // NULL if linear
+  byte scale[3];
+
+  byte channel(byte value, byte channelScale) {
+    if (curve != NULL) value = pgm_read_byte(&curve[value]);
+    return ((uint16_t)value * (channelScale + 1)) >> 8;
+  }
+};
+
+#endif
@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+#ifndef DEBUG_LEVEL
+  #define DEBUG_LEVEL DEBUG_MID
+#endif
+#include "Debug.h"
+
+#include "Diffusion.h"
+
+Diffusion::Diffusion(led_neighbor_t neighbor, geo_led_t _numLeds,
+                     byte *buffer) {
+  numLeds = _numLeds;
+  rows = buffer;
+
+  /* Build the rows of the matrix */
+  uint16_t pos = 0;
+  for (geo_led_t led = 0; led < numLeds; led++) {
+    uint16_t count = pos++;
+    uint16_t weight = pos++;
+    rows[count] = 0;
+    for (byte i = 0; i < LED_MAX_NEIGHBORS; i++) {
+      geo_led_t n = neighbor(led, i);
+      if (n < numLeds) {
+        rows[pos++] = n;
+        rows[count]++;
+      }
+    }
+    rows[weight] = (rows[count] > 0) ? (byte)(256 / rows[count]) : 0;
+  }
+
+  /* The next colors follow the matrix */
+  next = (CRGB *)&rows[pos];
+  fill_solid(next, numLeds, CRGB::Black);
+
+  DEBUG4_VALUELN("Diffusion matrix bytes:", pos);
+}
+
+void Diffusion::step(led_color_t current, byte rate, CRGB decay) {
+  byte *row = rows;
+
+  for (geo_led_t led = 0; led < numLeds; led++) {
+    byte count = *row++;
+    uint16_t weight = *row++;
+    if (weight == 0) weight = 256;
+    CRGB color = current(led);
+
+    if (count > 0) {
+      uint16_t r = 0, g = 0, b = 0;
+      for (byte i = 0; i < count; i++) {
+        CRGB n = current(*row++);
+        r += n.r;
+        g += n.g;
+        b += n.b;
+      }
+
+      /*
+       * Blend towards the average of the neighbors.  The sums are at most
+       * 255 * count, so scaled by the weight they still fit 16 bits.
+       */
+      color.r = lerp8by8(color.r, (r * weight) >> 8, rate);
+      color.g = lerp8by8(color.g, (g * weight) >> 8, rate);
+      color.b = lerp8by8(color.b, (b * weight) >> 8, rate);
+    }
+
+    color.r = scale8(color.r, decay.r);
+    color.g = scale8(color.g, decay.g);
+    color.b = scale8(color.b, decay.b);
+    next[led] = color;
+  }
+}
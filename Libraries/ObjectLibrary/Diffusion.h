@@ -0,0 +1,59 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Diffusion of color between adjacent LEDs.
+ *
+ * The adjacency is built once as a compressed sparse row matrix over the LEDs
+ * and each step computes every LED's new color from the previous colors of
+ * its neighbors into a separate buffer, so the result does not depend on the
+ * order that LEDs are visited.
+ ******************************************************************************/
+
+#ifndef DIFFUSION_H
+#define DIFFUSION_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+#include "LedGraph.h"
+
+/* Function returning the current color of an LED */
+typedef CRGB (*led_color_t)(geo_led_t led);
+
+/* Bytes of buffer required for a number of LEDs */
+#define DIFFUSION_BUFFER_SIZE(leds) \
+  ((leds) * (2 + LED_MAX_NEIGHBORS + sizeof (CRGB)))
+
+class Diffusion {
+ public:
+  Diffusion() {};
+
+  /* buffer must be at least DIFFUSION_BUFFER_SIZE(numLeds) bytes */
+  Diffusion(led_neighbor_t neighbor, geo_led_t numLeds, byte *buffer);
+
+  /*
+   * Compute the next colors.  Each LED moves rate/256 of the way towards the
+   * average of its neighbors, and then each channel is scaled by decay/256.
+   */
+  void step(led_color_t current, byte rate, CRGB decay);
+
+  /* Color of an LED after the last step */
+  CRGB value(geo_led_t led) { return next[led]; }
+
+ private:
+  geo_led_t numLeds;
+
+  /*
+   * Rows of the matrix, each being the number of neighbors, the weight of
+   * each neighbor and the neighbors' indices.  All neighbors in a row have
+   * equal weight, 1/count in 8.8 fixed point so that the average is a
+   * multiply rather than a divide, where the 256 of a single neighbor is
+   * stored as 0.
+   */
+  byte *rows;
+  CRGB *next;
+};
+
+#endif
@@ -9,6 +9,8 @@
 #ifndef GEOMETRY
 #define GEOMETRY
 
+#include "ColorCalibration.h"
+
 /*
  * Typedef for object IDs.  These should probably be set to the minimal type
  * for a given project as these types are a large factor in the per-object
@@ -17,6 +19,19 @@
 typedef uint8_t geo_id_t;
 typedef uint8_t geo_led_t;
 
+/*
+ * Fixed-point position of an object or LED.  Coordinates are scaled such that
+ * the geometry fits within +/-GEO_COORD_MAX, with z being up.
+ */
+typedef struct {
+  int8_t x;
+  int8_t y;
+  int8_t z;
+} geo_point_t;
+
+#define GEO_COORD_MAX 100
+#define GEO_NO_COORD  (int8_t)-128
+
 class Geometry {
  public:
 
@@ -63,15 +78,22 @@ class Geometry {
 
   /* Return whether this object has LEDs defined */
   boolean hasLeds() { return (leds[0].pixel != NO_LED); }
+
+  /* Return whether this object's position is known */
+  boolean hasCenter() { return (center.x != GEO_NO_COORD); }
+  void setCenter(int8_t x, int8_t y, int8_t z) {
+    center.x = x; center.y = y; center.z = z;
+  }
   
   /*
    * Variables - be careful of object size
    */
   geo_id_t id;
 
-  PRGB leds[];
+  PRGB leds[0];
   byte mark;
   boolean updated; // XXX - Can this be determined some other way to save a byte?
+  geo_point_t center;
 
 };
 
@@ -79,9 +101,15 @@ class Geometry {
 typedef struct {
   byte     version;
   uint16_t num_objects;
-  byte     reserved[6];
+  color_calibration_t calibration; // Calibration of the strand's LEDs
+  uint16_t power_budget_ma;        // Limit on the LEDs' current, 0 for none
 } geometry_config_t;
 
-#define GEOMETRY_CONFIG_VERSION 1
+/*
+ * Version history:
+ *   1 - Initial version
+ *   2 - Objects include the position of their center
+ */
+#define GEOMETRY_CONFIG_VERSION 2
 
 #endif
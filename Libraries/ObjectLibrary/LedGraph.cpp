@@ -0,0 +1,38 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#include "LedGraph.h"
+
+/*
+ * Breadth first search which expands one hop per pass over the LEDs, this
+ * requires no queue beyond the distance array itself.
+ */
+void ledHopDistances(led_neighbor_t neighbor, geo_led_t numLeds,
+                     geo_led_t source, byte *dist) {
+  memset(dist, LED_NO_HOPS, numLeds);
+  if (source >= numLeds) return;
+  dist[source] = 0;
+
+  for (byte hops = 0; hops < LED_NO_HOPS - 1; hops++) {
+    boolean expanded = false;
+
+    for (geo_led_t led = 0; led < numLeds; led++) {
+      if (dist[led] != hops) continue;
+
+      for (byte i = 0; i < LED_MAX_NEIGHBORS; i++) {
+        geo_led_t next = neighbor(led, i);
+        if ((next < numLeds) && (dist[next] == LED_NO_HOPS)) {
+          dist[next] = hops + 1;
+          expanded = true;
+        }
+      }
+    }
+
+    if (!expanded) break;
+  }
+}
@@ -0,0 +1,34 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Functions over the graph of LEDs in a geometry, where LEDs are indexed as
+ * object * NUM_LEDS + led and connected to the LEDs adjacent to them.
+ ******************************************************************************/
+
+#ifndef LEDGRAPH_H
+#define LEDGRAPH_H
+
+#include <Arduino.h>
+
+#include "PixelUtil.h"
+#include "Geometry.h"
+
+#define LED_MAX_NEIGHBORS 4
+#define LED_NO_HOPS (byte)-1
+
+/*
+ * Function returning the index-th neighbor of an LED, or Geometry::NO_LED if
+ * there is no such neighbor.
+ */
+typedef geo_led_t (*led_neighbor_t)(geo_led_t led, byte index);
+
+/*
+ * Fill dist with the number of hops from the source to every LED, or
+ * LED_NO_HOPS for unreachable LEDs.
+ */
+void ledHopDistances(led_neighbor_t neighbor, geo_led_t numLeds,
+                     geo_led_t source, byte *dist);
+
+#endif
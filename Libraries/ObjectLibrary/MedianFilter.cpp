@@ -0,0 +1,42 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#include "MedianFilter.h"
+
+MedianFilter::MedianFilter() {
+  clear();
+}
+
+void MedianFilter::clear() {
+  next = 0;
+  num = 0;
+}
+
+void MedianFilter::add(uint16_t value) {
+  values[next] = value;
+  next = (next + 1) % MEDIAN_FILTER_SIZE;
+  if (num < MEDIAN_FILTER_SIZE) num++;
+}
+
+uint16_t MedianFilter::value() {
+  if (num == 0) return 0;
+
+  /* Insertion sort a copy, there are only a handful of values */
+  uint16_t sorted[MEDIAN_FILTER_SIZE];
+  for (byte i = 0; i < num; i++) {
+    uint16_t value = values[i];
+    byte j = i;
+    while ((j > 0) && (sorted[j - 1] > value)) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = value;
+  }
+
+  return sorted[num / 2];
+}
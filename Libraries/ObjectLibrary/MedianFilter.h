@@ -0,0 +1,36 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Median of the most recent readings of a noisy sensor.  A median rejects the
+ * occasional wild reading (a missed echo, a reflection off something else)
+ * that would drag an average around.
+ ******************************************************************************/
+
+#ifndef MEDIANFILTER_H
+#define MEDIANFILTER_H
+
+#include <Arduino.h>
+
+#define MEDIAN_FILTER_SIZE 5
+
+class MedianFilter {
+ public:
+  MedianFilter();
+
+  void add(uint16_t value);
+
+  /* Median of the readings, or 0 if there have been none */
+  uint16_t value();
+
+  byte count() { return num; }
+  void clear();
+
+ private:
+  uint16_t values[MEDIAN_FILTER_SIZE]; // Ring of the most recent readings
+  byte next;
+  byte num;
+};
+
+#endif
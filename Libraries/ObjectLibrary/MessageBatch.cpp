@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+//#define DEBUG_LEVEL DEBUG_HIGH
+#include "Debug.h"
+
+#include "MessageBatch.h"
+
+MessageBatch::MessageBatch(byte *_buffer, uint16_t _size) {
+  buffer = _buffer;
+  size = min(_size, MESSAGE_BATCH_MAX_LENGTH);
+  clear();
+}
+
+void MessageBatch::clear() {
+  length = sizeof (msg_hdr_t);
+  messages = 0;
+}
+
+boolean MessageBatch::add(uint16_t msg_length) {
+  if ((msg_length < sizeof (msg_hdr_t)) || (msg_length > space())) {
+    DEBUG1_VALUELN("Batch dropped len:", msg_length);
+    return false;
+  }
+
+  msg_hdr_t *msg = (msg_hdr_t *)tail();
+  if (messages == 0) {
+    ((msg_hdr_t *)buffer)->address = msg->address;
+  } else if (msg->address != address()) {
+    ((msg_hdr_t *)buffer)->address = SOCKET_ADDR_ANY;
+  }
+
+  length += msg_length;
+  messages++;
+  return true;
+}
+
+uint16_t MessageBatch::finish() {
+  if (messages == 0) return 0;
+
+  hmtl_msg_fmt((msg_hdr_t *)buffer, address(), length, MSG_TYPE_BATCH, 0);
+  DEBUG4_VALUE("Batch msgs:", messages);
+  DEBUG4_VALUELN(" len:", length);
+  return length;
+}
+
+msg_hdr_t *MessageBatch::unpack(msg_hdr_t *batch, msg_hdr_t *prev) {
+  byte *end = (byte *)batch + batch->length;
+  byte *next;
+  if (prev == NULL) {
+    next = (byte *)(batch + 1);
+  } else {
+    next = (byte *)prev + prev->length;
+  }
+
+  if (next + sizeof (msg_hdr_t) > end) return NULL;
+
+  msg_hdr_t *msg = (msg_hdr_t *)next;
+  if ((msg->startcode != HMTL_MSG_START) ||
+      (msg->length < sizeof (msg_hdr_t)) ||
+      (next + msg->length > end)) {
+    DEBUG1_PRINTLN("Batch has a bad message");
+    return NULL;
+  }
+  return msg;
+}
@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Several HMTL messages packed into one frame, so that related commands go
+ * out in a single bus transaction rather than one transaction each.
+ *
+ * A batch is an HMTL header of type MSG_TYPE_BATCH followed by complete
+ * messages, each with its own header, address and length.  The messages are
+ * formatted in place at tail() by the usual hmtl_*_fmt() functions and then
+ * added.  The batch is addressed to the module its messages are for, or to
+ * every module if they are for more than one, and a receiver takes the
+ * messages addressed to it out with unpack() in the order they were added.
+ ******************************************************************************/
+
+#ifndef MESSAGEBATCH_H
+#define MESSAGEBATCH_H
+
+#include <Arduino.h>
+#include "HMTLMessaging.h"
+
+/* Not one of the HMTL library's message types */
+#define MSG_TYPE_BATCH 0x10
+
+/* The HMTL header's length is a byte */
+#define MESSAGE_BATCH_MAX_LENGTH 255
+
+class MessageBatch {
+ public:
+  MessageBatch(byte *buffer, uint16_t size);
+
+  /* Start a new batch, discarding any messages that weren't sent */
+  void clear();
+
+  /* Where to format the next message, and the room left for it */
+  byte *tail() { return buffer + length; }
+  uint16_t space() { return size - length; }
+
+  /*
+   * Add the message of msg_length bytes formatted at tail(), false if it was
+   * empty or didn't fit.
+   */
+  boolean add(uint16_t msg_length);
+
+  byte count() { return messages; }
+
+  /* Fill in the batch's header and return its length, 0 if it is empty */
+  uint16_t finish();
+
+  /* Address to send the finished batch to */
+  uint16_t address() { return ((msg_hdr_t *)buffer)->address; }
+
+  /*
+   * Step through the messages of a received batch, starting from NULL.
+   * Returns NULL after the last one or at a message that would run past the
+   * end of the batch.
+   */
+  static msg_hdr_t *unpack(msg_hdr_t *batch, msg_hdr_t *prev);
+
+ private:
+  byte *buffer;
+  uint16_t size;
+  uint16_t length;
+  byte messages;
+};
+
+#endif
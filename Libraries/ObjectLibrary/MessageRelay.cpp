@@ -0,0 +1,14 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#include "MessageRelay.h"
+
+boolean MessageRelay::forward(uint16_t origin, byte sequence, byte hops) {
+  if (hops >= MESSAGE_MAX_HOPS) return false;
+  return seen.check(origin, sequence);
+}
@@ -0,0 +1,34 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Decides which broadcasts a module with more than one socket passes on from
+ * the socket it arrived on to the others, such as from RS485 to XBee.
+ *
+ * A message is identified as for RecentMessages, and carries the number of
+ * hops it has been passed on.  It is passed on the first time it is seen
+ * and only while it has made fewer than MESSAGE_MAX_HOPS hops, so that a
+ * copy caught in a loop of sockets stops even once its id has fallen out of
+ * the recent message cache.
+ ******************************************************************************/
+
+#ifndef MESSAGERELAY_H
+#define MESSAGERELAY_H
+
+#include <Arduino.h>
+
+#include "RecentMessages.h"
+
+#define MESSAGE_MAX_HOPS 3
+
+class MessageRelay {
+ public:
+  /* Returns true if the message should be passed on with one more hop */
+  boolean forward(uint16_t origin, byte sequence, byte hops);
+
+ private:
+  RecentMessages seen;
+};
+
+#endif
@@ -0,0 +1,74 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+//#define DEBUG_LEVEL DEBUG_HIGH
+#include "Debug.h"
+
+#include "MessageRing.h"
+
+MessageRing::MessageRing(byte *_buffer, byte _slots, uint16_t _slotSize) {
+  buffer = _buffer;
+  slots = min(_slots, MESSAGE_RING_MAX_SLOTS);
+  slotSize = _slotSize;
+  first = 0;
+  used = 0;
+  released = 0;
+
+  memset(&stats, 0, sizeof (stats));
+}
+
+/* Each slot is the message length followed by the message */
+byte *MessageRing::slot(byte number) {
+  return buffer + (uint16_t)number * (slotSize + sizeof (uint16_t));
+}
+
+boolean MessageRing::push(const byte *data, uint16_t length) {
+  if (length > slotSize) {
+    DEBUG1_VALUELN("MessageRing: oversize ", length);
+    stats.oversize++;
+    return false;
+  }
+  if (full()) {
+    stats.full++;
+    return false;
+  }
+
+  byte *ptr = slot((first + used) % slots);
+  memcpy(ptr, &length, sizeof (uint16_t));
+  memcpy(ptr + sizeof (uint16_t), data, length);
+
+  used++;
+  stats.received++;
+  if (used > stats.high_water) stats.high_water = used;
+
+  return true;
+}
+
+boolean MessageRing::view(byte index, message_view_t *view) {
+  if (index >= used) return false;
+
+  byte number = (first + index) % slots;
+  if (released & (1 << number)) return false;
+
+  byte *ptr = slot(number);
+  memcpy(&view->length, ptr, sizeof (uint16_t));
+  view->data = ptr + sizeof (uint16_t);
+  view->slot = number;
+  return true;
+}
+
+void MessageRing::release(const message_view_t *view) {
+  released |= (1 << view->slot);
+
+  /* Free the oldest slots once they have been released */
+  while ((used > 0) && (released & (1 << first))) {
+    released &= ~(1 << first);
+    first = (first + 1) % slots;
+    used--;
+  }
+}
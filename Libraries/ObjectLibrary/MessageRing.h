@@ -0,0 +1,87 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Ring of received messages.
+ *
+ * Sockets return messages in their single receive buffer, which is reused as
+ * soon as they are asked for more data.  Copying each complete message into
+ * its own slot here lets several messages be handled per loop, each through
+ * a view that stays valid however much more data arrives until the view is
+ * released.  Views may be released in any order, a slot is reused once it
+ * and every older message have been released.
+ *
+ * Messages are not checked against a CRC here, as RS485_non_blocking already
+ * checks the CRC of every packet and drops those that fail before the socket
+ * returns them.
+ ******************************************************************************/
+
+#ifndef MESSAGERING_H
+#define MESSAGERING_H
+
+#include <Arduino.h>
+
+/* Bytes of buffer needed for a number of slots of a maximum message size */
+#define MESSAGE_RING_SIZE(slots, size) ((slots) * ((size) + sizeof (uint16_t)))
+
+/* Released slots are tracked in a byte */
+#define MESSAGE_RING_MAX_SLOTS 8
+
+typedef struct {
+  uint16_t received;   // Messages stored
+  uint16_t full;       // Times that messages were left unread due to no slots
+  uint16_t oversize;   // Messages dropped for being larger than a slot
+  byte high_water;     // Most slots in use at once
+} message_ring_stats_t;
+
+/* A stored message, valid until it is released */
+typedef struct {
+  const byte *data;
+  uint16_t length;
+  byte slot;
+} message_view_t;
+
+class MessageRing {
+ public:
+  /* slots is at most MESSAGE_RING_MAX_SLOTS */
+  MessageRing(byte *buffer, byte slots, uint16_t slotSize);
+
+  /* Copy a message into a free slot, false if it couldn't be stored */
+  boolean push(const byte *data, uint16_t length);
+
+  /* Record that a message had to be left with the socket */
+  void noteFull() { stats.full++; }
+
+  boolean full() { return used == slots; }
+
+  /* Messages held, including released ones waiting on an older message */
+  byte count() { return used; }
+
+  /*
+   * View the message at index, from 0 for the oldest held.  Returns false if
+   * there is no message there or it has been released.
+   */
+  boolean view(byte index, message_view_t *view);
+
+  /*
+   * Release a viewed message, after which its data may be overwritten.  Each
+   * view is released once.
+   */
+  void release(const message_view_t *view);
+
+  message_ring_stats_t stats;
+
+ private:
+  byte *slot(byte number);
+
+  byte *buffer;
+  byte slots;
+  uint16_t slotSize;
+
+  byte first;    // Slot holding the oldest message
+  byte used;
+  byte released; // Bit per slot of messages released before an older one
+};
+
+#endif
@@ -0,0 +1,160 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#include "Palette.h"
+
+/* Green to red to blue and back to green, the same as pixel_wheel() */
+const byte palette_wheel[PALETTE_SIZE * 3] PROGMEM = {
+          0,255,  0,   3,252,  0,   6,249,  0,   9,246,  0,
+         12,243,  0,  15,240,  0,  18,237,  0,  21,234,  0,
+         24,231,  0,  27,228,  0,  30,225,  0,  33,222,  0,
+         36,219,  0,  39,216,  0,  42,213,  0,  45,210,  0,
+         48,207,  0,  51,204,  0,  54,201,  0,  57,198,  0,
+         60,195,  0,  63,192,  0,  66,189,  0,  69,186,  0,
+         72,183,  0,  75,180,  0,  78,177,  0,  81,174,  0,
+         84,171,  0,  87,168,  0,  90,165,  0,  93,162,  0,
+         96,159,  0,  99,156,  0, 102,153,  0, 105,150,  0,
+        108,147,  0, 111,144,  0, 114,141,  0, 117,138,  0,
+        120,135,  0, 123,132,  0, 126,129,  0, 129,126,  0,
+        132,123,  0, 135,120,  0, 138,117,  0, 141,114,  0,
+        144,111,  0, 147,108,  0, 150,105,  0, 153,102,  0,
+        156, 99,  0, 159, 96,  0, 162, 93,  0, 165, 90,  0,
+        168, 87,  0, 171, 84,  0, 174, 81,  0, 177, 78,  0,
+        180, 75,  0, 183, 72,  0, 186, 69,  0, 189, 66,  0,
+        192, 63,  0, 195, 60,  0, 198, 57,  0, 201, 54,  0,
+        204, 51,  0, 207, 48,  0, 210, 45,  0, 213, 42,  0,
+        216, 39,  0, 219, 36,  0, 222, 33,  0, 225, 30,  0,
+        228, 27,  0, 231, 24,  0, 234, 21,  0, 237, 18,  0,
+        240, 15,  0, 243, 12,  0, 246,  9,  0, 249,  6,  0,
+        252,  3,  0, 255,  0,  0, 252,  0,  3, 249,  0,  6,
+        246,  0,  9, 243,  0, 12, 240,  0, 15, 237,  0, 18,
+        234,  0, 21, 231,  0, 24, 228,  0, 27, 225,  0, 30,
+        222,  0, 33, 219,  0, 36, 216,  0, 39, 213,  0, 42,
+        210,  0, 45, 207,  0, 48, 204,  0, 51, 201,  0, 54,
+        198,  0, 57, 195,  0, 60, 192,  0, 63, 189,  0, 66,
+        186,  0, 69, 183,  0, 72, 180,  0, 75, 177,  0, 78,
+        174,  0, 81, 171,  0, 84, 168,  0, 87, 165,  0, 90,
+        162,  0, 93, 159,  0, 96, 156,  0, 99, 153,  0,102,
+        150,  0,105, 147,  0,108, 144,  0,111, 141,  0,114,
+        138,  0,117, 135,  0,120, 132,  0,123, 129,  0,126,
+        126,  0,129, 123,  0,132, 120,  0,135, 117,  0,138,
+        114,  0,141, 111,  0,144, 108,  0,147, 105,  0,150,
+        102,  0,153,  99,  0,156,  96,  0,159,  93,  0,162,
+         90,  0,165,  87,  0,168,  84,  0,171,  81,  0,174,
+         78,  0,177,  75,  0,180,  72,  0,183,  69,  0,186,
+         66,  0,189,  63,  0,192,  60,  0,195,  57,  0,198,
+         54,  0,201,  51,  0,204,  48,  0,207,  45,  0,210,
+         42,  0,213,  39,  0,216,  36,  0,219,  33,  0,222,
+         30,  0,225,  27,  0,228,  24,  0,231,  21,  0,234,
+         18,  0,237,  15,  0,240,  12,  0,243,   9,  0,246,
+          6,  0,249,   3,  0,252,   0,  0,255,   0,  3,252,
+          0,  6,249,   0,  9,246,   0, 12,243,   0, 15,240,
+          0, 18,237,   0, 21,234,   0, 24,231,   0, 27,228,
+          0, 30,225,   0, 33,222,   0, 36,219,   0, 39,216,
+          0, 42,213,   0, 45,210,   0, 48,207,   0, 51,204,
+          0, 54,201,   0, 57,198,   0, 60,195,   0, 63,192,
+          0, 66,189,   0, 69,186,   0, 72,183,   0, 75,180,
+          0, 78,177,   0, 81,174,   0, 84,171,   0, 87,168,
+          0, 90,165,   0, 93,162,   0, 96,159,   0, 99,156,
+          0,102,153,   0,105,150,   0,108,147,   0,111,144,
+          0,114,141,   0,117,138,   0,120,135,   0,123,132,
+          0,126,129,   0,129,126,   0,132,123,   0,135,120,
+          0,138,117,   0,141,114,   0,144,111,   0,147,108,
+          0,150,105,   0,153,102,   0,156, 99,   0,159, 96,
+          0,162, 93,   0,165, 90,   0,168, 87,   0,171, 84,
+          0,174, 81,   0,177, 78,   0,180, 75,   0,183, 72,
+          0,186, 69,   0,189, 66,   0,192, 63,   0,195, 60,
+          0,198, 57,   0,201, 54,   0,204, 51,   0,207, 48,
+          0,210, 45,   0,213, 42,   0,216, 39,   0,219, 36,
+          0,222, 33,   0,225, 30,   0,228, 27,   0,231, 24,
+          0,234, 21,   0,237, 18,   0,240, 15,   0,243, 12,
+          0,246,  9,   0,249,  6,   0,252,  3,   0,255,  0,
+};
+
+/* Black through red and yellow to white, as FastLED's HeatColor() */
+const byte palette_heat[PALETTE_SIZE * 3] PROGMEM = {
+          0,  0,  0,   4,  0,  0,   8,  0,  0,  12,  0,  0,
+         12,  0,  0,  16,  0,  0,  20,  0,  0,  24,  0,  0,
+         24,  0,  0,  28,  0,  0,  32,  0,  0,  36,  0,  0,
+         36,  0,  0,  40,  0,  0,  44,  0,  0,  48,  0,  0,
+         48,  0,  0,  52,  0,  0,  56,  0,  0,  60,  0,  0,
+         60,  0,  0,  64,  0,  0,  68,  0,  0,  72,  0,  0,
+         72,  0,  0,  76,  0,  0,  80,  0,  0,  84,  0,  0,
+         84,  0,  0,  88,  0,  0,  92,  0,  0,  96,  0,  0,
+         96,  0,  0, 100,  0,  0, 104,  0,  0, 108,  0,  0,
+        108,  0,  0, 112,  0,  0, 116,  0,  0, 120,  0,  0,
+        120,  0,  0, 124,  0,  0, 128,  0,  0, 132,  0,  0,
+        132,  0,  0, 136,  0,  0, 140,  0,  0, 144,  0,  0,
+        144,  0,  0, 148,  0,  0, 152,  0,  0, 156,  0,  0,
+        156,  0,  0, 160,  0,  0, 164,  0,  0, 168,  0,  0,
+        168,  0,  0, 172,  0,  0, 176,  0,  0, 180,  0,  0,
+        180,  0,  0, 184,  0,  0, 188,  0,  0, 192,  0,  0,
+        192,  0,  0, 196,  0,  0, 200,  0,  0, 200,  0,  0,
+        204,  0,  0, 208,  0,  0, 212,  0,  0, 212,  0,  0,
+        216,  0,  0, 220,  0,  0, 224,  0,  0, 224,  0,  0,
+        228,  0,  0, 232,  0,  0, 236,  0,  0, 236,  0,  0,
+        240,  0,  0, 244,  0,  0, 248,  0,  0, 248,  0,  0,
+        252,  0,  0, 255,  0,  0, 255,  4,  0, 255,  4,  0,
+        255,  8,  0, 255, 12,  0, 255, 16,  0, 255, 16,  0,
+        255, 20,  0, 255, 24,  0, 255, 28,  0, 255, 28,  0,
+        255, 32,  0, 255, 36,  0, 255, 40,  0, 255, 40,  0,
+        255, 44,  0, 255, 48,  0, 255, 52,  0, 255, 52,  0,
+        255, 56,  0, 255, 60,  0, 255, 64,  0, 255, 64,  0,
+        255, 68,  0, 255, 72,  0, 255, 76,  0, 255, 76,  0,
+        255, 80,  0, 255, 84,  0, 255, 88,  0, 255, 88,  0,
+        255, 92,  0, 255, 96,  0, 255,100,  0, 255,100,  0,
+        255,104,  0, 255,108,  0, 255,112,  0, 255,112,  0,
+        255,116,  0, 255,120,  0, 255,124,  0, 255,124,  0,
+        255,128,  0, 255,132,  0, 255,132,  0, 255,136,  0,
+        255,140,  0, 255,144,  0, 255,144,  0, 255,148,  0,
+        255,152,  0, 255,156,  0, 255,156,  0, 255,160,  0,
+        255,164,  0, 255,168,  0, 255,168,  0, 255,172,  0,
+        255,176,  0, 255,180,  0, 255,180,  0, 255,184,  0,
+        255,188,  0, 255,192,  0, 255,192,  0, 255,196,  0,
+        255,200,  0, 255,204,  0, 255,204,  0, 255,208,  0,
+        255,212,  0, 255,216,  0, 255,216,  0, 255,220,  0,
+        255,224,  0, 255,228,  0, 255,228,  0, 255,232,  0,
+        255,236,  0, 255,240,  0, 255,240,  0, 255,244,  0,
+        255,248,  0, 255,252,  0, 255,252,  0, 255,255,  0,
+        255,255,  4, 255,255,  8, 255,255,  8, 255,255, 12,
+        255,255, 16, 255,255, 20, 255,255, 20, 255,255, 24,
+        255,255, 28, 255,255, 32, 255,255, 32, 255,255, 36,
+        255,255, 40, 255,255, 44, 255,255, 44, 255,255, 48,
+        255,255, 52, 255,255, 56, 255,255, 56, 255,255, 60,
+        255,255, 64, 255,255, 64, 255,255, 68, 255,255, 72,
+        255,255, 76, 255,255, 76, 255,255, 80, 255,255, 84,
+        255,255, 88, 255,255, 88, 255,255, 92, 255,255, 96,
+        255,255,100, 255,255,100, 255,255,104, 255,255,108,
+        255,255,112, 255,255,112, 255,255,116, 255,255,120,
+        255,255,124, 255,255,124, 255,255,128, 255,255,132,
+        255,255,136, 255,255,136, 255,255,140, 255,255,144,
+        255,255,148, 255,255,148, 255,255,152, 255,255,156,
+        255,255,160, 255,255,160, 255,255,164, 255,255,168,
+        255,255,172, 255,255,172, 255,255,176, 255,255,180,
+        255,255,184, 255,255,184, 255,255,188, 255,255,192,
+        255,255,196, 255,255,196, 255,255,200, 255,255,204,
+        255,255,208, 255,255,208, 255,255,212, 255,255,216,
+        255,255,220, 255,255,220, 255,255,224, 255,255,228,
+        255,255,232, 255,255,232, 255,255,236, 255,255,240,
+        255,255,244, 255,255,244, 255,255,248, 255,255,252,
+};
+
+const byte * const palettes[NUM_PALETTES] PROGMEM = {
+        palette_wheel,
+        palette_heat
+};
+
+Palette::Palette(byte id) {
+  set(id);
+  offset = 0;
+}
+
+void Palette::set(byte id) {
+  if (id >= NUM_PALETTES) id = PALETTE_WHEEL;
+  table = (const byte *)pgm_read_word(&palettes[id]);
+}
@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Color palettes of 256 colors stored in flash.
+ *
+ * Colors that the modes would otherwise compute for every LED on every frame
+ * (pixel_wheel(), pixel_heat()) are read from a precomputed table instead.
+ * Changing palettes only changes the table pointer, and rotating a palette
+ * only changes the offset added to every index.
+ ******************************************************************************/
+
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+#include "PixelUtil.h"
+
+#define PALETTE_SIZE 256
+
+#define PALETTE_WHEEL 0
+#define PALETTE_HEAT  1
+#define NUM_PALETTES  2
+
+extern const byte palette_wheel[PALETTE_SIZE * 3] PROGMEM;
+extern const byte palette_heat[PALETTE_SIZE * 3] PROGMEM;
+
+class Palette {
+ public:
+  Palette(byte id = PALETTE_WHEEL);
+
+  /* Use one of the PALETTE_ palettes */
+  void set(byte id);
+
+  /* Shift every color by a number of entries */
+  void rotate(int8_t amount) { offset += amount; }
+  void setOffset(byte _offset) { offset = _offset; }
+
+  CRGB color(byte index) {
+    const byte *rgb = &table[(byte)(index + offset) * 3];
+    return CRGB(pgm_read_byte(&rgb[0]),
+                pgm_read_byte(&rgb[1]),
+                pgm_read_byte(&rgb[2]));
+  }
+
+  /* The color as from pixel_color() */
+  uint32_t pixel(byte index) {
+    const byte *rgb = &table[(byte)(index + offset) * 3];
+    return pixel_color(pgm_read_byte(&rgb[0]),
+                       pgm_read_byte(&rgb[1]),
+                       pgm_read_byte(&rgb[2]));
+  }
+
+ private:
+  const byte *table;
+  byte offset;
+};
+
+#endif
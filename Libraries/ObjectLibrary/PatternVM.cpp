@@ -0,0 +1,276 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+#ifndef DEBUG_LEVEL
+  #define DEBUG_LEVEL DEBUG_MID
+#endif
+#include "Debug.h"
+
+#include "PatternVM.h"
+
+/* Number of operand bytes following each opcode */
+static const byte vm_operands[VM_NUM_OPS] PROGMEM = {
+        0, 1, 2, 0, 0, 0, 1, 1, // END - STORE
+        0, 1, 0, 0, 0, 0, 0, 0, // SELF - MUL
+        0, 0, 0, 0, 0, 1, 1, 0, // DIV - LT
+        0, 0, 1, 1              // EQ - JMP
+};
+
+PatternVM::PatternVM(led_neighbor_t neighbor, geo_led_t _numLeds,
+                     byte *buffer) {
+  numLeds = _numLeds;
+  neighbors = buffer;
+  current = &buffer[numLeds * LED_MAX_NEIGHBORS];
+  previous = &current[numLeds];
+  program = NULL;
+
+  /* Missing neighbors refer to the LED itself */
+  for (geo_led_t led = 0; led < numLeds; led++) {
+    for (byte i = 0; i < LED_MAX_NEIGHBORS; i++) {
+      geo_led_t n = neighbor(led, i);
+      neighbors[led * LED_MAX_NEIGHBORS + i] = (n < numLeds) ? n : led;
+    }
+  }
+
+  memset(current, 0, numLeds * 2);
+}
+
+boolean PatternVM::load(const byte *_program, byte length) {
+  if ((length < 1) || (length > VM_MAX_PROGRAM) ||
+      (_program[0] >= length)) {
+    DEBUG3_VALUELN("VM: bad length:", length);
+    return false;
+  }
+
+  /*
+   * Check every instruction of the frame code and then of the LED code,
+   * marking where each one starts.  The end of each code is also a valid
+   * place for a jump to land.
+   */
+  byte starts[(VM_MAX_PROGRAM + 8) / 8];
+  memset(starts, 0, sizeof (starts));
+
+  byte ledCode = 1 + _program[0];
+  byte start = 1;
+  byte stop = ledCode;
+  for (byte section = 0; section < 2; section++) {
+    for (byte pc = start; pc < stop; pc++) {
+      starts[pc >> 3] |= 1 << (pc & 7);
+
+      byte op = _program[pc];
+      if (op >= VM_NUM_OPS) {
+        DEBUG3_VALUE("VM: bad op:", op);
+        DEBUG3_VALUELN(" at:", pc);
+        return false;
+      }
+
+      byte operands = pgm_read_byte(&vm_operands[op]);
+      if (pc + operands >= stop) {
+        DEBUG3_VALUELN("VM: truncated at:", pc);
+        return false;
+      }
+
+      switch (op) {
+        case VM_LOAD:
+        case VM_STORE:
+          if (_program[pc + 1] >= VM_NUM_REGISTERS) return false;
+          break;
+        case VM_NEIGHBOR:
+          if (_program[pc + 1] >= LED_MAX_NEIGHBORS) return false;
+          break;
+        case VM_SHL:
+        case VM_SHR:
+          if (_program[pc + 1] > 15) return false;
+          break;
+      }
+
+      pc += operands;
+    }
+
+    starts[stop >> 3] |= 1 << (stop & 7);
+    start = ledCode;
+    stop = length;
+  }
+
+  /*
+   * A jump must land on an instruction of its own code or at its end, never
+   * inside an operand where the bytes were not checked as instructions.
+   */
+  start = 1;
+  stop = ledCode;
+  for (byte section = 0; section < 2; section++) {
+    for (byte pc = start; pc < stop;
+         pc += 1 + pgm_read_byte(&vm_operands[_program[pc]])) {
+      byte op = _program[pc];
+      if ((op != VM_JZ) && (op != VM_JMP)) continue;
+
+      byte target = pc + 2 + _program[pc + 1];
+      if ((target > stop) || !(starts[target >> 3] & (1 << (target & 7)))) {
+        DEBUG3_VALUELN("VM: bad jump at:", pc);
+        return false;
+      }
+    }
+
+    start = ledCode;
+    stop = length;
+  }
+
+  program = _program;
+  frameStart = 1;
+  ledStart = ledCode;
+  end = length;
+  memset(registers, 0, sizeof (registers));
+
+  DEBUG3_VALUE("VM: loaded len:", length);
+  DEBUG3_VALUELN(" led code:", ledCode);
+  return true;
+}
+
+void PatternVM::frame(uint16_t time) {
+  if (program == NULL) return;
+
+  /* The results of the last frame become the previous results */
+  byte *swap = previous;
+  previous = current;
+  current = swap;
+
+  run(frameStart, ledStart, 0, time);
+
+  for (geo_led_t led = 0; led < numLeds; led++) {
+    current[led] = run(ledStart, end, led, time);
+  }
+}
+
+/*
+ * Run the code from pc up to stop, returning the value on the top of the
+ * stack.  A program that overflows or underflows the stack stops early.
+ */
+int16_t PatternVM::run(byte pc, byte stop, geo_led_t led, uint16_t time) {
+  int16_t stack[VM_STACK_SIZE];
+  int8_t top = -1;
+
+#define VM_NEED(count) if (top + 1 < (count)) goto done
+#define VM_ROOM() if (top + 1 >= VM_STACK_SIZE) goto done
+
+  while (pc < stop) {
+    byte op = program[pc++];
+    switch (op) {
+      case VM_END: goto done;
+
+      case VM_PUSH: VM_ROOM();
+        stack[++top] = (int8_t)program[pc++];
+        break;
+      case VM_PUSH16: VM_ROOM();
+        stack[++top] = (program[pc] << 8) | program[pc + 1];
+        pc += 2;
+        break;
+      case VM_LED: VM_ROOM();
+        stack[++top] = led;
+        break;
+      case VM_TIME: VM_ROOM();
+        stack[++top] = time;
+        break;
+      case VM_RAND: VM_ROOM();
+        stack[++top] = random8();
+        break;
+      case VM_LOAD: VM_ROOM();
+        stack[++top] = registers[program[pc++]];
+        break;
+      case VM_STORE: VM_NEED(1);
+        registers[program[pc++]] = stack[top--];
+        break;
+      case VM_SELF: VM_ROOM();
+        stack[++top] = previous[led];
+        break;
+      case VM_NEIGHBOR: VM_ROOM();
+        stack[++top] =
+                previous[neighbors[led * LED_MAX_NEIGHBORS + program[pc++]]];
+        break;
+
+      case VM_DUP: VM_NEED(1); VM_ROOM();
+        stack[top + 1] = stack[top];
+        top++;
+        break;
+      case VM_DROP: VM_NEED(1);
+        top--;
+        break;
+      case VM_SWAP: {
+        VM_NEED(2);
+        int16_t b = stack[top];
+        stack[top] = stack[top - 1];
+        stack[top - 1] = b;
+        break;
+      }
+
+      case VM_ADD: VM_NEED(2);
+        stack[top - 1] += stack[top];
+        top--;
+        break;
+      case VM_SUB: VM_NEED(2);
+        stack[top - 1] -= stack[top];
+        top--;
+        break;
+      case VM_MUL: VM_NEED(2);
+        stack[top - 1] = ((int32_t)stack[top - 1] * stack[top]) >> 8;
+        top--;
+        break;
+      case VM_DIV: VM_NEED(2);
+        stack[top - 1] = stack[top] ? stack[top - 1] / stack[top] : 0;
+        top--;
+        break;
+      case VM_MOD: VM_NEED(2);
+        stack[top - 1] = stack[top] ? stack[top - 1] % stack[top] : 0;
+        top--;
+        break;
+      case VM_AND: VM_NEED(2);
+        stack[top - 1] &= stack[top];
+        top--;
+        break;
+      case VM_OR: VM_NEED(2);
+        stack[top - 1] |= stack[top];
+        top--;
+        break;
+      case VM_XOR: VM_NEED(2);
+        stack[top - 1] ^= stack[top];
+        top--;
+        break;
+      case VM_SHL: VM_NEED(1);
+        stack[top] <<= program[pc++];
+        break;
+      case VM_SHR: VM_NEED(1);
+        stack[top] >>= program[pc++];
+        break;
+      case VM_LT: VM_NEED(2);
+        stack[top - 1] = (stack[top - 1] < stack[top]);
+        top--;
+        break;
+      case VM_EQ: VM_NEED(2);
+        stack[top - 1] = (stack[top - 1] == stack[top]);
+        top--;
+        break;
+      case VM_SIN: VM_NEED(1);
+        stack[top] = sin8((byte)stack[top]);
+        break;
+
+      case VM_JZ: VM_NEED(1);
+        if (stack[top--] == 0) pc += program[pc];
+        pc++;
+        break;
+      case VM_JMP:
+        pc += program[pc] + 1;
+        break;
+    }
+  }
+
+#undef VM_NEED
+#undef VM_ROOM
+
+ done:
+  return (top >= 0) ? stack[top] : 0;
+}
@@ -0,0 +1,112 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Small stack machine for light patterns that are sent to a module as data
+ * rather than compiled into it.
+ *
+ * A program is a byte for the length of its frame code, then the frame code,
+ * then the LED code.  Each frame the frame code runs once, typically to
+ * compute values into the registers, and then the LED code runs for every
+ * LED.  The value left on the top of the stack by the LED code is the LED's
+ * result for the frame, which the caller maps to a color.
+ *
+ * Values are 16 bit, with MUL treating them as 8.8 fixed point.  Jumps only
+ * go forward so every program finishes, and programs are checked when loaded
+ * so that running them needs no checks beyond the stack depth: every operand
+ * is in range and every jump lands on the start of an instruction.
+ ******************************************************************************/
+
+#ifndef PATTERNVM_H
+#define PATTERNVM_H
+
+#include <Arduino.h>
+
+#include "LedGraph.h"
+
+#define VM_MAX_PROGRAM   48
+#define VM_STACK_SIZE    8
+#define VM_NUM_REGISTERS 4
+
+/*
+ * Opcodes.  These are numbered without gaps so that the dispatch switch is
+ * compiled to a jump table.  Operands follow the opcode in the program, and
+ * "a b" are the values below and on the top of the stack.
+ */
+#define VM_END      0x00 // Stop
+#define VM_PUSH     0x01 // <byte> Push a signed byte
+#define VM_PUSH16   0x02 // <high> <low> Push a 16 bit value
+#define VM_LED      0x03 // Push the LED's index
+#define VM_TIME     0x04 // Push the frame time
+#define VM_RAND     0x05 // Push a random byte
+#define VM_LOAD     0x06 // <reg> Push a register
+#define VM_STORE    0x07 // <reg> Pop into a register
+#define VM_SELF     0x08 // Push this LED's result from the previous frame
+#define VM_NEIGHBOR 0x09 // <n> Push the previous result of the nth neighbor
+#define VM_DUP      0x0A
+#define VM_DROP     0x0B
+#define VM_SWAP     0x0C
+#define VM_ADD      0x0D // a + b
+#define VM_SUB      0x0E // a - b
+#define VM_MUL      0x0F // a * b / 256
+#define VM_DIV      0x10 // a / b, 0 if b is 0
+#define VM_MOD      0x11 // a % b, 0 if b is 0
+#define VM_AND      0x12
+#define VM_OR       0x13
+#define VM_XOR      0x14
+#define VM_SHL      0x15 // <bits> Up to 15
+#define VM_SHR      0x16 // <bits> Up to 15
+#define VM_LT       0x17 // 1 if a < b, otherwise 0
+#define VM_EQ       0x18 // 1 if a == b, otherwise 0
+#define VM_SIN      0x19 // Sine of the low byte as a byte, 128 at 0
+#define VM_JZ       0x1A // <skip> Pop and skip forward if it was zero
+#define VM_JMP      0x1B // <skip> Skip forward
+#define VM_NUM_OPS  0x1C
+
+static_assert(sizeof (geo_led_t) == 1,
+              "The neighbor table stores each LED as a byte");
+
+/* Bytes of buffer required for a number of LEDs */
+#define PATTERN_VM_BUFFER_SIZE(leds) ((leds) * (LED_MAX_NEIGHBORS + 2))
+
+class PatternVM {
+ public:
+  PatternVM() {};
+
+  /*
+   * buffer must be at least PATTERN_VM_BUFFER_SIZE(numLeds) bytes, the
+   * neighbors are looked up once here.  The neighbor table holds LEDs as
+   * bytes, so numLeds is at most Geometry::NO_LED.
+   */
+  PatternVM(led_neighbor_t neighbor, geo_led_t numLeds, byte *buffer);
+
+  /*
+   * Check a program and use it for following frames, the program is not
+   * copied.  Returns false and leaves the current program if it is invalid.
+   */
+  boolean load(const byte *program, byte length);
+
+  /* Run the program for a frame */
+  void frame(uint16_t time);
+
+  /* Result of an LED for the last frame */
+  byte value(geo_led_t led) { return current[led]; }
+
+ private:
+  geo_led_t numLeds;
+  byte *neighbors;
+  byte *current;
+  byte *previous;
+
+  const byte *program;
+  byte frameStart;
+  byte ledStart;
+  byte end;
+
+  int16_t registers[VM_NUM_REGISTERS];
+
+  int16_t run(byte pc, byte stop, geo_led_t led, uint16_t time);
+};
+
+#endif
@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+#ifndef DEBUG_LEVEL
+  #define DEBUG_LEVEL DEBUG_MID
+#endif
+#include "Debug.h"
+
+#include "PowerGovernor.h"
+
+PowerGovernor::PowerGovernor() {
+  levels = 0;
+  budget_ma = 0;
+  requested = 255;
+  applied = 255;
+  changed = false;
+}
+
+void PowerGovernor::setBudget(uint16_t _budget_ma) {
+  budget_ma = _budget_ma;
+  changed = true;
+  DEBUG3_VALUELN("Power budget mA:", budget_ma);
+}
+
+void PowerGovernor::setBrightness(byte brightness) {
+  requested = brightness;
+  changed = true;
+}
+
+void PowerGovernor::recount(PixelUtil *pixels) {
+  levels = 0;
+  for (uint16_t pixel = 0; pixel < pixels->numPixels(); pixel++) {
+    levels += channelSum(pixels->getColor(pixel));
+  }
+  changed = true;
+}
+
+boolean PowerGovernor::apply() {
+  if (!changed) return false;
+  changed = false;
+
+  byte brightness = requested;
+
+  if (budget_ma != 0) {
+    /* Current scales with the brightness */
+    uint32_t current = fullCurrent() * requested / 255;
+    if (current > budget_ma) {
+      brightness = (uint32_t)requested * budget_ma / current;
+    }
+  }
+
+  if (brightness != applied) {
+    applied = brightness;
+    FastLED.setBrightness(brightness);
+    DEBUG4_VALUELN("Power brightness:", brightness);
+    return true;
+  }
+
+  return false;
+}
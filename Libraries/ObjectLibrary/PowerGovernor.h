@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Limit on the current drawn by a strand of LEDs.
+ *
+ * The governor keeps the sum of every channel of every pixel, updated as each
+ * changed pixel is written rather than recomputed for each frame, and lowers
+ * the brightness when the estimated current at the requested brightness would
+ * exceed the budget.  The estimate counts only the current through the LEDs,
+ * so the budget should leave room for the strand's idle draw.
+ ******************************************************************************/
+
+#ifndef POWERGOVERNOR_H
+#define POWERGOVERNOR_H
+
+#include <Arduino.h>
+
+#include "PixelUtil.h"
+
+/* Current drawn by one channel of one LED at full brightness */
+#define POWER_MA_PER_CHANNEL 20
+
+class PowerGovernor {
+ public:
+  PowerGovernor();
+
+  /* Limit the current to budget_ma, 0 for no limit */
+  void setBudget(uint16_t budget_ma);
+  uint16_t getBudget() { return budget_ma; }
+
+  /* Brightness to use when the budget allows it */
+  void setBrightness(byte brightness);
+
+  /* A pixel's color is changing from one color to another */
+  void change(uint32_t from, uint32_t to) {
+    uint16_t previous = channelSum(from);
+    levels = (levels > previous) ? levels - previous : 0;
+    levels += channelSum(to);
+    changed = true;
+  }
+
+  /* Recompute the sum from every pixel, for when pixels were set directly */
+  void recount(PixelUtil *pixels);
+
+  /*
+   * Set the brightness for the current colors, call before sending them.
+   * Returns true if the brightness changed.
+   */
+  boolean apply();
+
+  /* Estimated current of the current colors at full brightness */
+  uint32_t fullCurrent() {
+    return levels * POWER_MA_PER_CHANNEL / 255;
+  }
+
+ private:
+  uint32_t levels;     // Sum of all channels of all pixels
+  uint16_t budget_ma;
+  byte requested;      // Brightness when under the budget
+  byte applied;        // Brightness last set
+  boolean changed;     // Colors or brightness changed since the last apply
+
+  static uint16_t channelSum(uint32_t color) {
+    return (byte)(color >> 16) + (byte)(color >> 8) + (byte)color;
+  }
+};
+
+#endif
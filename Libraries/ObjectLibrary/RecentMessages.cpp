@@ -0,0 +1,27 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#include "RecentMessages.h"
+
+RecentMessages::RecentMessages() {
+  next = 0;
+  num = 0;
+}
+
+boolean RecentMessages::check(uint16_t origin, byte sequence) {
+  for (byte i = 0; i < num; i++) {
+    if ((origins[i] == origin) && (sequences[i] == sequence)) return false;
+  }
+
+  origins[next] = origin;
+  sequences[next] = sequence;
+  next = (next + 1) % RECENT_MESSAGES;
+  if (num < RECENT_MESSAGES) num++;
+
+  return true;
+}
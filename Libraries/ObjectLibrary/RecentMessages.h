@@ -0,0 +1,37 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Cache of recently seen message ids, used to ignore copies of a broadcast
+ * that arrive more than once by different routes.
+ *
+ * A message id is the address of the module it originated from plus a
+ * sequence number which that module increments for every new message.
+ ******************************************************************************/
+
+#ifndef RECENTMESSAGES_H
+#define RECENTMESSAGES_H
+
+#include <Arduino.h>
+
+#define RECENT_MESSAGES 4
+
+class RecentMessages {
+ public:
+  RecentMessages();
+
+  /*
+   * Returns true if the message hasn't been seen recently, in which case it
+   * is recorded as seen.
+   */
+  boolean check(uint16_t origin, byte sequence);
+
+ private:
+  uint16_t origins[RECENT_MESSAGES];
+  byte sequences[RECENT_MESSAGES];
+  byte next;
+  byte num;
+};
+
+#endif
@@ -0,0 +1,116 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+#ifndef DEBUG_LEVEL
+  #define DEBUG_LEVEL DEBUG_MID
+#endif
+#include "Debug.h"
+
+#include "Ripples.h"
+
+Ripples::Ripples(led_neighbor_t _neighbor, geo_led_t _numLeds,
+                 byte *_distances,
+                 uint16_t _ms_per_hop, byte _width, uint16_t _lifetime_ms) {
+  neighbor = _neighbor;
+  numLeds = _numLeds;
+  distances = _distances;
+  ms_per_hop = max(_ms_per_hop, 1);
+  width = max(_width, 1);
+  lifetime_ms = max(_lifetime_ms, 1);
+  active = 0;
+
+  for (byte row = 0; row < RIPPLE_MAX; row++) {
+    sources[row] = Geometry::NO_LED;
+  }
+}
+
+void Ripples::splash(geo_led_t source, CRGB color, unsigned long now) {
+  if (source >= numLeds) return;
+
+  /* Use a free ripple, or replace the oldest one */
+  byte slot = 0;
+  for (byte r = 0; r < RIPPLE_MAX; r++) {
+    if (!(active & (1 << r))) {
+      slot = r;
+      break;
+    }
+    if (ripples[r].start_ms < ripples[slot].start_ms) slot = r;
+  }
+  active &= ~(1 << slot);
+
+  /*
+   * Reuse the distances if already computed for this source, otherwise
+   * replace a row that no active ripple is using.
+   */
+  byte row = RIPPLE_MAX;
+  byte used = 0;
+  for (byte r = 0; r < RIPPLE_MAX; r++) {
+    if (active & (1 << r)) used |= (1 << ripples[r].row);
+  }
+  for (byte r = 0; r < RIPPLE_MAX; r++) {
+    if (sources[r] == source) {
+      row = r;
+      break;
+    }
+    if ((row == RIPPLE_MAX) && !(used & (1 << r))) row = r;
+  }
+  if (sources[row] != source) {
+    ledHopDistances(neighbor, numLeds, source, &distances[row * numLeds]);
+    sources[row] = source;
+    DEBUG4_VALUE("Ripple distances source:", source);
+    DEBUG4_VALUELN(" row:", row);
+  }
+
+  ripples[slot].row = row;
+  ripples[slot].color = color;
+  ripples[slot].start_ms = now;
+  ripples[slot].front = 0;
+  ripples[slot].level = 255;
+  active |= (1 << slot);
+}
+
+boolean Ripples::update(unsigned long now) {
+  for (byte r = 0; r < RIPPLE_MAX; r++) {
+    if (!(active & (1 << r))) continue;
+
+    unsigned long elapsed = now - ripples[r].start_ms;
+    if (elapsed >= lifetime_ms) {
+      active &= ~(1 << r);
+      continue;
+    }
+
+    ripples[r].front = min(elapsed * 256 / ms_per_hop, (uint32_t)0xFFFF);
+    ripples[r].level = 255 - elapsed * 255 / lifetime_ms;
+  }
+
+  return (active != 0);
+}
+
+CRGB Ripples::color(geo_led_t led) {
+  CRGB result = CRGB::Black;
+
+  for (byte r = 0; r < RIPPLE_MAX; r++) {
+    if (!(active & (1 << r))) continue;
+
+    byte hops = distances[ripples[r].row * numLeds + led];
+    if (hops == LED_NO_HOPS) continue;
+
+    /* Intensity falls off linearly with distance from the wavefront */
+    uint16_t position = (uint16_t)hops << 8;
+    uint16_t diff = (position > ripples[r].front) ?
+                    position - ripples[r].front : ripples[r].front - position;
+    if (diff >= ((uint16_t)width << 8)) continue;
+
+    byte intensity = scale8(255 - diff / width, ripples[r].level);
+    CRGB color = ripples[r].color;
+    result += color.nscale8(intensity);
+  }
+
+  return result;
+}
@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Ripples of color that spread outward from a point and decay over time.
+ *
+ * Each ripple is a wavefront at a distance determined by its age, and an LED's
+ * color is computed by comparing its hop distance from each ripple's source
+ * against that wavefront.  Hop distances are computed once per splash source,
+ * so rendering a frame is O(LEDs x active ripples) with no graph traversal.
+ ******************************************************************************/
+
+#ifndef RIPPLES_H
+#define RIPPLES_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+#include "LedGraph.h"
+
+#define RIPPLE_MAX 3
+
+typedef struct {
+  byte row;                // Row of hop distances for the source
+  CRGB color;
+  unsigned long start_ms;
+
+  uint16_t front;          // Wavefront position in 1/256 hops
+  byte level;              // Brightness after decay
+} ripple_t;
+
+class Ripples {
+ public:
+  Ripples() {};
+
+  /*
+   * distances must have room for RIPPLE_MAX * numLeds bytes.  Wavefronts
+   * advance a hop every ms_per_hop, are width hops wide, and fade out over
+   * lifetime_ms.
+   */
+  Ripples(led_neighbor_t neighbor, geo_led_t numLeds, byte *distances,
+          uint16_t ms_per_hop, byte width, uint16_t lifetime_ms);
+
+  /* Start a new ripple, replacing the oldest if all are in use */
+  void splash(geo_led_t source, CRGB color, unsigned long now);
+
+  /* Advance all ripples, returns false if none are active */
+  boolean update(unsigned long now);
+
+  /* Color of an LED from all active ripples as of the last update */
+  CRGB color(geo_led_t led);
+
+  uint16_t ms_per_hop;
+  byte width;
+  uint16_t lifetime_ms;
+
+ private:
+  led_neighbor_t neighbor;
+  geo_led_t numLeds;
+  byte *distances;
+  geo_led_t sources[RIPPLE_MAX]; // Source of each row of distances
+
+  ripple_t ripples[RIPPLE_MAX];
+  byte active;                   // Bitmask of active ripples
+};
+
+#endif
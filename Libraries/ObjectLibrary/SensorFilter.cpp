@@ -0,0 +1,43 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#include "SensorFilter.h"
+
+SensorFilter::SensorFilter(byte _shift, uint16_t _hysteresis) {
+  shift = _shift;
+  hysteresis = _hysteresis;
+  average = 0;
+  published = 0;
+  primed = false;
+}
+
+boolean SensorFilter::add(uint16_t reading) {
+  uint16_t scaled = reading << SENSOR_FILTER_FRACTION;
+
+  /* The first reading is taken as is rather than averaged up from zero */
+  if (!primed) {
+    primed = true;
+    average = scaled;
+    published = reading;
+    return true;
+  }
+
+  /* A 12 bit reading scaled up doesn't fit an int16_t, so step in 32 bits */
+  average += ((int32_t)scaled - (int32_t)average) >> shift;
+
+  uint16_t smoothed = (average + (1 << (SENSOR_FILTER_FRACTION - 1)))
+                      >> SENSOR_FILTER_FRACTION;
+  uint16_t difference = (smoothed > published) ? smoothed - published
+                                               : published - smoothed;
+  if (difference >= hysteresis) {
+    published = smoothed;
+    return true;
+  }
+
+  return false;
+}
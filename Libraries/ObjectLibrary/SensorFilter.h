@@ -0,0 +1,43 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Smoothing of a slowly changing analog sensor such as a knob or a photo
+ * sensor.  Readings are averaged with an exponential moving average, and the
+ * value seen by the rest of the sketch only changes once the average has
+ * moved by more than a hysteresis from it, so noise around a level doesn't
+ * cause a stream of small changes.
+ ******************************************************************************/
+
+#ifndef SENSORFILTER_H
+#define SENSORFILTER_H
+
+#include <Arduino.h>
+
+/* Fractional bits kept in the average, readings may be up to 12 bits */
+#define SENSOR_FILTER_FRACTION 4
+
+class SensorFilter {
+ public:
+  /*
+   * Each reading moves the average 1/2^shift of the way towards it, and the
+   * value changes when the average is hysteresis away from it.
+   */
+  SensorFilter(byte shift = 3, uint16_t hysteresis = 4);
+
+  /* Add a reading, returns true if the value changed */
+  boolean add(uint16_t reading);
+
+  /* Smoothed value, or 0 if there have been no readings */
+  uint16_t value() { return published; }
+
+ private:
+  uint16_t average;    // With SENSOR_FILTER_FRACTION fractional bits
+  uint16_t published;
+  uint16_t hysteresis;
+  byte shift;
+  boolean primed;      // Set once there has been a reading
+};
+
+#endif
@@ -0,0 +1,132 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+//#define DEBUG_LEVEL DEBUG_HIGH
+#include "Debug.h"
+
+#include "SerialDemux.h"
+
+#define STATE_IDLE    0 // Between messages and commands
+#define STATE_MSG     1 // Reading an HMTL message
+#define STATE_LINE    2 // Reading a CLI command
+#define STATE_DISCARD 3 // Skipping the rest of an overlong command
+
+/* Bytes of the header needed to know a message's length */
+#define MSG_LENGTH_BYTES (offsetof(msg_hdr_t, length) + sizeof (((msg_hdr_t *)0)->length))
+
+SerialDemux::SerialDemux(byte *_buffer, uint16_t _size,
+                         serial_msg_handler_t _msgHandler,
+                         serial_cli_handler_t _cliHandler) {
+  buffer = _buffer;
+  size = _size;
+  msgHandler = _msgHandler;
+  cliHandler = _cliHandler;
+  last_ms = 0;
+  memset(&stats, 0, sizeof (stats));
+  reset();
+}
+
+boolean SerialDemux::check(Stream *serial) {
+  boolean update = false;
+  unsigned long now = millis();
+
+  if ((state == STATE_MSG) && (now - last_ms > SERIAL_DEMUX_TIMEOUT_MS)) {
+    /* Bytes of the message were lost, start over from the next byte */
+    DEBUG3_VALUELN("SerialDemux: timeout len:", used);
+    stats.dropped++;
+    reset();
+  }
+
+  for (byte count = 0; count < SERIAL_DEMUX_MAX_BYTES; count++) {
+    int c = serial->read();
+    if (c < 0) break;
+
+    last_ms = now;
+    if (handleByte((byte)c)) update = true;
+  }
+
+  return update;
+}
+
+boolean SerialDemux::handleByte(byte c) {
+  switch (state) {
+    case STATE_IDLE: {
+      if (c == HMTL_MSG_START) {
+        state = STATE_MSG;
+        buffer[used++] = c;
+      } else if ((c != '\n') && (c != '\r')) {
+        state = STATE_LINE;
+        buffer[used++] = c;
+      }
+      break;
+    }
+
+    case STATE_MSG: {
+      buffer[used++] = c;
+
+      if ((expected == 0) && (used == MSG_LENGTH_BYTES)) {
+        expected = ((msg_hdr_t *)buffer)->length;
+        if ((expected < sizeof (msg_hdr_t)) || (expected > size)) {
+          DEBUG3_VALUELN("SerialDemux: bad len:", expected);
+          stats.dropped++;
+          reset();
+          break;
+        }
+      }
+
+      if (used == expected) {
+        stats.messages++;
+        boolean update = msgHandler((msg_hdr_t *)buffer);
+        reset();
+        return update;
+      }
+      break;
+    }
+
+    case STATE_LINE: {
+      if ((c == '\n') || (c == '\r')) {
+        buffer[used] = 0;
+        handleLine();
+        reset();
+      } else if (used < size - 1) {
+        buffer[used++] = c;
+      } else {
+        stats.dropped++;
+        state = STATE_DISCARD;
+      }
+      break;
+    }
+
+    case STATE_DISCARD: {
+      if ((c == '\n') || (c == '\r')) reset();
+      break;
+    }
+  }
+
+  return false;
+}
+
+/* Split the command into whitespace separated tokens in place */
+void SerialDemux::handleLine() {
+  char *tokens[SERIAL_DEMUX_MAX_TOKENS];
+  byte numtokens = 0;
+
+  char *line = (char *)buffer;
+  while (*line && (numtokens < SERIAL_DEMUX_MAX_TOKENS)) {
+    while ((*line == ' ') || (*line == '\t')) *line++ = 0;
+    if (!*line) break;
+
+    tokens[numtokens++] = line;
+    while (*line && (*line != ' ') && (*line != '\t')) line++;
+  }
+
+  if (numtokens > 0) {
+    stats.commands++;
+    cliHandler(tokens, numtokens);
+  }
+}
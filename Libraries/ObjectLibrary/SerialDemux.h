@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Reader for a serial port that carries both HMTL messages and CLI commands.
+ *
+ * Bytes are consumed as they arrive and the port is never waited on.  A byte
+ * of HMTL_MSG_START begins a binary message, which is complete once the
+ * length from its header has been read.  Anything else begins a text
+ * command, which is complete at the end of the line.  Completed messages and
+ * commands are passed to the handlers from within check().
+ ******************************************************************************/
+
+#ifndef SERIALDEMUX_H
+#define SERIALDEMUX_H
+
+#include <Arduino.h>
+#include "HMTLMessaging.h"
+
+/* Most bytes handled per check, so a burst can't stall the caller */
+#define SERIAL_DEMUX_MAX_BYTES 64
+
+/* A message that stalls this long is abandoned */
+#define SERIAL_DEMUX_TIMEOUT_MS 250
+
+#define SERIAL_DEMUX_MAX_TOKENS 8
+
+typedef boolean (*serial_msg_handler_t)(msg_hdr_t *msg);
+typedef void (*serial_cli_handler_t)(char **tokens, byte numtokens);
+
+typedef struct {
+  uint16_t messages;  // HMTL messages handled
+  uint16_t commands;  // CLI commands handled
+  uint16_t dropped;   // Messages or commands discarded as invalid or too long
+} serial_demux_stats_t;
+
+class SerialDemux {
+ public:
+  SerialDemux(byte *buffer, uint16_t size,
+              serial_msg_handler_t msgHandler,
+              serial_cli_handler_t cliHandler);
+
+  /*
+   * Read the bytes available from the port, returning true if any message
+   * handler reported an update.
+   */
+  boolean check(Stream *serial);
+
+  serial_demux_stats_t stats;
+
+ private:
+  byte *buffer;
+  uint16_t size;
+  uint16_t used;
+  uint16_t expected;  // Length of the message being read, 0 if not yet known
+  byte state;
+  unsigned long last_ms;
+
+  serial_msg_handler_t msgHandler;
+  serial_cli_handler_t cliHandler;
+
+  boolean handleByte(byte c);
+  void handleLine();
+  void reset() { state = 0; used = 0; expected = 0; }
+};
+
+#endif
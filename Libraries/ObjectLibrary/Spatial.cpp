@@ -0,0 +1,61 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+#include "Spatial.h"
+
+byte spatialProject(geo_point_t point, byte projection, geo_point_t origin) {
+  switch (projection) {
+    case SPATIAL_HEIGHT: {
+      int16_t z = constrain(point.z, -GEO_COORD_MAX, GEO_COORD_MAX);
+      return (byte)((z + GEO_COORD_MAX) * 255 / (2 * GEO_COORD_MAX));
+    }
+    case SPATIAL_AZIMUTH: {
+      return spatialAngle(point.x - origin.x, point.y - origin.y);
+    }
+    case SPATIAL_DISTANCE: {
+      return spatialDistance(point, origin);
+    }
+  }
+  return 0;
+}
+
+/*
+ * Integer approximation of atan2 (within about 1 unit), where a full circle is
+ * 256 units and 0 is along the positive x axis.
+ */
+byte spatialAngle(int16_t x, int16_t y) {
+  uint16_t ax = abs(x);
+  uint16_t ay = abs(y);
+  if ((ax == 0) && (ay == 0)) return 0;
+
+  /* Ratio of the smaller to larger value as 0-256, giving an angle of 0-45 */
+  uint16_t t;
+  boolean steep = (ay > ax);
+  if (steep) t = (uint32_t)ax * 256 / ay;
+  else       t = (uint32_t)ay * 256 / ax;
+
+  /* atan(t) ~= t * pi/4 + 0.273 * t * (1 - t) */
+  byte angle = (byte)((32 * t + ((uint32_t)11 * t * (256 - t) >> 8)) >> 8);
+
+  if (steep)  angle = 64 - angle;
+  if (x < 0)  angle = 128 - angle;
+  if (y < 0)  angle = (byte)(256 - angle);
+  return angle;
+}
+
+byte spatialDistance(geo_point_t a, geo_point_t b) {
+  /* Halve the deltas so the sum of squares fits in 16 bits */
+  int16_t dx = ((int16_t)a.x - b.x) / 2;
+  int16_t dy = ((int16_t)a.y - b.y) / 2;
+  int16_t dz = ((int16_t)a.z - b.z) / 2;
+  uint16_t sum = (uint16_t)(dx * dx) + (uint16_t)(dy * dy) +
+                 (uint16_t)(dz * dz);
+  uint16_t dist = sqrt16(sum);
+  return (byte)min((uint32_t)255, (uint32_t)dist * 255 / GEO_COORD_MAX);
+}
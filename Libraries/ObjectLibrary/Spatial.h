@@ -0,0 +1,33 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Projections of object positions onto byte values, used to build per-LED
+ * lookup tables for spatial effects.
+ ******************************************************************************/
+
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include <Arduino.h>
+
+#include "PixelUtil.h"
+#include "Geometry.h"
+
+/* Available projections */
+#define SPATIAL_HEIGHT   0 // Bottom to top
+#define SPATIAL_AZIMUTH  1 // Angle around the vertical axis
+#define SPATIAL_DISTANCE 2 // Distance from the origin point
+#define SPATIAL_NUM_PROJECTIONS 3
+
+/* Project a point to a 0-255 value */
+byte spatialProject(geo_point_t point, byte projection, geo_point_t origin);
+
+/* Angle of x,y as 0-255 for a full rotation */
+byte spatialAngle(int16_t x, int16_t y);
+
+/* Distance between two points, with 255 being 2 * GEO_COORD_MAX */
+byte spatialDistance(geo_point_t a, geo_point_t b);
+
+#endif
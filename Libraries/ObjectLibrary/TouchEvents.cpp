@@ -0,0 +1,143 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+//#define DEBUG_LEVEL DEBUG_HIGH
+#include "Debug.h"
+
+#include "TouchEvents.h"
+
+#define QUEUE_NEXT(index) (((index) + 1) & (TOUCH_QUEUE_SIZE - 1))
+
+TouchEventQueue::TouchEventQueue() {
+  head = 0;
+  tail = 0;
+}
+
+boolean TouchEventQueue::push(unsigned long ms, byte sensor, boolean touched) {
+  byte next = QUEUE_NEXT(head);
+  if (next == tail) return false;
+
+  events[head].ms = ms;
+  events[head].sensor = sensor;
+  events[head].touched = touched;
+
+  /* Only publish the event once it has been written */
+  head = next;
+  return true;
+}
+
+boolean TouchEventQueue::peek(touch_event_t *event) {
+  if (empty()) return false;
+  *event = events[tail];
+  return true;
+}
+
+void TouchEventQueue::pop() {
+  if (!empty()) tail = QUEUE_NEXT(tail);
+}
+
+
+#define STATE_TOUCHED  0x1
+#define STATE_LONG     0x2 // The long press has been reported
+#define STATE_PRESSED  0x4 // There has been at least one earlier press
+
+TouchGestures::TouchGestures(byte _numSensors, touch_state_t *_state,
+                             uint16_t _double_ms, uint16_t _long_ms) {
+  numSensors = min(_numSensors, TOUCH_MAX_SENSORS);
+  state = _state;
+  touched_mask = 0;
+  double_ms = _double_ms;
+  long_ms = _long_ms;
+
+  swipe_next = NULL;
+  swipe_ms = 0;
+  last_press = TOUCH_NO_SENSOR;
+
+  for (byte sensor = 0; sensor < numSensors; sensor++) {
+    state[sensor].press_ms = 0;
+    state[sensor].flags = 0;
+  }
+}
+
+void TouchGestures::setSwipes(const byte *next, uint16_t _swipe_ms) {
+  swipe_next = next;
+  swipe_ms = _swipe_ms;
+}
+
+byte TouchGestures::event(const touch_event_t *event) {
+  if (event->sensor >= numSensors) return 0;
+  touch_state_t *s = &state[event->sensor];
+  byte gestures = 0;
+
+  if (event->touched) {
+    if (s->flags & STATE_TOUCHED) return 0; // Repeated touch
+
+    gestures |= TOUCH_PRESS;
+    if ((s->flags & STATE_PRESSED) &&
+        (event->ms - s->press_ms < double_ms)) {
+      gestures |= TOUCH_DOUBLE;
+    }
+
+    /* A swipe is a press just after a press on an adjacent sensor */
+    if ((swipe_next != NULL) && (last_press != TOUCH_NO_SENSOR) &&
+        (event->ms - state[last_press].press_ms < swipe_ms)) {
+      if (pgm_read_byte(&swipe_next[last_press]) == event->sensor) {
+        gestures |= TOUCH_SWIPE_NEXT;
+      } else if (pgm_read_byte(&swipe_next[event->sensor]) == last_press) {
+        gestures |= TOUCH_SWIPE_PREV;
+      }
+    }
+    last_press = event->sensor;
+
+    s->press_ms = event->ms;
+    s->flags = STATE_TOUCHED | STATE_PRESSED;
+    touched_mask |= ((uint32_t)1 << event->sensor);
+  } else {
+    if (!(s->flags & STATE_TOUCHED)) return 0; // Repeated release
+
+    gestures |= TOUCH_RELEASE;
+    if (!(s->flags & STATE_LONG)) {
+      if (event->ms - s->press_ms >= long_ms) {
+        /* The long press wasn't polled before the release */
+        gestures |= TOUCH_LONG;
+      } else {
+        gestures |= TOUCH_TAP;
+      }
+    }
+
+    s->flags &= ~(STATE_TOUCHED | STATE_LONG);
+    touched_mask &= ~((uint32_t)1 << event->sensor);
+  }
+
+  return gestures;
+}
+
+byte TouchGestures::poll(unsigned long now, touch_gesture_t *results,
+                         byte max) {
+  byte count = 0;
+  uint32_t mask = touched_mask;
+
+  for (byte sensor = 0; mask && (count < max); sensor++, mask >>= 1) {
+    if (!(mask & 0x1)) continue;
+
+    touch_state_t *s = &state[sensor];
+    if (!(s->flags & STATE_LONG) && (now - s->press_ms >= long_ms)) {
+      s->flags |= STATE_LONG;
+      results[count].sensor = sensor;
+      results[count].gestures = TOUCH_LONG;
+      count++;
+    }
+  }
+
+  return count;
+}
+
+boolean TouchGestures::touched(byte sensor) {
+  if (sensor >= numSensors) return false;
+  return (touched_mask & ((uint32_t)1 << sensor));
+}
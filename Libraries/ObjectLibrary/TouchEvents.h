@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Timestamped touch events and the gestures derived from them.
+ *
+ * Touch and release events are queued with the time they happened so that
+ * taps, double-taps and long presses are determined from those times rather
+ * than from how often the main loop gets around to checking the sensors.
+ * TouchGestures doesn't touch any hardware, so it can be driven by a
+ * synthetic stream of events.
+ ******************************************************************************/
+
+#ifndef TOUCHEVENTS_H
+#define TOUCHEVENTS_H
+
+#include <Arduino.h>
+
+typedef struct {
+  unsigned long ms;  // Time of the change
+  byte sensor;
+  boolean touched;   // True for a touch, false for a release
+} touch_event_t;
+
+/*
+ * Queue of touch events with a single producer and a single consumer.  The
+ * producer only writes head and the consumer only writes tail, so events can
+ * be pushed from an interrupt handler without disabling interrupts.
+ */
+#define TOUCH_QUEUE_SIZE 8 // Must be a power of 2
+
+class TouchEventQueue {
+ public:
+  TouchEventQueue();
+
+  /* Returns false if the queue is full and the event was dropped */
+  boolean push(unsigned long ms, byte sensor, boolean touched);
+
+  /* Returns false if the queue is empty */
+  boolean peek(touch_event_t *event);
+  void pop();
+
+  boolean empty() { return head == tail; }
+
+ private:
+  touch_event_t events[TOUCH_QUEUE_SIZE];
+  volatile byte head;
+  volatile byte tail;
+};
+
+/* Gestures returned by TouchGestures */
+#define TOUCH_PRESS      0x01 // Sensor became touched
+#define TOUCH_RELEASE    0x02 // Sensor was released
+#define TOUCH_TAP        0x04 // Released before becoming a long press
+#define TOUCH_DOUBLE     0x08 // Touched again shortly after a previous touch
+#define TOUCH_LONG       0x10 // Held for the long press time, reported once
+#define TOUCH_SWIPE_NEXT 0x20 // Pressed just after the sensor before it
+#define TOUCH_SWIPE_PREV 0x40 // Pressed just after the sensor after it
+
+#define TOUCH_MAX_SENSORS 32  // Limited by the touched mask
+#define TOUCH_NO_SENSOR   0xFF
+
+/* A sensor and the gestures it completed */
+typedef struct {
+  byte sensor;
+  byte gestures;
+} touch_gesture_t;
+
+/* Per-sensor state, the caller provides one for every sensor */
+typedef struct {
+  unsigned long press_ms;
+  byte flags;
+} touch_state_t;
+
+class TouchGestures {
+ public:
+  TouchGestures(byte numSensors, touch_state_t *state,
+                uint16_t double_ms, uint16_t long_ms);
+
+  /*
+   * Sensors that form a strip for swipes.  next is a PROGMEM table giving
+   * for each sensor the sensor that follows it, or TOUCH_NO_SENSOR.  A press
+   * within swipe_ms of a press on the sensor before or after it is a swipe.
+   */
+  void setSwipes(const byte *next, uint16_t swipe_ms);
+
+  /* Process an event, returning the gestures that it completes */
+  byte event(const touch_event_t *event);
+
+  /*
+   * Check for gestures that depend only on time passing, this only visits
+   * the sensors that are currently touched.  Returns the number of gestures
+   * written to the results.
+   */
+  byte poll(unsigned long now, touch_gesture_t *results, byte max);
+
+  boolean touched(byte sensor);
+  uint32_t touchedMask() { return touched_mask; }
+
+  /* Time at which a touched sensor became touched */
+  unsigned long pressedMs(byte sensor) { return state[sensor].press_ms; }
+
+ private:
+  byte numSensors;
+  touch_state_t *state;
+  uint32_t touched_mask;
+
+  uint16_t double_ms;
+  uint16_t long_ms;
+
+  const byte *swipe_next;
+  uint16_t swipe_ms;
+  byte last_press;
+};
+
+#endif
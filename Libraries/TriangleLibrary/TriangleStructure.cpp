@@ -6,11 +6,15 @@
 #include "EEPromUtils.h"
 
 #include "PixelUtil.h"
+#include "Spatial.h"
 #include "TriangleStructure.h"
 
 // XXX: Relying on an array allocated by the main sketch feels icky
 extern Triangle *triangles;
 
+ColorCalibration triangleCalibration;
+PowerGovernor trianglePower;
+
 Triangle::Triangle(geo_id_t _id) {
   updated = false;
   mark = 0;
@@ -24,6 +28,8 @@ Triangle::Triangle(geo_id_t _id) {
     leds[v].pixel = NO_LED;
   }
 
+  setCenter(GEO_NO_COORD, GEO_NO_COORD, GEO_NO_COORD);
+
   DEBUG3_VALUELN("Created Triangle id:", id);
 }
 
@@ -308,6 +314,27 @@ Triangle *Triangle::rightOfVertex(byte vertex) {
   return getEdge(vertex);
 }
 
+/*
+ * Return the approximate position of an LED.  The LEDs sit in the corners, so
+ * this is taken as the midpoint of the centers of the two triangles that
+ * share edges at that vertex, which is halfway between the center of this
+ * triangle and the vertex.
+ */
+geo_point_t Triangle::ledPoint(byte led) {
+  Triangle *left = leftOfVertex(led);
+  Triangle *right = rightOfVertex(led);
+  if ((left == NULL) || (right == NULL) ||
+      !left->hasCenter() || !right->hasCenter()) {
+    return center;
+  }
+
+  geo_point_t point;
+  point.x = ((int16_t)left->center.x + right->center.x) / 2;
+  point.y = ((int16_t)left->center.y + right->center.y) / 2;
+  point.z = ((int16_t)left->center.z + right->center.z) / 2;
+  return point;
+}
+
 /*
  * Print a representation of the triangle
  */
@@ -325,6 +352,12 @@ void Triangle::print() {
     }
   }
 
+  if (hasCenter()) {
+    DEBUG2_VALUE("\tc:", center.x);
+    DEBUG2_VALUE(",", center.y);
+    DEBUG2_VALUE(",", center.z);
+  }
+
   DEBUG2_PRINTLN("");
 }
 
@@ -350,6 +383,16 @@ void setLeds(Triangle *triangles, int tri, int led1, int led2, int led3) {
   triangles[tri].setLedPixels(led1, led2, led3);
 }
 
+/* Set the centers of all triangles from a table in program memory */
+void setCenters(Triangle *triangles, int triangleCount,
+                const int8_t centers[][3]) {
+  for (int tri = 0; tri < triangleCount; tri++) {
+    triangles[tri].setCenter((int8_t)pgm_read_byte(&centers[tri][0]),
+                             (int8_t)pgm_read_byte(&centers[tri][1]),
+                             (int8_t)pgm_read_byte(&centers[tri][2]));
+  }
+}
+
 /* Initialize the triangle array */
 Triangle triangleArray[TRI_ARRAY_SIZE];
 
@@ -388,7 +431,24 @@ Triangle* initTriangles(int triangleCount) {
  *         \    /\    /\    /\    /\    /\
  *          \20/21\22/23\24/25\26/27\28/29\
  *           \/____\/____\/____\/____\/____\
+ *
+ * The centers are for a cylinder around the z axis with triangle 0 on the x
+ * axis, and the rows shifted a half triangle further around each row down.
  */
+const int8_t cylinderCenters[30][3] PROGMEM = {
+  {  65,   0,  77}, {  53,  38,  55}, {  20,  62,  77}, { -20,  62,  55},
+  { -53,  38,  77}, { -65,   0,  55}, { -53, -38,  77}, { -20, -62,  55},
+  {  20, -62,  77}, {  53, -38,  55},
+
+  {  53,  38,  11}, {  20,  62, -11}, { -20,  62,  11}, { -53,  38, -11},
+  { -65,   0,  11}, { -53, -38, -11}, { -20, -62,  11}, {  20, -62, -11},
+  {  53, -38,  11}, {  65,   0, -11},
+
+  {  20,  62, -55}, { -20,  62, -77}, { -53,  38, -55}, { -65,   0, -77},
+  { -53, -38, -55}, { -20, -62, -77}, {  20, -62, -55}, {  53, -38, -77},
+  {  65,   0, -55}, {  53,  38, -77},
+};
+
 Triangle* buildCylinder(int *numTriangles, int numLeds) {
   int triangleCount = 30;
 
@@ -435,6 +495,8 @@ Triangle* buildCylinder(int *numTriangles, int numLeds) {
   }
   *numTriangles = tri;
 
+  setCenters(triangles, triangleCount, cylinderCenters);
+
   DEBUG3_VALUELN("Cylinder numTriangles:", *numTriangles);
 
   return triangles;
@@ -457,7 +519,18 @@ Triangle* buildCylinder(int *numTriangles, int numLeds) {
  *        /\    /\    /\    /\
  *       /3 \8 /  \13/  \7 /2 \
  *      /____\/    \/    \/____\
+ *
+ * The centers place the vertex shared by triangles 0-4 at the top, with
+ * triangles 15-19 around the bottom vertex.
  */
+const int8_t icosohedronCenters[20][3] PROGMEM = {
+  {  58, -19,  79}, {   0, -61,  79}, { -58, -19,  79}, { -36,  49,  79},
+  {  36,  49,  79}, {  93, -30,  19}, {   0, -98,  19}, { -93, -30,  19},
+  { -58,  79,  19}, {  58,  79,  19}, {  93,  30, -19}, {  58, -79, -19},
+  { -58, -79, -19}, { -93,  30, -19}, {   0,  98, -19}, {  58,  19, -79},
+  {  36, -49, -79}, { -36, -49, -79}, { -58,  19, -79}, {   0,  61, -79},
+};
+
 Triangle* buildIcosohedron(int *numTriangles, int numLeds) {
   int triangleCount = 20;
 
@@ -756,6 +829,8 @@ Triangle* buildIcosohedron(int *numTriangles, int numLeds) {
   if (*numTriangles == triangleCount) goto ICOS_DONE;
 
  ICOS_DONE:
+  setCenters(triangles, triangleCount, icosohedronCenters);
+
   DEBUG3_COMMAND(
 		for (int t = 0; t < *numTriangles; t++) {
 		  triangles[t].print();
@@ -773,6 +848,7 @@ Triangle* buildIcosohedron(int *numTriangles, int numLeds) {
  *   ID
  *   IDs of edges
  *   offset of pixels
+ *   center (version 2+)
  * 
  */
 int Triangle::toBytes(byte *bytes, int size) {
@@ -789,6 +865,8 @@ int Triangle::toBytes(byte *bytes, int size) {
     config->leds[led] = leds[led].pixel;
   }
 
+  config->center = center;
+
   return sizeof (triangle_config_t);
 }
 
@@ -808,6 +886,11 @@ void Triangle::fromBytes(byte *bytes, int size, Geometry *triangles,
   for (int led = 0; led < NUM_LEDS; led++ ) {
     leds[led].pixel = config->leds[led];
   }
+
+  // Older configurations don't include the center
+  if (size >= (int)sizeof (triangle_config_t)) {
+    center = config->center;
+  }
 }
 
 // This should be the max of triangle_config_t and geometry_config_t
@@ -831,6 +914,10 @@ int readTriangleStructure(int offset, Triangle **triangles_ptr,
 
   // Copy relevant data from config before next read
   uint16_t readTriangles = config->num_objects;
+  triangleCalibration.set(&config->calibration);
+  trianglePower.setBudget(config->power_budget_ma);
+  int recordSize = (config->version >= 2) ? sizeof (triangle_config_t)
+                                          : TRIANGLE_CONFIG_V1_SZ;
   if (readTriangles > TRI_ARRAY_SIZE) {
     // Override the configured size if it is over the limit
     readTriangles = TRI_ARRAY_SIZE;
@@ -843,7 +930,7 @@ int readTriangleStructure(int offset, Triangle **triangles_ptr,
 
   for (byte face = 0; face < readTriangles; face++) {
     offset = EEPROM_safe_read(offset, bytes, MAX_CONFIG_SZ);
-    triangles[face].fromBytes(bytes, MAX_CONFIG_SZ, 
+    triangles[face].fromBytes(bytes, recordSize,
                               triangles, readTriangles);
 
     DEBUG2_VALUE(" - face=", face);
@@ -874,6 +961,8 @@ int writeTriangleStructure(Triangle *triangles, int numTriangles,
   geometry_config_t *config = (geometry_config_t *)bytes;
   config->version = GEOMETRY_CONFIG_VERSION;
   config->num_objects = numTriangles;
+  config->calibration = *triangleCalibration.get();
+  config->power_budget_ma = trianglePower.getBudget();
   offset = EEPROM_safe_write(offset, bytes, sizeof (geometry_config_t));
 
   for (int tri = 0; tri < numTriangles; tri++) {
@@ -979,17 +1068,91 @@ boolean updateTrianglePixels(Triangle *triangles, int numTriangles,
     if (triangles[tri].updated) {
       update = true;
       for (byte led = 0; led < Triangle::NUM_LEDS; led++) {
-        pixels->setPixelRGB(&(triangles[tri].leds[led]));
+        PRGB *rgb = &(triangles[tri].leds[led]);
+        uint32_t previous = pixels->getColor(rgb->pixel);
+        triangleCalibration.setPixel(pixels, rgb);
+        trianglePower.change(previous, pixels->getColor(rgb->pixel));
       }
       triangles[tri].updated = false;
       updated++;
     }
   }
 
-  if (update) {
+  /* A change of brightness must be sent even if no triangle changed */
+  if (trianglePower.apply() || update) {
     pixels->update();
     DEBUG5_VALUELN("Updated triangles:", updated);
   }
 
   return update;
 }
+
+/*
+ * Return the neighbors of an LED indexed as triangle * Triangle::NUM_LEDS +
+ * vertex.  These are the other two LEDs in the same triangle and the LEDs at
+ * the same vertex in the triangles to the left and right.
+ */
+geo_led_t triangleLedNeighbor(geo_led_t led, byte index) {
+  byte tri = led / Triangle::NUM_LEDS;
+  byte vertex = led % Triangle::NUM_LEDS;
+  Triangle *current = &triangles[tri];
+
+  switch (index) {
+    case 0: return tri * Triangle::NUM_LEDS + VERTEX_CW(vertex);
+    case 1: return tri * Triangle::NUM_LEDS + VERTEX_CCW(vertex);
+    case 2: {
+      Triangle *left = current->leftOfVertex(vertex);
+      if (left == NULL) break;
+      byte match = left->matchVertexRight(current, vertex);
+      if (match == Triangle::NO_VERTEX) break;
+      return left->id * Triangle::NUM_LEDS + match;
+    }
+    case 3: {
+      Triangle *right = current->rightOfVertex(vertex);
+      if (right == NULL) break;
+      byte match = right->matchVertexLeft(current, vertex);
+      if (match == Triangle::NO_VERTEX) break;
+      return right->id * Triangle::NUM_LEDS + match;
+    }
+  }
+
+  return Triangle::NO_LED;
+}
+
+/* Return the current color of an LED indexed as in triangleLedNeighbor */
+CRGB triangleLedColor(geo_led_t led) {
+  return triangles[led / Triangle::NUM_LEDS].leds[led % Triangle::NUM_LEDS].getCRGB();
+}
+
+/*
+ * Fill a lookup table with a projection of every LED's position, indexed by
+ * triangle * Triangle::NUM_LEDS + led.  The table must have room for all the
+ * LEDs.
+ */
+void buildTriangleLUT(Triangle *triangles, int numTriangles,
+                      byte projection, geo_point_t origin, byte *lut) {
+  for (int tri = 0; tri < numTriangles; tri++) {
+    for (byte led = 0; led < Triangle::NUM_LEDS; led++) {
+      lut[tri * Triangle::NUM_LEDS + led] =
+              spatialProject(triangles[tri].ledPoint(led), projection, origin);
+    }
+  }
+}
+
+/*
+ * Hash the colors of all LEDs (FNV-1a).  This is independent of the pixel
+ * mapping, so the same mode rendered from the same seed produces the same
+ * sequence of hashes on any triangle array with the same topology.
+ */
+uint32_t hashTrianglePixels(Triangle *triangles, int numTriangles) {
+  uint32_t hash = 2166136261UL;
+  for (int tri = 0; tri < numTriangles; tri++) {
+    for (byte led = 0; led < Triangle::NUM_LEDS; led++) {
+      PRGB *rgb = &(triangles[tri].leds[led]);
+      hash = (hash ^ rgb->red) * 16777619UL;
+      hash = (hash ^ rgb->green) * 16777619UL;
+      hash = (hash ^ rgb->blue) * 16777619UL;
+    }
+  }
+  return hash;
+}
@@ -30,6 +30,7 @@
 #include "PixelUtil.h"
 
 #include "Geometry.h"
+#include "PowerGovernor.h"
 
 class Triangle : public Geometry {
  public:
@@ -75,6 +76,8 @@ class Triangle : public Geometry {
   byte matchVertexLeft(Triangle *neighbor, byte vertex);
   byte matchVertexRight(Triangle *neighbor, byte vertex);
 
+  geo_point_t ledPoint(byte led);
+
   void print();
 
   /* Serialization functions */
@@ -100,10 +103,27 @@ class Triangle : public Geometry {
   geo_id_t edges[NUM_EDGES];
 };
 
+/* Calibration applied as triangle colors are copied to the pixels */
+extern ColorCalibration triangleCalibration;
+
+/* Limit on the current drawn by the triangles' pixels */
+extern PowerGovernor trianglePower;
+
 /* Send updated values to a Pixel chain */
 boolean updateTrianglePixels(Triangle *triangles, int numTriangles,
 			  PixelUtil *pixels);
 
+/* Neighbors of an LED in the global triangles, for use with LedGraph.h */
+geo_led_t triangleLedNeighbor(geo_led_t led, byte index);
+CRGB triangleLedColor(geo_led_t led);
+
+/* Fill a table with a spatial projection (see Spatial.h) of every LED */
+void buildTriangleLUT(Triangle *triangles, int numTriangles,
+                      byte projection, geo_point_t origin, byte *lut);
+
+/* Return a hash of the current LED colors, used to compare rendered frames */
+uint32_t hashTrianglePixels(Triangle *triangles, int numTriangles);
+
 
 // XXX: This should not be hard coded
 #ifndef TRI_ARRAY_SIZE
@@ -127,8 +147,11 @@ typedef struct {
   byte id;
   byte edges[Triangle::NUM_EDGES];
   byte leds[Triangle::NUM_LEDS];
+  geo_point_t center; // Added in geometry version 2
 } triangle_config_t;
 
+#define TRIANGLE_CONFIG_V1_SZ 7
+
 /* Read or write out an entire structure */
 int readTriangleStructure(int offset, Triangle **triangles_ptr,
                          int *numTriangles);
@@ -17,13 +17,14 @@
 #include <ffft.h>
 #include <math.h>
 
+#include "AdcScan.h"
 #include "SoundUnit.h"
 
 uint16_t light_level;
 uint16_t knob_level;
 
 int16_t       capture[FFT_N];    // Audio capture buffer
-volatile byte samplePos = 0;     // Buffer position counter
+byte knob_channel, light_channel; // Scanned by the ADC between captures
 
 complex_t     bfly_buff[FFT_N];  // FFT "butterfly" buffer
 uint16_t      spectrum[FFT_N/2]; // Spectrum output buffer
@@ -114,73 +115,33 @@ void sound_initialize() {
       colDiv[i] += pgm_read_byte(&data[j + 2]);
   }
 
-  setupFreeRun();
-}
-
-volatile byte current_pin = SOUND_PIN;
-volatile int ready_pin = -1;
+  /*
+   * The ADC free runs at ~9.6kHz, capturing FFT_N audio samples at a time
+   * and reading the knob and light sensor while each capture is processed.
+   */
+  adcScan.begin(ADC_SCAN_AREF, ADC_SCAN_FREE_RUN);
+  knob_channel = adcScan.add(KNOB_PIN, SENSOR_SCAN_HZ, 2);
+  light_channel = adcScan.add(LIGHT_PIN, SENSOR_SCAN_HZ, 2);
+  adcScan.capture(SOUND_PIN, capture, FFT_N);
 
-/*
- * Setup ADC free-run mode
- */
-void setupFreeRun() {
-  // Init ADC free-run mode; f = ( 16MHz/prescaler ) / 13 cycles/conversion
-  ADMUX  = current_pin; // Channel sel, right-adj, use AREF pin
-  ADCSRA = _BV(ADEN)  | // ADC enable
-           _BV(ADSC)  | // ADC start
-           _BV(ADATE) | // Auto trigger
-           _BV(ADIE)  | // Interrupt enable
-           _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0); // 128:1 / 13 = 9615 Hz
-  ADCSRB = 0;                // Free run mode, no high MUX bit
-  DIDR0  = 1 << SOUND_PIN // Turn off digital input for ADC pin
-         | 1 << LIGHT_PIN 
-         | 1 << KNOB_PIN;
   TIMSK0 = 0;                // Timer0 off
-
   sei(); // Enable interrupts
 }
 
 /*
- * Sampling interupt
- *   - Cycles through the sensor pins, taking FFT_N audio samples and a single
- *     sample of all others.
+ * Convert the raw audio samples for the FFT
  */
-ISR(ADC_vect) {
-  int16_t sample = ADC; // 0-1023
-  boolean done = false;
+void convertSamples() {
+  static const int16_t noiseThreshold = 4;
 
-  if (current_pin == SOUND_PIN) {
-    static const int16_t noiseThreshold = 4;
+  for (byte i = 0; i < FFT_N; i++) {
+    int16_t sample = capture[i]; // 0-1023
 
     // XXX: Why ignore values between 508-516?
-    capture[samplePos] =
+    capture[i] =
       ((sample > (512 - noiseThreshold)) &&
        (sample < (512 + noiseThreshold))) ? 0 :
       sample - 512; // Sign-convert for FFT; -512 to +511
-
-    if (++samplePos >= FFT_N) done = true;
-  } else if (current_pin == LIGHT_PIN) {
-    light_level = sample; // Does there need to be input pullup or pull down resistor?
-    done = true;
-  } else if (current_pin == KNOB_PIN) {
-    knob_level = sample;
-    done = true;
-  }
-
-  if (done) {
-    // Record which pin is done sampling
-    ready_pin = current_pin;
-
-    // Turn off interrupts to report back and switch pins
-    ADCSRA &= ~_BV(ADIE);
-    
-    // Switch pins
-    switch (current_pin) {
-      case SOUND_PIN: current_pin = KNOB_PIN; break;
-      case KNOB_PIN: current_pin = LIGHT_PIN; break;
-      case LIGHT_PIN: current_pin = SOUND_PIN; break;
-    }
-    ADMUX  = current_pin;
   }
 }
 
@@ -190,9 +151,9 @@ void processSound() {
   uint16_t minLvl, maxLvl;
   int      level, sum;
 
+  convertSamples();
   fft_input(capture, bfly_buff);   // Samples -> complex #s
-  samplePos = 0;                   // Reset sample counter
-  ADCSRA |= _BV(ADIE);             // Resume sampling interrupt
+  adcScan.capture(SOUND_PIN, capture, FFT_N); // Resume sampling
   fft_execute(bfly_buff);          // Process complex data
   fft_output(bfly_buff, spectrum); // Complex -> spectrum
 
@@ -243,14 +204,12 @@ void processSound() {
 
 
 boolean check_sound() {
-  if (!(ADCSRA & _BV(ADIE))) {
-    // Current sample is complete
-    if (ready_pin == SOUND_PIN) {
-      processSound(); // Sampling is re-enabled in processSound()
-      return true;
-    } else {
-      ADCSRA |= _BV(ADIE); // Resume sampling interrupt
-    }
+  light_level = adcScan.value(light_channel);
+  knob_level = adcScan.value(knob_channel);
+
+  if (adcScan.captured()) {
+    processSound(); // Sampling is restarted in processSound()
+    return true;
   }
 
   return false;
@@ -22,6 +22,8 @@
 #define LIGHT_PIN  1
 #define KNOB_PIN   4
 
+#define SENSOR_SCAN_HZ 20 // Readings per second of the knob and light sensor
+
 
 #define NUM_COLUMNS 8
 
@@ -43,7 +45,6 @@ extern uint16_t knob_level;
 
 void sound_initialize();
 boolean check_sound();
-void setupFreeRun();
 
 void cliHandler(char **tokens, byte numtokens);
 extern byte verbosity;
@@ -26,6 +26,7 @@
 #include "SerialCLI.h"
 
 #include "PixelUtil.h"
+#include "Palette.h"
 
 #include "Socket.h"
 #include "RS485Utils.h"
@@ -185,6 +186,8 @@ void print_data() {
   DEBUG_PRINT_END();
 }
 
+Palette heat_palette(PALETTE_HEAT);
+
 /*
  * Set the LEDs based on sound levels
  *
@@ -199,7 +202,7 @@ void set_leds() {
     total += colLeveled[c];
     if (c % 2 == 1) {
       byte heat = (total > 15 ? 255 : total * total);
-      pixels.setPixelRGB(led, pixel_heat(heat));
+      pixels.setPixelRGB(led, heat_palette.pixel(heat));
       led++;
       total = 0;
     }
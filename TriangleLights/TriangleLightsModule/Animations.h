@@ -0,0 +1,46 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Animations played by TRIANGLES_ANIMATION, written by
+ * utilities/AnimationEncoder/encode_animation.py.  This is only included by
+ * TriangleLightsModes.cpp.
+ ******************************************************************************/
+
+#ifndef TRIANGLELIGHTS_ANIMATIONS_H
+#define TRIANGLELIGHTS_ANIMATIONS_H
+
+#include <Arduino.h>
+
+/*
+ * A band of blue chasing around 20 triangles
+ *   12 frames of 60 LEDs, 4 colors, 206 bytes
+ */
+const byte anim_chase[] PROGMEM = {
+        0x3C, 0x00, 0x0C, 0x00, 0x50, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x08,
+        0x55, 0x00, 0x43, 0xAA, 0x00, 0xB2, 0xFF, 0x82, 0x03, 0x82, 0x02, 0x82,
+        0x01, 0x9A, 0x00, 0x82, 0x03, 0x82, 0x02, 0x82, 0x01, 0x8E, 0x00, 0x82,
+        0x00, 0x82, 0x03, 0x82, 0x02, 0x82, 0x01, 0x17, 0x82, 0x00, 0x82, 0x03,
+        0x82, 0x02, 0x82, 0x01, 0x0B, 0x02, 0x82, 0x00, 0x82, 0x03, 0x82, 0x02,
+        0x82, 0x01, 0x17, 0x82, 0x00, 0x82, 0x03, 0x82, 0x02, 0x82, 0x01, 0x08,
+        0x05, 0x82, 0x00, 0x82, 0x03, 0x82, 0x02, 0x82, 0x01, 0x17, 0x82, 0x00,
+        0x82, 0x03, 0x82, 0x02, 0x82, 0x01, 0x05, 0x08, 0x82, 0x00, 0x82, 0x03,
+        0x82, 0x02, 0x82, 0x01, 0x17, 0x82, 0x00, 0x82, 0x03, 0x82, 0x02, 0x82,
+        0x01, 0x02, 0x0B, 0x82, 0x00, 0x82, 0x03, 0x82, 0x02, 0x82, 0x01, 0x17,
+        0x82, 0x00, 0x82, 0x03, 0x82, 0x02, 0x82, 0x01, 0x0E, 0x82, 0x00, 0x82,
+        0x03, 0x82, 0x02, 0x82, 0x01, 0x17, 0x82, 0x00, 0x82, 0x03, 0x82, 0x02,
+        0x11, 0x82, 0x00, 0x82, 0x03, 0x82, 0x02, 0x82, 0x01, 0x17, 0x82, 0x00,
+        0x82, 0x03, 0x14, 0x82, 0x00, 0x82, 0x03, 0x82, 0x02, 0x82, 0x01, 0x17,
+        0x82, 0x00, 0x17, 0x82, 0x00, 0x82, 0x03, 0x82, 0x02, 0x82, 0x01, 0x17,
+        0x82, 0x01, 0x17, 0x82, 0x00, 0x82, 0x03, 0x82, 0x02, 0x82, 0x01, 0x14,
+        0x82, 0x02, 0x82, 0x01, 0x17, 0x82, 0x00, 0x82, 0x03, 0x82, 0x02, 0x82,
+        0x01, 0x11,
+};
+
+const byte * const animations[] PROGMEM = {
+        anim_chase
+};
+#define NUM_ANIMATIONS (sizeof (animations) / sizeof (animations[0]))
+
+#endif
@@ -11,9 +11,27 @@
 //#define DEBUG_LEVEL DEBUG_HIGH
 #include "Debug.h"
 
+#include "AdcScan.h"
+#include "SensorFilter.h"
 #include "TriangleLights.h"
 #include "Peripherals.h"
 
+/*
+ * Analog inputs are sampled by the ADC scanner and each new reading is
+ * passed through a filter.
+ */
+const byte analog_pins[] = {
+        KNOB_PIN,
+#ifdef LIGHT_PIN
+        LIGHT_PIN,
+#endif
+};
+#define NUM_ANALOG_PINS (sizeof (analog_pins) / sizeof (analog_pins[0]))
+
+byte analog_channels[NUM_ANALOG_PINS];
+byte analog_sequences[NUM_ANALOG_PINS];
+SensorFilter analog_filters[NUM_ANALOG_PINS];
+
 void button_interrupt(void);
 
 void initializePins() {
@@ -24,6 +42,16 @@ void initializePins() {
 
   /* Enable the knob's potentiometer pin's pullup resister */
   digitalWrite(KNOB_PIN, HIGH);
+
+#ifdef LIGHT_PIN
+  digitalWrite(LIGHT_PIN, HIGH);
+#endif
+
+  /* The analog inputs are read in the background on each Timer0 overflow */
+  adcScan.begin(ADC_SCAN_AVCC, ADC_SCAN_TIMER0);
+  for (byte i = 0; i < NUM_ANALOG_PINS; i++) {
+    analog_channels[i] = adcScan.add(analog_pins[i], ANALOG_SCAN_HZ, 2);
+  }
 }
 
 /* ***** Momentary switch button **********************************************/
@@ -57,36 +85,78 @@ byte get_button_value() {
   return buttonValue;
 }
 
-/* ***** Potentiometer *********************************************************/
-
-uint16_t pot_value = 1024;
+/* ***** Analog sensors ********************************************************/
 
-void check_pot_value() {
-  uint16_t value = analogRead(KNOB_PIN);
+/* Returns true if any filtered value changed */
+boolean check_analog_values() {
+  boolean changed = false;
 
-  if (abs(value - pot_value) >= 5) {
-    pot_value = value;
-    DEBUG4_VALUELN("Pot:", pot_value);
+  for (byte i = 0; i < NUM_ANALOG_PINS; i++) {
+    if (adcScan.updated(analog_channels[i], &analog_sequences[i]) &&
+        analog_filters[i].add(adcScan.value(analog_channels[i]))) {
+      DEBUG4_VALUE("Analog:", analog_pins[i]);
+      DEBUG4_VALUELN("=", analog_filters[i].value());
+      changed = true;
+    }
   }
+
+  return changed;
 }
 
 uint16_t get_pot_value() {
-  return pot_value;
+  return analog_filters[0].value();
 }
 
-byte get_pot_byte() {
-  return (byte)map(pot_value, 15, 750, 0, 255);;
+#ifdef LIGHT_PIN
+uint16_t get_photo_value() {
+  return analog_filters[1].value();
+}
+#endif
+
+/* ***** Brightness ************************************************************/
+
+byte brightness = 255;
+
+/*
+ * The knob sets the brightness, which is reduced towards AMBIENT_DARK_SCALE
+ * as the ambient light falls from PHOTO_THRESHOLD_HIGH to PHOTO_THRESHOLD_LOW.
+ */
+byte compute_brightness() {
+  uint16_t knob = constrain(get_pot_value(), KNOB_MIN, KNOB_MAX);
+  byte level = map(knob, KNOB_MIN, KNOB_MAX, 0, 255);
+
+#ifdef LIGHT_PIN
+  uint16_t light = constrain(get_photo_value(),
+                             PHOTO_THRESHOLD_LOW, PHOTO_THRESHOLD_HIGH);
+  byte scale = map(light, PHOTO_THRESHOLD_LOW, PHOTO_THRESHOLD_HIGH,
+                   AMBIENT_DARK_SCALE, 255);
+  level = ((uint16_t)level * (scale + 1)) >> 8;
+#endif
+
+  return level;
+}
+
+byte get_brightness() {
+  return brightness;
 }
 
 /* ***** Check all sensors for updates *****************************************/
 
 void update_sensors() {
-  static unsigned long next_sense = millis();
+  static unsigned long last_sense = 0;
   unsigned long now = millis();
 
-  if (now > next_sense) {
-    next_sense = now + SENSOR_DELAY_MS;
-
-    check_pot_value();
+  if (now - last_sense >= SENSOR_DELAY_MS) {
+    last_sense = now;
+
+    /* The brightness is only set when the sensors have changed it */
+    if (check_analog_values()) {
+      byte level = compute_brightness();
+      if (level != brightness) {
+        brightness = level;
+        trianglePower.setBrightness(brightness);
+        DEBUG3_VALUELN("Brightness:", brightness);
+      }
+    }
   }
 }
@@ -10,6 +10,20 @@
 #define OBJECTLIGHTS_PERIPHERALS_H
 
 #define KNOB_PIN A0
-byte get_pot_byte();
+
+/* Photo sensor used to dim the LEDs in the dark, if one is connected */
+//#define LIGHT_PIN A1
+
+#define ANALOG_SCAN_HZ 50 // Readings per second of each analog input
+
+/* Pot readings giving no and full brightness */
+#define KNOB_MIN 15
+#define KNOB_MAX 750
+
+/* Share of the knob's brightness used when the light is below the low level */
+#define AMBIENT_DARK_SCALE 96
+
+/* Brightness set by the knob and ambient light */
+byte get_brightness();
 
 #endif //OBJECTLIGHTS_PERIPHERALS_H
@@ -13,18 +13,19 @@
 #endif
 #include "Debug.h"
 
-#include "SerialCLI.h"
-
 #include "TriangleLights.h"
+#include "TriangleLightsModes.h"
+#include "Palette.h"
 
 extern volatile uint16_t buttonValue;
 
-void cliHandler(char **tokens, byte numtokens);
+extern Palette mode_palette;
+extern int numTriangles;
 
-SerialCLI serialcli(
-        MAX_CLI_LEN, // Max command length, this amount is allocated as a buffer
-        cliHandler   // Function for handling tokenized commands
-);
+/*
+ * Commands are read from the serial port along with HMTL messages by the
+ * serial reader in TriangleLightsModes.cpp, which calls cliHandler().
+ */
 
 void print_usage() {
   DEBUG3_PRINTLN(
@@ -32,6 +33,13 @@ void print_usage() {
 "Usage:\n"
 "  h - print this help\n"
 "  m <mode> - Set the mode\n"
+"  p <palette> [offset] - Set the palette (0 wheel, 1 heat) and its rotation\n"
+"  c <curve> [<r> <g> <b>] - Calibrate the LEDs with a gamma curve (0 linear,\n"
+"      1 1.8, 2 2.2, 3 2.8) and amounts to dim each channel, and save it\n"
+"  w <milliamps> - Limit the LEDs' current, 0 for no limit, and save it\n"
+"  g <program> <seed> <frames> [e|i|c] [h|b|t] - Render frames at full speed\n"
+"      on the EEPROM topology or a built in icosohedron or cylinder, printing\n"
+"      frame hashes, binary frames, or only the timing\n"
 "  b <color> - bgcolor color\n"
 "  f <color> - fgcolor color\n"
 );
@@ -51,6 +59,65 @@ void cliHandler(char **tokens, byte numtokens) {
       break;
     }
 
+    case 'p': {
+      if (numtokens < 2) return;
+      mode_palette.set(atoi(tokens[1]));
+      mode_palette.setOffset((numtokens >= 3) ? atoi(tokens[2]) : 0);
+      DEBUG3_VALUELN("Set palette:", atoi(tokens[1]));
+      break;
+    }
+
+    case 'c': {
+      if (numtokens < 2) return;
+      color_calibration_t calibration;
+      calibration.curve = atoi(tokens[1]);
+      for (byte c = 0; c < 3; c++) {
+        calibration.dim[c] = (numtokens >= 5) ? atoi(tokens[2 + c]) : 0;
+      }
+      triangleCalibration.set(&calibration);
+      save_triangle_structure();
+
+      /* Redraw everything with the new calibration */
+      for (int tri = 0; tri < numTriangles; tri++) {
+        triangles[tri].updated = true;
+      }
+      break;
+    }
+
+    case 'w': {
+      if (numtokens < 2) return;
+      trianglePower.setBudget(atoi(tokens[1]));
+      save_triangle_structure();
+      break;
+    }
+
+    case 'g': {
+      if (numtokens < 4) return;
+      byte program = strtol(tokens[1], NULL, 0);
+      unsigned long seed = strtoul(tokens[2], NULL, 0);
+      uint16_t frames = atoi(tokens[3]);
+
+      /* Render on a fixed topology so results don't depend on the EEPROM */
+      byte topology = RENDER_EEPROM;
+      if (numtokens >= 5) {
+        switch (tokens[4][0]) {
+          case 'i': topology = RENDER_ICOSOHEDRON; break;
+          case 'c': topology = RENDER_CYLINDER; break;
+        }
+      }
+
+      byte output = RENDER_HASH;
+      if (numtokens >= 6) {
+        switch (tokens[5][0]) {
+          case 'b': output = RENDER_FRAMES; break;
+          case 't': output = RENDER_TIME; break;
+        }
+      }
+
+      render_frames(program, seed, frames, topology, output);
+      break;
+    }
+
 #if 0
     case 'b': {
       if (numtokens < 2) return;
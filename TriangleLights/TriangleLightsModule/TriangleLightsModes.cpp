@@ -22,9 +22,23 @@
 #include <TimeSync.h>
 #include <MessageHandler.h>
 #include <HMTLTypes.h>
-
+#include <EEPromUtils.h>
+
+#include "ClockSync.h"
+#include "Spatial.h"
+#include "Ripples.h"
+#include "Diffusion.h"
+#include "PatternVM.h"
+#include "Animation.h"
+#include "AudioFeatures.h"
+#include "ColorAccumulator.h"
+#include "Palette.h"
+#include "MessageRelay.h"
+#include "RecentMessages.h"
+#include "SerialDemux.h"
 #include "TriangleLights.h"
 #include "TriangleLightsModes.h"
+#include "Animations.h"
 #include "Utilities.h"
 #include "Peripherals.h"
 
@@ -34,8 +48,11 @@ extern void *objects[];
 
 extern RS485Socket rs485;
 extern int numTriangles;
+extern int triangleConfigOffset;
 extern PixelUtil pixels;
 
+extern void cliHandler(char **tokens, byte numtokens);
+
 /* List of available programs */
 hmtl_program_t program_functions[] = {
         // Programs from HMTLPrograms
@@ -49,17 +66,64 @@ hmtl_program_t program_functions[] = {
         // Custom programs
         { TRIANGLES_SET_ALL, mode_set_all, mode_generic_init}, // This is the same as the default handler
         { TRIANGLES_STATIC_NOISE, mode_static_noise, mode_generic_init},
-        { TRIANGLES_SNAKES_2, mode_snakes_2, mode_snakes_init}
+        { TRIANGLES_SNAKES_2, mode_snakes_2, mode_snakes_init},
+        { TRIANGLES_SPATIAL, mode_spatial, mode_spatial_init},
+        { TRIANGLES_RIPPLES, mode_ripples, mode_ripples_init},
+        { TRIANGLES_DIFFUSE, mode_diffuse, mode_diffuse_init},
+        { TRIANGLES_PATTERN, mode_pattern, mode_pattern_init},
+        { TRIANGLES_ANIMATION, mode_animation, mode_animation_init},
+        { TRIANGLES_GLITTER, mode_glitter, mode_glitter_init},
+        { TRIANGLES_SOUND_BANDS, mode_sound_bands, mode_generic_init},
+        { TRIANGLES_SOUND_BEAT, mode_sound_beat, mode_sound_beat_init}
 };
 #define NUM_PROGRAMS (sizeof (program_functions) / sizeof (hmtl_program_t))
 
-#define FIRST_TRIANGLE_MODE   (byte)1
-#define NUM_TRIANGLE_PROGRAMS (byte)3
+/* The range of the table that the button cycles through, found by init_modes */
+byte first_triangle_mode = 0;
+byte num_triangle_modes = 0;
 
 program_tracker_t *active_programs[HMTL_MAX_OUTPUTS];
 ProgramManager manager;
 MessageHandler handler;
 
+Palette mode_palette;       // Colors drawn by the modes
+
+byte mode_sequence = 0;     // Sequence number of this module's last mode
+RecentMessages recent_modes; // Mode messages that have already been handled
+RecentMessages recent_controls; // Control messages, kept apart from the modes
+MessageRelay mode_relay;     // Broadcasts passed on between sockets
+boolean mode_repeated = false;
+
+/*
+ * Offset from the local time to the time of the reference module, which is
+ * the module that last broadcast a mode.
+ */
+ClockSync clock_sync;
+unsigned long last_beacon_ms = 0;
+boolean beacon_pending = false;
+
+/*
+ * The serial port carries both HMTL messages and CLI commands, so it is read
+ * here rather than by the message handler.
+ */
+#define SERIAL_MSG_SIZE (sizeof (msg_hdr_t) + sizeof (msg_max_t))
+#define SERIAL_BUFFER_SIZE \
+  (SERIAL_MSG_SIZE > MAX_CLI_LEN ? SERIAL_MSG_SIZE : MAX_CLI_LEN)
+byte serial_buffer[SERIAL_BUFFER_SIZE];
+
+boolean serial_msg(msg_hdr_t *msg);
+boolean audio_msg(msg_hdr_t *msg);
+boolean program_msg_valid(msg_hdr_t *msg);
+void relay_msg(msg_hdr_t *msg, byte from);
+void request_audio();
+boolean control_msg(msg_hdr_t *msg);
+void pattern_load_msg(mode_pattern_load_t *load);
+SerialDemux serial_demux(serial_buffer, SERIAL_BUFFER_SIZE,
+                         serial_msg, cliHandler);
+
+Socket **mode_sockets;
+byte num_mode_sockets = 0;
+
 /*
  * Initialize the program and message handling
  */
@@ -68,8 +132,21 @@ void init_modes(Socket **sockets, byte num_sockets) {
   manager = ProgramManager(outputs, active_programs, objects, config.num_outputs,
                            program_functions, NUM_PROGRAMS);
 
+  /* The button selects from the triangle modes, which are kept together */
+  for (byte i = 0; i < NUM_PROGRAMS; i++) {
+    if (IS_TRIANGLE_PROGRAM(program_functions[i].type)) {
+      if (num_triangle_modes == 0) first_triangle_mode = i;
+      num_triangle_modes++;
+    }
+  }
+
   /* Setup a message handler with the program manager */
   handler = MessageHandler(config.address, &manager, sockets, num_sockets);
+  mode_sockets = sockets;
+  num_mode_sockets = num_sockets;
+
+  /* Start from a random sequence so a restart doesn't repeat old ids */
+  mode_sequence = random(256);
 
   /* Execute any initial commands */
   startup_commands();
@@ -87,35 +164,79 @@ boolean messages_and_modes(void) {
    * Check the serial device and all sockets for messages, forwarding them and
    * processing them if they are for this module.
    */
-  boolean update = handler.check(&config);
+  boolean message = serial_demux.check(&Serial);
+  for (byte i = 0; i < num_mode_sockets; i++) {
+    unsigned int msglen;
+    msg_hdr_t *msg = hmtl_socket_getmsg(mode_sockets[i], &msglen,
+                                        config.address);
+    if (msg == NULL) continue;
+    if (!program_msg_valid(msg)) continue;
+    relay_msg(msg, i);
+    audio_msg(msg);
+    if (control_msg(msg)) continue;
+    if (handler.process_msg(msg, mode_sockets[i], NULL, &config)) {
+      message = true;
+    }
+  }
+
+  /* If this module set the current mode then keep the others in step with it */
+  send_clock_beacon();
+
+  /* Ask the sound unit for levels while a sound mode is running */
+  request_audio();
 
   /* Execute any active programs */
-  if (manager.run()) {
-    update = true;
-  }
+  boolean programs = manager.run();
 
-  if (update) {
+  if (message) {
     /*
-     * An output may have been updated by message or active program,
-     * update all output states.
+     * A message may have set any output directly, update all output states.
      */
     for (byte i = 0; i < config.num_outputs; i++) {
       hmtl_update_output(outputs[i], objects[i]);
     }
-
+    trianglePower.recount(&pixels);
+  } else if (programs) {
     /*
-     * TODO:
-     * If a program is a triangle-specific one then update the triangles,
-     * otherwise perform generic output updates
+     * Only outputs with a running program can have changed.  Triangle modes
+     * draw into the triangles, which are copied to the pixels only for the
+     * triangles they changed, while other programs set their output directly.
      */
+    for (byte i = 0; i < config.num_outputs; i++) {
+      program_tracker_t *tracker = active_programs[i];
+      if ((tracker == NULL) || (tracker->program == NULL)) continue;
+      if (IS_TRIANGLE_PROGRAM(tracker->program->type)) continue;
 
-    updateTrianglePixels(triangles, numTriangles, &pixels);
+      hmtl_update_output(outputs[i], objects[i]);
+    }
   }
 
-  return update;
+  /*
+   * Send any triangles that changed, which also sends a change of brightness
+   * when nothing else has changed.
+   */
+  updateTrianglePixels(triangles, numTriangles, &pixels);
+
+  return (message || programs);
 }
 
 
+/*
+ * Handle an HMTL message from the serial port, passing it on to the other
+ * modules unless it was only for this one.
+ */
+boolean serial_msg(msg_hdr_t *msg) {
+  if (!program_msg_valid(msg)) return false;
+  handler.check_and_forward(msg, &rs485);
+  audio_msg(msg);
+
+  if ((msg->address != config.address) && (msg->address != SOCKET_ADDR_ANY)) {
+    return false;
+  }
+  if (control_msg(msg)) return false;
+  return handler.process_msg(msg, &rs485, NULL, &config);
+}
+
 /*
  * Execute initial commands
  */
@@ -124,15 +245,37 @@ void startup_commands() {
 }
 
 /*
- * Create a message to set the mode for the indicated value
+ * Program messages are built in place in the send buffer.  Each mode's data
+ * is checked against the program values when compiling, so a mode that grows
+ * too large to send fails to build rather than overrunning the message.
+ *
+ * The header version belongs to the HMTL library and is shared with every
+ * other HMTL sender, so changes to the layout of the mode data are marked by
+ * new program types instead.
  */
-boolean set_mode(byte mode, boolean broadcast) {
+#define PROGRAM_MSG_VERSION 0x02 // Message version of the HMTL library
+#define PROGRAM_MSG_LENGTH (sizeof (msg_hdr_t) + sizeof (msg_program_t))
+
+static_assert(MODE_DATA_MSG_SIZE <= MAX_PROGRAM_VAL,
+              "mode_data_t message data exceeds the program values");
+static_assert(MODE_SNAKE_MSG_SIZE <= MAX_PROGRAM_VAL,
+              "mode_snake_data_t message data exceeds the program values");
+static_assert(MODE_CLOCK_MSG_SIZE <= MAX_PROGRAM_VAL,
+              "mode_clock_sync_t exceeds the program values");
+static_assert(sizeof (mode_pattern_load_t) <= MAX_PROGRAM_VAL,
+              "mode_pattern_load_t exceeds the program values");
 
+/*
+ * Fill in the headers of a program message for all outputs in the send
+ * buffer, stamping it with this module's address and next sequence number.
+ * Returns the cleared program values for the caller to fill in.
+ */
+mode_hdr_t *program_msg(byte type) {
   msg_hdr_t *msg_hdr = (msg_hdr_t *) rs485.send_buffer;
   msg_hdr->startcode = HMTL_MSG_START;
-  msg_hdr->crc = 00; // TODO: If I ever implement msg level CRC
-  msg_hdr->version = 0x02; // TODO: VERSION????!!!!
-  msg_hdr->length = 0x17; // TODO: Calculate
+  msg_hdr->crc = 0; // Set by program_msg_crc() once the values are filled in
+  msg_hdr->version = PROGRAM_MSG_VERSION;
+  msg_hdr->length = PROGRAM_MSG_LENGTH;
   msg_hdr->type = MSG_TYPE_OUTPUT;
   msg_hdr->flags = 0x00;
   msg_hdr->address = SOCKET_ADDR_ANY;
@@ -140,24 +283,187 @@ boolean set_mode(byte mode, boolean broadcast) {
   msg_program_t *program = (msg_program_t *) (msg_hdr + 1);
   program->hdr.type = HMTL_OUTPUT_PROGRAM;
   program->hdr.output = HMTL_ALL_OUTPUTS;
+  program->type = type;
+  memset(program->values, 0, MAX_PROGRAM_VAL);
+
+  mode_hdr_t *hdr = (mode_hdr_t *)program->values;
+  hdr->origin = config.address;
+  hdr->sequence = ++mode_sequence;
+
+  return hdr;
+}
+
+/*
+ * CRC-8 (Dallas/Maxim) of a program message's type and values, which are left
+ * as they are by the modules that forward it.  Other HMTL senders leave the
+ * header's crc at 0, so 0 means the message is unchecked and a message whose
+ * CRC comes to 0 is sent unchecked.
+ */
+byte program_crc(const msg_program_t *program) {
+  const byte *ptr = &program->type;
+  byte crc = 0;
+  for (byte i = 0; i < 1 + MAX_PROGRAM_VAL; i++) {
+    crc ^= ptr[i];
+    for (byte bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x01) ? ((crc >> 1) ^ 0x8C) : (crc >> 1);
+    }
+  }
+  return crc;
+}
 
+/* Set the CRC of the program message in the send buffer before sending it */
+void program_msg_crc() {
+  msg_hdr_t *msg_hdr = (msg_hdr_t *) rs485.send_buffer;
+  msg_hdr->crc = program_crc((msg_program_t *)(msg_hdr + 1));
+}
+
+/*
+ * Returns false for a program message whose values don't match its CRC, which
+ * is then dropped rather than handled or forwarded.
+ */
+boolean program_msg_valid(msg_hdr_t *msg) {
+  if ((msg->crc == 0) || (msg->type != MSG_TYPE_OUTPUT) ||
+      (msg->length < PROGRAM_MSG_LENGTH)) {
+    return true;
+  }
+
+  msg_program_t *program = (msg_program_t *)(msg + 1);
+  if (program->hdr.type != HMTL_OUTPUT_PROGRAM) return true;
+
+  if (program_crc(program) != msg->crc) {
+    DEBUG1_VALUELN("Bad program CRC:", msg->crc);
+    return false;
+  }
+  return true;
+}
+
+/*
+ * Pass a broadcast triangle program message that arrived on one socket on to
+ * the module's other sockets with its hop counted, the first time that it is
+ * seen and until it reaches MESSAGE_MAX_HOPS.
+ */
+void relay_msg(msg_hdr_t *msg, byte from) {
+  if ((num_mode_sockets < 2) || (msg->address != SOCKET_ADDR_ANY) ||
+      (msg->type != MSG_TYPE_OUTPUT) || (msg->length < PROGRAM_MSG_LENGTH)) {
+    return;
+  }
+
+  msg_program_t *program = (msg_program_t *)(msg + 1);
+  if ((program->hdr.type != HMTL_OUTPUT_PROGRAM) ||
+      !IS_TRIANGLE_PROGRAM(program->type)) {
+    return;
+  }
+
+  mode_hdr_t *hdr = (mode_hdr_t *)program->values;
+  if ((hdr->origin == config.address) ||
+      !mode_relay.forward(hdr->origin, hdr->sequence, hdr->hops)) {
+    return;
+  }
+
+  for (byte i = 0; i < num_mode_sockets; i++) {
+    Socket *socket = mode_sockets[i];
+    if ((i == from) || (socket->send_data_size < msg->length)) continue;
+
+    memcpy(socket->send_buffer, msg, msg->length);
+    msg_hdr_t *relayed = (msg_hdr_t *)socket->send_buffer;
+    msg_program_t *relayed_program = (msg_program_t *)(relayed + 1);
+    ((mode_hdr_t *)relayed_program->values)->hops++;
+    if (relayed->crc != 0) relayed->crc = program_crc(relayed_program);
+
+    socket->sendMsgTo(SOCKET_ADDR_ANY, socket->send_buffer, msg->length);
+    DEBUG4_VALUELN("Relayed from:", hdr->origin);
+  }
+}
+
+/* Build a program message for each type of mode data */
+mode_data_t *mode_data_msg(byte mode) {
+  return (mode_data_t *)program_msg(mode);
+}
+
+mode_snake_data_t *mode_snake_msg(byte mode) {
+  return (mode_snake_data_t *)program_msg(mode);
+}
+
+mode_clock_sync_t *mode_clock_msg(byte type, uint16_t target) {
+  mode_clock_sync_t *clock = (mode_clock_sync_t *)program_msg(type);
+  clock->target = target;
+  return clock;
+}
+
+/*
+ * Create a message to set the mode for the indicated value
+ */
+boolean set_mode(byte mode, boolean broadcast) {
   DEBUG3_VALUELN("set_mode:", mode);
 
-  program->type = mode;
   switch (mode) {
     case TRIANGLES_SNAKES_2: {
-      mode_snake_data_t *data = (mode_snake_data_t *)&program->values[0];
-      data->hdr.period_ms = 100;
+      mode_snake_data_t *data = mode_snake_msg(mode);
+      data->hdr.period = MODE_PERIOD(100);
       data->bgColor = CRGB(0, 0, 0);
       data->colorMode = 4;
-
-      memcpy(rs485.send_buffer, data, sizeof(data));
+      break;
+    }
+    case TRIANGLES_SPATIAL: {
+      mode_data_t *data = mode_data_msg(mode);
+      data->hdr.period = MODE_PERIOD(50);
+      data->data[0] = SPATIAL_HEIGHT;
+      data->data[1] = 4; // Shift per period
+      break;
+    }
+    case TRIANGLES_RIPPLES: {
+      mode_data_t *data = mode_data_msg(mode);
+      data->hdr.period = MODE_PERIOD(20);
+      data->data[0] = 15; // Splash every 1.5s
+      data->data[1] = 12; // 120ms per hop
+      break;
+    }
+    case TRIANGLES_PATTERN: {
+      mode_data_t *data = mode_data_msg(mode);
+      data->hdr.period = MODE_PERIOD(30);
+      data->bgColor = CRGB(0, 0, 0);
+      data->fgColor = CRGB(255, 255, 255);
+      data->data[0] = PATTERN_WHEEL;
+      break;
+    }
+    case TRIANGLES_ANIMATION: {
+      mode_data_t *data = mode_data_msg(mode);
+      data->hdr.period = 0; // Use the animation's period
+      data->data[0] = 0;       // Animation to play
+      break;
+    }
+    case TRIANGLES_GLITTER: {
+      mode_data_t *data = mode_data_msg(mode);
+      data->hdr.period = MODE_PERIOD(100);
+      data->data[0] = 40; // Fade of about 1% per period
+      data->data[1] = 20; // Chance of a sparkle, out of 256
+      break;
+    }
+    case TRIANGLES_SOUND_BANDS: {
+      mode_data_t *data = mode_data_msg(mode);
+      data->hdr.period = MODE_PERIOD(20);
+      data->bgColor = CRGB(0, 0, 0);
+      break;
+    }
+    case TRIANGLES_SOUND_BEAT: {
+      mode_data_t *data = mode_data_msg(mode);
+      data->hdr.period = MODE_PERIOD(20);
+      data->bgColor = CRGB(0, 0, 64);
+      data->data[0] = 8; // 80ms per hop
+      break;
+    }
+    case TRIANGLES_DIFFUSE: {
+      mode_data_t *data = mode_data_msg(mode);
+      data->hdr.period = MODE_PERIOD(30);
+      data->fgColor = CRGB(252, 250, 254); // Per-channel decay
+      data->data[0] = 96; // Diffusion rate
+      data->data[1] = 8;  // Chance of injecting color, out of 256
       break;
     }
     case TRIANGLES_SET_ALL:
     case TRIANGLES_STATIC_NOISE: {
-      mode_data_t *data = (mode_data_t *)&program->values[0];
-      data->hdr.period_ms = 100;
+      mode_data_t *data = mode_data_msg(mode);
+      data->hdr.period = MODE_PERIOD(100);
       data->bgColor = CRGB(0, 0, 0);
       data->fgColor = CRGB(255, 255, 255);
       data->data[0] = 60; // Static threshold
@@ -169,18 +475,43 @@ boolean set_mode(byte mode, boolean broadcast) {
     }
   }
 
+  program_msg_crc();
   if (broadcast) {
     handler.check_and_forward((msg_hdr_t *) rs485.send_buffer, &rs485);
+
+    /* The other modules follow this module's clock for the new mode */
+    clock_sync.setReference(config.address);
+    beacon_pending = true;
   }
   return handler.process_msg((msg_hdr_t *) rs485.send_buffer, &rs485,
                              NULL, &config);
 }
 
+/*
+ * Periodically broadcast this module's mode clock if it is the reference
+ */
+void send_clock_beacon() {
+  if (!clock_sync.isReference(config.address)) return;
+
+  unsigned long now = time.ms();
+  if (!beacon_pending && (now - last_beacon_ms < CLOCK_BEACON_MS)) return;
+  beacon_pending = false;
+  last_beacon_ms = now;
+
+  mode_clock_sync_t *beacon = mode_clock_msg(TRIANGLES_CLOCK_SYNC,
+                                             SOCKET_ADDR_ANY);
+  beacon->ms = mode_ms();
+
+  DEBUG4_VALUELN("beacon:", beacon->ms);
+  program_msg_crc();
+  handler.check_and_forward((msg_hdr_t *) rs485.send_buffer, &rs485);
+}
+
 byte current_mode_index = ProgramManager::NO_PROGRAM;
 void update_mode_from_button() {
-  byte button = get_button_value() % NUM_TRIANGLE_PROGRAMS;
-  if (button != (current_mode_index - FIRST_TRIANGLE_MODE)) {
-    current_mode_index = button + FIRST_TRIANGLE_MODE;
+  byte button = get_button_value() % num_triangle_modes;
+  if (button != (current_mode_index - first_triangle_mode)) {
+    current_mode_index = button + first_triangle_mode;
     DEBUG3_VALUELN("mode=", current_mode_index);
     DEBUG_MEMORY(DEBUG_MID);
 
@@ -188,9 +519,245 @@ void update_mode_from_button() {
   }
 }
 
+/*
+ * Clock used by the modes.  Normally this is the synchronized time, but it can
+ * be switched to a manually stepped clock so that frames can be rendered
+ * deterministically.
+ */
+boolean mode_clock_stepped = false;
+unsigned long mode_clock_ms = 0;
+
+unsigned long mode_ms() {
+  if (mode_clock_stepped) return mode_clock_ms;
+  return clock_sync.ms(time.ms());
+}
+
+/*
+ * Returns true if a mode's period has elapsed.  Ticks are aligned to
+ * multiples of the period on the mode clock, so modules with synchronized
+ * clocks update on the same ticks regardless of when their modes started.
+ */
+boolean mode_tick(uint16_t period_ms, unsigned long *last_ms,
+                  unsigned long now) {
+  if (now - *last_ms < period_ms) return false;
+  *last_ms = now - (now % period_ms);
+  return true;
+}
+
+/*
+ * Render a number of frames of a mode from a fixed random seed, stepping the
+ * mode clock until each frame is produced.  Rendering runs as fast as the
+ * mode allows and is independent of the LEDs, which are not updated.
+ *
+ * The topology is the one read from EEPROM or one of the built in shapes, so
+ * that results can be compared between modules.  A built in shape is replaced
+ * by the EEPROM topology again before the module's own mode is restarted.
+ *
+ * Output is one of:
+ *   RENDER_HASH   - Print a hash of the colors after each frame, which can be
+ *                   compared against a previous run to verify that a mode's
+ *                   rendering is unchanged.
+ *   RENDER_FRAMES - Write each frame as binary, a 'F' followed by the RGB
+ *                   values of every LED in triangle order.
+ *   RENDER_TIME   - No per-frame output
+ *
+ * In all cases the time spent rendering is printed once complete.
+ */
+#define RENDER_MAX_STEP_MS 60000
+void render_frames(byte mode, unsigned long seed, uint16_t frames,
+                   byte topology, byte output) {
+  boolean builtin = false;
+  switch (topology) {
+    case RENDER_ICOSOHEDRON:
+      buildIcosohedron(&numTriangles, pixels.numPixels());
+      builtin = true;
+      break;
+#if TRI_ARRAY_SIZE >= 30
+    case RENDER_CYLINDER:
+      buildCylinder(&numTriangles, pixels.numPixels());
+      builtin = true;
+      break;
+#endif
+  }
+
+  mode_clock_stepped = true;
+  mode_clock_ms = 0;
+  randomSeed(seed);
+  random16_set_seed((uint16_t)seed);
+
+  unsigned long render_us = 0;
+  uint16_t frame = 0;
+
+  if (set_mode(mode, false)) {
+    for (frame = 0; frame < frames; frame++) {
+      uint16_t steps = 0;
+      boolean rendered;
+      do {
+        mode_clock_ms++;
+        unsigned long start = micros();
+        rendered = manager.run();
+        if (rendered) {
+          /* Only count the calls that produced a frame */
+          render_us += micros() - start;
+        }
+      } while (!rendered && (++steps < RENDER_MAX_STEP_MS));
+
+      switch (output) {
+        case RENDER_HASH: {
+          Serial.print(F("frame:"));
+          Serial.print(frame);
+          Serial.print(F(" ms:"));
+          Serial.print(mode_clock_ms);
+          Serial.print(F(" hash:"));
+          Serial.println(hashTrianglePixels(triangles, numTriangles), HEX);
+          break;
+        }
+        case RENDER_FRAMES: {
+          Serial.write('F');
+          for (int tri = 0; tri < numTriangles; tri++) {
+            for (byte led = 0; led < Triangle::NUM_LEDS; led++) {
+              PRGB *rgb = &(triangles[tri].leds[led]);
+              Serial.write(rgb->red);
+              Serial.write(rgb->green);
+              Serial.write(rgb->blue);
+            }
+          }
+          break;
+        }
+      }
+    }
+  }
+
+  Serial.print(F("\nframes:"));
+  Serial.print(frame);
+  Serial.print(F(" us:"));
+  Serial.print(render_us);
+  if (render_us > 0) {
+    Serial.print(F(" fps:"));
+    Serial.print((unsigned long)((uint64_t)frame * 1000000UL / render_us));
+  }
+  Serial.println();
+
+  /* Return to the real clock and topology and restart the active mode */
+  mode_clock_stepped = false;
+  if (builtin) {
+    readTriangleStructure(triangleConfigOffset, &triangles, &numTriangles);
+  }
+
+  if (current_mode_index < NUM_PROGRAMS) {
+    set_mode(program_functions[current_mode_index].type, false);
+  } else {
+    /* No mode was running, so stop the rendered one and clear its frame */
+    program_msg(HMTL_PROGRAM_NONE);
+    handler.process_msg((msg_hdr_t *) rs485.send_buffer, &rs485,
+                        NULL, &config);
+    set_all_triangles(triangles, numTriangles, CRGB(0, 0, 0));
+  }
+}
+
 // TODO: This is icky.
 mode_snake_data_t triangle_mode_state;
 #define MAX_MODE_DATA (sizeof (triangle_mode_state))
+static_assert(MAX_PROGRAM_VAL <= MAX_MODE_DATA,
+              "Mode state can't hold the program values");
+
+/*
+ * Working memory for the modes that need per-LED tables.  Only one triangle
+ * mode runs at a time, so they all share this buffer.
+ */
+#define MAX_MODE_LEDS (TRI_ARRAY_SIZE * Triangle::NUM_LEDS)
+#define MODE_BUFFER_SIZE (DIFFUSION_BUFFER_SIZE(MAX_MODE_LEDS))
+byte mode_buffer[MODE_BUFFER_SIZE];
+static_assert(MAX_MODE_LEDS <= Geometry::NO_LED,
+              "Mode LEDs must be numbered by geo_led_t below NO_LED");
+static_assert(PATTERN_VM_BUFFER_SIZE(MAX_MODE_LEDS) <= MODE_BUFFER_SIZE,
+              "Mode buffer is too small for patterns");
+static_assert(COLOR_ACCUMULATOR_BUFFER_SIZE(MAX_MODE_LEDS) <= MODE_BUFFER_SIZE,
+              "Mode buffer is too small for the color accumulator");
+
+/*
+ * Apply a clock beacon from the reference module, dropping copies that
+ * arrive by more than one route.  A periodic beacon is followed by a ping
+ * back to the reference when the latency is due to be measured, and the
+ * answer to this module's ping updates it.
+ */
+void clock_beacon_msg(mode_clock_sync_t *beacon) {
+  if (beacon->hdr.origin == config.address) return;
+  if (!recent_controls.check(beacon->hdr.origin, beacon->hdr.sequence)) {
+    return;
+  }
+
+  unsigned long now = time.ms();
+  if (beacon->target == config.address) {
+    clock_sync.echo(beacon->hdr.origin, beacon->ms, beacon->echo_ms, now);
+  } else if (beacon->target == SOCKET_ADDR_ANY) {
+    clock_sync.beacon(beacon->hdr.origin, beacon->ms, now);
+
+    if (clock_sync.ping(now)) {
+      mode_clock_sync_t *ping = mode_clock_msg(TRIANGLES_CLOCK_PING,
+                                               beacon->hdr.origin);
+      ping->echo_ms = (uint16_t)now;
+      program_msg_crc();
+      handler.check_and_forward((msg_hdr_t *) rs485.send_buffer, &rs485);
+    }
+  } else {
+    /* Another module's answer */
+    return;
+  }
+
+  DEBUG3_VALUE("clock: from ", beacon->hdr.origin);
+  DEBUG3_VALUE(" ms:", mode_ms());
+  DEBUG3_VALUELN(" latency:", clock_sync.getLatency());
+}
+
+/*
+ * Answer a ping from another module with this module's clock, if it is still
+ * the reference.
+ */
+void clock_ping_msg(mode_clock_sync_t *ping) {
+  if (ping->target != config.address) return;
+  if (!clock_sync.isReference(config.address)) return;
+  if (!recent_controls.check(ping->hdr.origin, ping->hdr.sequence)) return;
+
+  uint16_t echo_ms = ping->echo_ms;
+  mode_clock_sync_t *answer = mode_clock_msg(TRIANGLES_CLOCK_SYNC,
+                                             ping->hdr.origin);
+  answer->ms = mode_ms();
+  answer->echo_ms = echo_ms;
+
+  program_msg_crc();
+  handler.check_and_forward((msg_hdr_t *) rs485.send_buffer, &rs485);
+}
+
+/*
+ * Clock beacons and pattern pieces are sent as program messages so that they
+ * travel and are forwarded like the modes, but they are handled here and
+ * never reach the program manager.  A program whose setup declines a message
+ * has its output freed, so passing them on would stop the running mode.
+ * Returns true if the message was handled.
+ */
+boolean control_msg(msg_hdr_t *msg) {
+  if ((msg->type != MSG_TYPE_OUTPUT) || (msg->length < PROGRAM_MSG_LENGTH)) {
+    return false;
+  }
+
+  msg_program_t *program = (msg_program_t *)(msg + 1);
+  if (program->hdr.type != HMTL_OUTPUT_PROGRAM) return false;
+
+  switch (program->type) {
+    case TRIANGLES_CLOCK_SYNC:
+      clock_beacon_msg((mode_clock_sync_t *)program->values);
+      return true;
+    case TRIANGLES_CLOCK_PING:
+      clock_ping_msg((mode_clock_sync_t *)program->values);
+      return true;
+    case TRIANGLES_PATTERN_LOAD:
+      pattern_load_msg((mode_pattern_load_t *)program->values);
+      return true;
+  }
+
+  return false;
+}
 
 /*
  * This initializes any of the triangle modes
@@ -204,15 +771,28 @@ boolean mode_generic_init(msg_program_t *msg,
 
   mode_data_t *state = (mode_data_t *)&triangle_mode_state;
 
-  memset(state, 0, sizeof(MAX_MODE_DATA));
-  memcpy(state, msg->values, min(sizeof(mode_data_t), MAX_PROGRAM_VAL));
+  /*
+   * A copy of the message that started the current mode leaves the mode
+   * running as it is.
+   */
+  mode_hdr_t *hdr = (mode_hdr_t *)msg->values;
+  mode_repeated = !recent_modes.check(hdr->origin, hdr->sequence);
+  if (mode_repeated) {
+    DEBUG3_VALUE("INIT: Repeated from ", hdr->origin);
+    DEBUG3_VALUELN(" seq:", hdr->sequence);
+    tracker->state = state;
+    return true;
+  }
+
+  memset((void *)state, 0, MAX_MODE_DATA);
+  memcpy((void *)state, msg->values, MAX_PROGRAM_VAL);
 
-  if (state->hdr.period_ms == 0)
-    state->hdr.period_ms = 100;
+  if (state->hdr.period == 0)
+    state->hdr.period = MODE_PERIOD(100);
 
   tracker->state = state;
 
-  DEBUG3_HEXVAL("INIT: Generic per=", state->hdr.period_ms);
+  DEBUG3_HEXVAL("INIT: Generic per=", MODE_PERIOD_MS(state->hdr));
   DEBUG3_HEXVAL(" fg:", state->fgColor.r);
   DEBUG3_HEXVAL(",", state->fgColor.g);
   DEBUG3_HEXVAL(",", state->fgColor.b);
@@ -235,13 +815,10 @@ boolean mode_set_all(output_hdr_t *output, void *object,
                      program_tracker_t *tracker) {
 
   mode_data_t *state = (mode_data_t *)tracker->state;
-  unsigned long now = time.ms();
-
-  if (now - state->last_change_ms >= state->hdr.period_ms) {
-    FastLED.setBrightness(get_pot_byte());
+  unsigned long now = mode_ms();
 
+  if (mode_tick(MODE_PERIOD_MS(state->hdr), &state->last_change_ms, now)) {
     set_all_triangles(triangles, numTriangles, state->fgColor);
-    state->last_change_ms = now;
 
     DEBUG5_HEXVAL("set=", state->fgColor.r);
     DEBUG5_HEXVAL(",", state->fgColor.g);
@@ -260,10 +837,9 @@ boolean mode_set_all(output_hdr_t *output, void *object,
 boolean mode_static_noise(output_hdr_t *output, void *object,
                           program_tracker_t *tracker) {
   mode_data_t *state = (mode_data_t *)tracker->state;
-  unsigned long now = time.ms();
+  unsigned long now = mode_ms();
 
-  if (now - state->last_change_ms >= state->hdr.period_ms) {
-    state->last_change_ms = now;
+  if (mode_tick(MODE_PERIOD_MS(state->hdr), &state->last_change_ms, now)) {
 
     /* Set the leds randomly to on off in white */
     for (int tri = 0; tri < numTriangles; tri++) {
@@ -291,6 +867,7 @@ boolean mode_snakes_init(msg_program_t *msg,
                          program_tracker_t *tracker,
                          output_hdr_t *output) {
   if (mode_generic_init(msg, tracker, output)) {
+    if (mode_repeated) return true;
     mode_snake_data_t *state = (mode_snake_data_t *)tracker->state;
 
     if ((state->length == 0) || (state->length > SNAKE_MAX_LENGTH)) {
@@ -316,7 +893,7 @@ boolean mode_snakes_init(msg_program_t *msg,
     state->currentIndex = 0;
     state->snakeTriangles[state->currentIndex] = tri;
     state->snakeVertices[state->currentIndex] = (byte)random(0, Triangle::NUM_EDGES);
-    state->last_change_ms = millis();
+    state->last_change_ms = mode_ms();
 
     DEBUG4_VALUELN(" mode=", state->colorMode);
     DEBUG_MEMORY(DEBUG_MID);
@@ -332,10 +909,9 @@ boolean mode_snakes_init(msg_program_t *msg,
 boolean mode_snakes_2(output_hdr_t *output, void *object,
                         program_tracker_t *tracker) {
   mode_snake_data_t *state = (mode_snake_data_t *)tracker->state;
-  unsigned long now = time.ms();
+  unsigned long now = mode_ms();
 
-  if (now - state->last_change_ms >= state->hdr.period_ms) {
-    state->last_change_ms = now;
+  if (mode_tick(MODE_PERIOD_MS(state->hdr), &state->last_change_ms, now)) {
 
     /* Clear the tail */
     byte tri, vert;
@@ -387,7 +963,7 @@ boolean mode_snakes_2(output_hdr_t *output, void *object,
           }
         }
 
-        if ((triangles[tri].hasLeds()) &&
+        if ((vert < Triangle::NUM_LEDS) && (triangles[tri].hasLeds()) &&
             (triangles[tri].leds[vert].getCRGB() == state->bgColor)) {
           // Verify that the choosen vertex is dark
           found = true;
@@ -420,7 +996,8 @@ boolean mode_snakes_2(output_hdr_t *output, void *object,
     state->snakeTriangles[state->currentIndex] = tri;
     state->snakeVertices[state->currentIndex] = vert;
 
-    /* Set the led values */
+    /* Set the led values, spreading the palette over the length */
+    byte step = (state->length > 1) ? 255 / (state->length - 1) : 0;
     for (byte i = 0; i < state->length; i++) {
       byte valueIndex = (i + state->length - state->currentIndex) % state->length;
 
@@ -428,7 +1005,7 @@ boolean mode_snakes_2(output_hdr_t *output, void *object,
       switch (state->colorMode % 5) {
         default:
         case 0: {
-          color = pixel_wheel((byte)map(valueIndex, 0, state->length - 1, 0, 255));
+          color = mode_palette.pixel(valueIndex * step);
           break;
         }
         case 1: {
@@ -470,6 +1047,607 @@ boolean mode_snakes_2(output_hdr_t *output, void *object,
 
 
 
+/*
+ * Initialize the spatial mode.  data[0] selects the projection and data[1] is
+ * how far the colors shift each period.  The origin for distance projections
+ * is the top of the structure.
+ */
+boolean mode_spatial_init(msg_program_t *msg,
+                          program_tracker_t *tracker,
+                          output_hdr_t *output) {
+  if (mode_generic_init(msg, tracker, output)) {
+    if (mode_repeated) return true;
+    mode_data_t *state = (mode_data_t *)tracker->state;
+
+    geo_point_t origin = { 0, 0, GEO_COORD_MAX };
+    buildTriangleLUT(triangles, numTriangles,
+                     state->data[0] % SPATIAL_NUM_PROJECTIONS, origin,
+                     mode_buffer);
+
+    return true;
+  } else {
+    return false;
+  }
+}
+
+/*
+ * Sweep a color wheel across the structure along the spatial projection
+ */
+boolean mode_spatial(output_hdr_t *output, void *object,
+                     program_tracker_t *tracker) {
+  mode_data_t *state = (mode_data_t *)tracker->state;
+  unsigned long now = mode_ms();
+
+  if (mode_tick(MODE_PERIOD_MS(state->hdr), &state->last_change_ms, now)) {
+    /* The phase comes from the shared clock so that modules stay in step */
+    state->value = (now / MODE_PERIOD_MS(state->hdr)) * state->data[1];
+
+    byte *lut = mode_buffer;
+    for (int tri = 0; tri < numTriangles; tri++) {
+      for (byte led = 0; led < Triangle::NUM_LEDS; led++) {
+        triangles[tri].setColor(led, mode_palette.color(*lut++ + state->value));
+      }
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+/*
+ * Ripples spreading across the LEDs.  Distances from each splash are kept in
+ * the mode buffer for the ripples that are active.
+ */
+Ripples ripples;
+unsigned long ripple_splash_ms = 0;
+
+/*
+ * Initialize the ripples.  data[0] is the time between splashes in 100ms and
+ * data[1] is the time for a ripple to move one LED in 10ms.
+ */
+boolean mode_ripples_init(msg_program_t *msg,
+                          program_tracker_t *tracker,
+                          output_hdr_t *output) {
+  if (mode_generic_init(msg, tracker, output)) {
+    if (mode_repeated) return true;
+    mode_data_t *state = (mode_data_t *)tracker->state;
+
+    if (state->data[0] == 0) state->data[0] = 15;
+    if (state->data[1] == 0) state->data[1] = 12;
+
+    /* Splash on the first frame rather than whenever the last run splashed */
+    ripple_splash_ms = mode_ms() - state->data[0] * 100UL;
+
+    uint16_t ms_per_hop = state->data[1] * 10;
+    ripples = Ripples(triangleLedNeighbor,
+                      numTriangles * Triangle::NUM_LEDS, mode_buffer,
+                      ms_per_hop, 2, ms_per_hop * 8);
+    set_all_triangles(triangles, numTriangles, state->bgColor);
+
+    return true;
+  } else {
+    return false;
+  }
+}
+
+/*
+ * Splash randomly colored ripples from random LEDs
+ */
+boolean mode_ripples(output_hdr_t *output, void *object,
+                     program_tracker_t *tracker) {
+  mode_data_t *state = (mode_data_t *)tracker->state;
+  unsigned long now = mode_ms();
+
+  if (mode_tick(MODE_PERIOD_MS(state->hdr), &state->last_change_ms, now)) {
+
+    if (now - ripple_splash_ms >= state->data[0] * 100UL) {
+      ripple_splash_ms = now;
+      geo_led_t led = random(numTriangles * Triangle::NUM_LEDS);
+      ripples.splash(led, mode_palette.color(random(256)), now);
+    }
+
+    ripples.update(now);
+
+    geo_led_t led = 0;
+    for (int tri = 0; tri < numTriangles; tri++) {
+      for (byte vertex = 0; vertex < Triangle::NUM_LEDS; vertex++) {
+        triangles[tri].setColor(vertex, state->bgColor + ripples.color(led++));
+      }
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+/*
+ * Colors diffusing between neighboring LEDs, with random injections of new
+ * colors.
+ */
+Diffusion diffusion;
+
+/*
+ * Initialize diffusion.  data[0] is the rate of diffusion, data[1] is the
+ * chance out of 256 of injecting a color each period, and the fgColor is the
+ * per-channel decay.
+ */
+boolean mode_diffuse_init(msg_program_t *msg,
+                          program_tracker_t *tracker,
+                          output_hdr_t *output) {
+  if (mode_generic_init(msg, tracker, output)) {
+    if (mode_repeated) return true;
+    diffusion = Diffusion(triangleLedNeighbor,
+                          numTriangles * Triangle::NUM_LEDS, mode_buffer);
+    set_all_triangles(triangles, numTriangles, CRGB(0, 0, 0));
+    return true;
+  } else {
+    return false;
+  }
+}
+
+boolean mode_diffuse(output_hdr_t *output, void *object,
+                     program_tracker_t *tracker) {
+  mode_data_t *state = (mode_data_t *)tracker->state;
+  unsigned long now = mode_ms();
+
+  if (mode_tick(MODE_PERIOD_MS(state->hdr), &state->last_change_ms, now)) {
+
+    diffusion.step(triangleLedColor, state->data[0], state->fgColor);
+
+    geo_led_t led = 0;
+    for (int tri = 0; tri < numTriangles; tri++) {
+      for (byte vertex = 0; vertex < Triangle::NUM_LEDS; vertex++) {
+        triangles[tri].setColor(vertex, diffusion.value(led++));
+      }
+    }
+
+    if ((byte)random(256) < state->data[1]) {
+      led = random(numTriangles * Triangle::NUM_LEDS);
+      triangles[led / Triangle::NUM_LEDS].setColor(
+              led % Triangle::NUM_LEDS, mode_palette.color(random(256)));
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+
+/*
+ * Patterns are programs for PatternVM that are sent to the module in pieces
+ * and run by TRIANGLES_PATTERN.  The program is kept with its length so that
+ * the two can be saved to EEPROM together.
+ */
+typedef struct {
+  byte length;
+  byte code[VM_MAX_PROGRAM];
+} pattern_t;
+
+/*
+ * Pattern used until another is loaded, a wave of hue moving along the LEDs:
+ *   sin(led * 8 + time)
+ */
+const byte default_pattern[] PROGMEM = {
+        0, // No frame code
+        VM_LED, VM_SHL, 3, VM_TIME, VM_ADD, VM_SIN
+};
+
+pattern_t pattern;         // Pattern run by TRIANGLES_PATTERN
+pattern_t pattern_loading; // Pattern being received, checked before it is run
+PatternVM pattern_vm;
+int pattern_offset = -1; // EEPROM location of the saved pattern
+
+/*
+ * Read a pattern saved in EEPROM at the offset, returning false if none has
+ * been saved there.
+ */
+boolean read_pattern(int offset, pattern_t *saved) {
+  if (offset < 0) return false;
+
+  int newoffset = EEPROM_safe_read(offset, (byte *)saved, sizeof (pattern_t));
+  return ((newoffset - offset == EEPROM_SIZE(sizeof (pattern_t))) &&
+          (saved->length <= VM_MAX_PROGRAM));
+}
+
+/*
+ * Load the pattern saved in EEPROM at the offset, or the default pattern if
+ * none has been saved there.
+ */
+void init_pattern(int offset) {
+  pattern_offset = offset;
+
+  if (read_pattern(offset, &pattern)) {
+    DEBUG3_VALUELN("Read pattern len:", pattern.length);
+    return;
+  }
+
+  pattern.length = sizeof (default_pattern);
+  memcpy_P(pattern.code, default_pattern, sizeof (default_pattern));
+}
+
+/*
+ * Rewrite the triangle structure to EEPROM.  The structure may be written in
+ * a newer and larger format than the one that was read, so a saved pattern
+ * following it is moved to the new end of the structure.
+ */
+void save_triangle_structure() {
+  if (triangleConfigOffset < 0) return;
+
+  pattern_t saved;
+  boolean have_saved = read_pattern(pattern_offset, &saved);
+
+  int offset = writeTriangleStructure(triangles, numTriangles,
+                                      triangleConfigOffset);
+  if (offset < 0) return;
+  pattern_offset = offset;
+
+  if (have_saved) {
+    EEPROM_safe_write(pattern_offset, (byte *)&saved, sizeof (saved));
+  }
+}
+
+/*
+ * Write part of a pattern, or save the running pattern to EEPROM.  Pieces are
+ * collected apart from the running pattern, which the VM may be reading, and
+ * replace it once a following TRIANGLES_PATTERN has checked them.
+ */
+void pattern_load_msg(mode_pattern_load_t *load) {
+  if (!recent_controls.check(load->hdr.origin, load->hdr.sequence)) {
+    return;
+  }
+
+  if (load->offset == PATTERN_SAVE) {
+    if (pattern_offset >= 0) {
+      EEPROM_safe_write(pattern_offset, (byte *)&pattern, sizeof (pattern));
+      DEBUG3_VALUELN("Saved pattern len:", pattern.length);
+    }
+    return;
+  }
+
+  if ((load->count > PATTERN_LOAD_BYTES) ||
+      (load->offset + load->count > VM_MAX_PROGRAM)) {
+    DEBUG3_VALUELN("Bad pattern offset:", load->offset);
+    return;
+  }
+
+  /* Loading from the start begins a new pattern */
+  if (load->offset == 0) pattern_loading.length = 0;
+  memcpy(&pattern_loading.code[load->offset], load->code, load->count);
+  if (load->offset + load->count > pattern_loading.length) {
+    pattern_loading.length = load->offset + load->count;
+  }
+}
+
+boolean mode_pattern_init(msg_program_t *msg,
+                          program_tracker_t *tracker,
+                          output_hdr_t *output) {
+  if (mode_generic_init(msg, tracker, output)) {
+    if (mode_repeated) return true;
+
+    /* The VM's neighbor table holds each LED as a geo_led_t */
+    if (numTriangles * Triangle::NUM_LEDS > Geometry::NO_LED) {
+      DEBUG1_VALUELN("Too many LEDs for patterns:",
+                     numTriangles * Triangle::NUM_LEDS);
+      return false;
+    }
+    pattern_vm = PatternVM(triangleLedNeighbor,
+                           numTriangles * Triangle::NUM_LEDS, mode_buffer);
+
+    /* A loaded pattern is only run if the VM accepts it */
+    if (pattern_loading.length > 0) {
+      if (pattern_vm.load(pattern_loading.code, pattern_loading.length)) {
+        memcpy(&pattern, &pattern_loading, sizeof (pattern));
+      } else {
+        DEBUG1_PRINTLN("Rejected loaded pattern");
+      }
+      pattern_loading.length = 0;
+    }
+
+    return pattern_vm.load(pattern.code, pattern.length);
+  } else {
+    return false;
+  }
+}
+
+boolean mode_pattern(output_hdr_t *output, void *object,
+                     program_tracker_t *tracker) {
+  mode_data_t *state = (mode_data_t *)tracker->state;
+  unsigned long now = mode_ms();
+
+  if (mode_tick(MODE_PERIOD_MS(state->hdr), &state->last_change_ms, now)) {
+    /* Time is in periods of the shared clock so modules stay in step */
+    pattern_vm.frame(now / MODE_PERIOD_MS(state->hdr));
+
+    geo_led_t led = 0;
+    for (int tri = 0; tri < numTriangles; tri++) {
+      for (byte vertex = 0; vertex < Triangle::NUM_LEDS; vertex++) {
+        byte value = pattern_vm.value(led++);
+        switch (state->data[0]) {
+          case PATTERN_GRADIENT:
+            triangles[tri].setColor(vertex, blend(state->bgColor,
+                                                  state->fgColor, value));
+            break;
+          default:
+            triangles[tri].setColor(vertex, mode_palette.color(value));
+            break;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+
+/*
+ * Play an animation from flash, data[0] selecting the animation.  A period
+ * of 0 plays it at the period it was encoded with.
+ */
+Animation animation;
+
+void animation_set_color(geo_led_t led, CRGB color) {
+  triangles[led / Triangle::NUM_LEDS].setColor(led % Triangle::NUM_LEDS,
+                                               color);
+}
+
+boolean mode_animation_init(msg_program_t *msg,
+                            program_tracker_t *tracker,
+                            output_hdr_t *output) {
+  if (mode_generic_init(msg, tracker, output)) {
+    if (mode_repeated) return true;
+
+    mode_data_t *state = (mode_data_t *)tracker->state;
+    if (state->data[0] >= NUM_ANIMATIONS) return false;
+
+    animation = Animation(
+            (const byte *)pgm_read_word(&animations[state->data[0]]));
+    if (((mode_hdr_t *)msg->values)->period == 0) {
+      uint16_t period = MODE_PERIOD(animation.period());
+      state->hdr.period = constrain(period, 1, 255);
+    }
+
+    set_all_triangles(triangles, numTriangles, CRGB(0, 0, 0));
+    return true;
+  } else {
+    return false;
+  }
+}
+
+boolean mode_animation(output_hdr_t *output, void *object,
+                       program_tracker_t *tracker) {
+  mode_data_t *state = (mode_data_t *)tracker->state;
+  unsigned long now = mode_ms();
+
+  if (mode_tick(MODE_PERIOD_MS(state->hdr), &state->last_change_ms, now)) {
+    animation.frame(animation_set_color, numTriangles * Triangle::NUM_LEDS);
+    return true;
+  }
+
+  return false;
+}
+
+
+/*
+ * Slow effects draw into a ColorAccumulator in the mode buffer rather than
+ * the triangles, and it is copied to the triangles with a new dither pattern
+ * every DITHER_PERIOD_MS regardless of the mode's period.  A fade can then
+ * step by fractions of a level at a low period and still look smooth.
+ */
+ColorAccumulator accumulator;
+unsigned long dither_ms = 0;
+
+/*
+ * Copy the accumulated colors to the triangles if the next dither frame is
+ * due, returning true if they were copied.
+ */
+boolean dither_triangles(unsigned long now) {
+  if (now - dither_ms < DITHER_PERIOD_MS) return false;
+  dither_ms = now;
+
+  accumulator.nextFrame();
+  geo_led_t led = 0;
+  for (int tri = 0; tri < numTriangles; tri++) {
+    for (byte vertex = 0; vertex < Triangle::NUM_LEDS; vertex++) {
+      triangles[tri].setColor(vertex, accumulator.value(led++));
+    }
+  }
+
+  return true;
+}
+
+/*
+ * Palette colors sparkle on random LEDs and fade out slowly.  data[0] is the
+ * fade per period in 1/4096ths of the current level and data[1] the chance
+ * out of 256 of a sparkle each period.
+ */
+boolean mode_glitter_init(msg_program_t *msg,
+                          program_tracker_t *tracker,
+                          output_hdr_t *output) {
+  if (mode_generic_init(msg, tracker, output)) {
+    if (mode_repeated) return true;
+    accumulator = ColorAccumulator(numTriangles * Triangle::NUM_LEDS,
+                                   mode_buffer);
+    set_all_triangles(triangles, numTriangles, CRGB(0, 0, 0));
+    return true;
+  } else {
+    return false;
+  }
+}
+
+boolean mode_glitter(output_hdr_t *output, void *object,
+                     program_tracker_t *tracker) {
+  mode_data_t *state = (mode_data_t *)tracker->state;
+  unsigned long now = mode_ms();
+
+  if (mode_tick(MODE_PERIOD_MS(state->hdr), &state->last_change_ms, now)) {
+    accumulator.scaleAll(0xFFFF - state->data[0] * 16);
+
+    if ((byte)random(256) < state->data[1]) {
+      accumulator.set(random(accumulator.numLeds),
+                      mode_palette.color(random(256)));
+    }
+  }
+
+  return dither_triangles(now);
+}
+
+
+/*
+ * Sound levels from a sound unit.  The sound unit broadcasts its reply to a
+ * sensor request, so only the module that set the mode requests them and
+ * every module updates its features from the replies.
+ */
+AudioFeatures audio;
+unsigned long audio_request_ms = 0;
+
+/*
+ * Update the audio features from a sensor message, returning true if it had
+ * sound levels.
+ */
+boolean audio_msg(msg_hdr_t *msg) {
+  if (msg->type != MSG_TYPE_SENSOR) return false;
+
+  msg_sensor_data_t *sensor = NULL;
+  while ((sensor = hmtl_next_sensor(msg, sensor))) {
+    if (sensor->sensor_type == HMTL_SENSOR_SOUND) {
+      audio.update((uint16_t *)&sensor->data,
+                   sensor->data_len / sizeof (uint16_t), time.ms());
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Returns true if a sound mode is running on any output */
+boolean sound_mode_active() {
+  for (byte i = 0; i < config.num_outputs; i++) {
+    program_tracker_t *tracker = active_programs[i];
+    if ((tracker == NULL) || (tracker->program == NULL)) continue;
+    if ((tracker->program->type == TRIANGLES_SOUND_BANDS) ||
+        (tracker->program->type == TRIANGLES_SOUND_BEAT)) return true;
+  }
+  return false;
+}
+
+/*
+ * Request sound levels from the main loop when one is due and a sound mode is
+ * running.  The sound unit broadcasts its reply, so only the reference module
+ * asks while another module is beaconing.  A mode started by a controller
+ * that doesn't beacon leaves no reference, and then each module running a
+ * sound mode asks for itself.
+ */
+void request_audio() {
+  if (!sound_mode_active()) return;
+
+  unsigned long now = time.ms();
+  if (!clock_sync.isReference(config.address) &&
+      clock_sync.hasRemoteReference(now)) return;
+
+  if (now - audio_request_ms < AUDIO_REQUEST_MS) return;
+  audio_request_ms = now;
+
+  hmtl_send_sensor_request(&rs485, rs485.send_buffer, rs485.send_data_size,
+                           ADDRESS_SOUND_UNIT);
+}
+
+/*
+ * Each triangle shows one band in its palette color, with two vertices at the
+ * band's level and the third at its held peak.  bgColor is shown when no
+ * sound unit is responding.
+ */
+boolean mode_sound_bands(output_hdr_t *output, void *object,
+                         program_tracker_t *tracker) {
+  mode_data_t *state = (mode_data_t *)tracker->state;
+  unsigned long now = mode_ms();
+
+  if (mode_tick(MODE_PERIOD_MS(state->hdr), &state->last_change_ms, now)) {
+    if (!audio.active(time.ms())) {
+      set_all_triangles(triangles, numTriangles, state->bgColor);
+      return true;
+    }
+
+    for (int tri = 0; tri < numTriangles; tri++) {
+      byte band = tri % AUDIO_BANDS;
+      CRGB color = mode_palette.color(band * (256 / AUDIO_BANDS));
+      CRGB level = color;
+      level.nscale8(audio.band(band));
+      color.nscale8(audio.peak(band));
+
+      triangles[tri].setColor(0, level);
+      triangles[tri].setColor(1, level);
+      triangles[tri].setColor(2, color);
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+/*
+ * Ripples splash from a random LED on each beat over a background of bgColor
+ * that follows the sound's energy.  data[0] is the time for a ripple to move
+ * one LED in 10ms.
+ */
+boolean mode_sound_beat_init(msg_program_t *msg,
+                             program_tracker_t *tracker,
+                             output_hdr_t *output) {
+  if (mode_generic_init(msg, tracker, output)) {
+    if (mode_repeated) return true;
+    mode_data_t *state = (mode_data_t *)tracker->state;
+
+    if (state->data[0] == 0) state->data[0] = 8;
+    state->value = audio.beats();
+
+    uint16_t ms_per_hop = state->data[0] * 10;
+    ripples = Ripples(triangleLedNeighbor,
+                      numTriangles * Triangle::NUM_LEDS, mode_buffer,
+                      ms_per_hop, 2, ms_per_hop * 6);
+    set_all_triangles(triangles, numTriangles, CRGB(0, 0, 0));
+
+    return true;
+  } else {
+    return false;
+  }
+}
+
+boolean mode_sound_beat(output_hdr_t *output, void *object,
+                        program_tracker_t *tracker) {
+  mode_data_t *state = (mode_data_t *)tracker->state;
+  unsigned long now = mode_ms();
+
+  if (mode_tick(MODE_PERIOD_MS(state->hdr), &state->last_change_ms, now)) {
+
+    if (state->value != audio.beats()) {
+      state->value = audio.beats();
+      geo_led_t led = random(numTriangles * Triangle::NUM_LEDS);
+      ripples.splash(led, mode_palette.color(random(256)), now);
+    }
+
+    ripples.update(now);
+
+    CRGB background = state->bgColor;
+    background.nscale8(audio.active(time.ms()) ? audio.energy() : 0);
+
+    geo_led_t led = 0;
+    for (int tri = 0; tri < numTriangles; tri++) {
+      for (byte vertex = 0; vertex < Triangle::NUM_LEDS; vertex++) {
+        triangles[tri].setColor(vertex, background + ripples.color(led++));
+      }
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+
 /*********************** OLD STUFF ********************************************/
 
 /*******************************************************************************
@@ -499,7 +1677,7 @@ void colorWhiteBuildupFade(Triangle *current, byte currVertex,
   next->setColor(nextVertex, 255, 0, 0);
 }
 
-/* Pixels are set to a pixel_wheel value and face over time */
+/* Pixels are set to a palette color and fade over time */
 void colorRainbowTrail(Triangle *current, byte currVertex,
 		       Triangle *next, byte nextVertex,
 		       Triangle *triangles, byte size,
@@ -509,7 +1687,7 @@ void colorRainbowTrail(Triangle *current, byte currVertex,
   // Perhaps a shift instead?  How to achieve an evenish fade?
   incrementAll(triangles, size, increment, increment, increment);
 
-  next->setColor(nextVertex, pixel_wheel(wheel_position));
+  next->setColor(nextVertex, mode_palette.pixel(wheel_position));
   wheel_position += 5;
 }
 
@@ -1183,7 +2361,7 @@ void trianglesSnake(Triangle *triangles, int size, int periodms,
     switch (colorMode % 5) {
     case 0: {
       for (int i = 0; i < SNAKE_LENGTH; i++) {
-	values[i] = pixel_wheel(map(i, 0, SNAKE_LENGTH - 1, 0, 255));
+	values[i] = mode_palette.pixel(map(i, 0, SNAKE_LENGTH - 1, 0, 255));
       }
       break;
     }
@@ -1342,7 +2520,7 @@ void trianglesSnake2(Triangle *triangles, int size, int periodms,
     switch (colorMode % 1) {
       case 0: {
         for (int i = 0; i < SNAKE2_LENGTH; i++) {
-          values[i] = pixel_wheel(map(i, 0, SNAKE2_LENGTH - 1, 0, 255));
+          values[i] = mode_palette.pixel(map(i, 0, SNAKE2_LENGTH - 1, 0, 255));
         }
         break;
       }
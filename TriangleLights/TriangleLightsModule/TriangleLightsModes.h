@@ -16,32 +16,113 @@
 #include <HMTLProtocol.h>
 
 
-/* Wireless pendant programs */
-#define TRIANGLES_SET_ALL      0x20
-#define TRIANGLES_STATIC_NOISE 0x21
-#define TRIANGLES_SNAKES_2     0x22
+/*
+ * Wireless pendant programs.  The types also identify the layout of the mode
+ * messages, they moved from 0x20 when the mode header changed so that
+ * messages from older senders are ignored rather than misread.
+ */
+#define TRIANGLES_SET_ALL      0x30
+#define TRIANGLES_STATIC_NOISE 0x31
+#define TRIANGLES_SNAKES_2     0x32
+#define TRIANGLES_SPATIAL      0x33
+#define TRIANGLES_RIPPLES      0x34
+#define TRIANGLES_DIFFUSE      0x35
+#define TRIANGLES_PATTERN      0x36
+#define TRIANGLES_PATTERN_LOAD 0x37
+#define TRIANGLES_ANIMATION    0x38
+#define TRIANGLES_GLITTER      0x39
+#define TRIANGLES_SOUND_BANDS  0x3A
+#define TRIANGLES_SOUND_BEAT   0x3B
+
+/*
+ * Time beacon from the module that set the current mode, and the ping that
+ * the others send it to measure how long a beacon takes to arrive.
+ */
+#define TRIANGLES_CLOCK_PING   0x3E
+#define TRIANGLES_CLOCK_SYNC   0x3F
+
+/* Programs that draw into the triangles rather than directly to an output */
+#define IS_TRIANGLE_PROGRAM(type) \
+  (((type) >= TRIANGLES_SET_ALL) && ((type) <= TRIANGLES_CLOCK_SYNC))
+
+/*
+ * Every mode message is identified by the module that sent it and that
+ * module's sequence number, so that copies of a broadcast that arrive by
+ * more than one route are only acted on once.  A module with more than one
+ * socket passes a broadcast on to its other sockets, counting the hops in
+ * the header up to MESSAGE_MAX_HOPS.
+ *
+ * The period is sent in units of MODE_PERIOD_UNIT_MS so that the header
+ * still fits in 4 bytes with a full module address.
+ */
+#define MODE_PERIOD_UNIT_MS 5
+#define MODE_PERIOD(ms)     ((ms) / MODE_PERIOD_UNIT_MS)
+#define MODE_PERIOD_MS(hdr) ((uint16_t)(hdr).period * MODE_PERIOD_UNIT_MS)
 
 typedef struct {
-  uint16_t period_ms; // 2B
+  uint16_t origin;    // 2B
+  uint8_t sequence:6; // 1B, with the hops
+  uint8_t hops:2;
+  uint8_t period;     // 1B, in MODE_PERIOD_UNIT_MS
 
   uint8_t data[0];
 } mode_hdr_t;
 
 typedef struct {
-  mode_hdr_t hdr;     // 2B
+  mode_hdr_t hdr;     // 4B
 
   CRGB bgColor;       // 3B
   CRGB fgColor;       // 3B
-  uint8_t  data[4];   // 4B
+  uint8_t  data[2];   // 2B
 
-  // Total: 10B
+  // Total: 12B
 
   unsigned long last_change_ms;
+  uint8_t value;      // Working value for the mode, not part of the message
 } mode_data_t;
 
+/*
+ * Beacons and pings are broadcast like the modes so that they are relayed,
+ * with target being the module a ping or its answer is for.  A ping carries
+ * the low bits of the sender's clock in echo_ms, and the answer returns them.
+ */
+typedef struct {
+  mode_hdr_t hdr;     // 4B, period is unused
+  uint32_t ms;        // 4B, mode clock of the sender
+  uint16_t target;    // 2B, SOCKET_ADDR_ANY for a periodic beacon
+  uint16_t echo_ms;   // 2B
+} mode_clock_sync_t;
+
+/*
+ * Part of a pattern program, count bytes to be written at offset.  An offset
+ * of PATTERN_SAVE instead saves the pattern being run to EEPROM, so a new
+ * pattern is saved once a TRIANGLES_PATTERN has accepted it.
+ */
+#define PATTERN_LOAD_BYTES 6
+#define PATTERN_SAVE       0xFF
+typedef struct {
+  mode_hdr_t hdr;     // 4B, period is unused
+  uint8_t offset;     // 1B
+  uint8_t count;      // 1B
+  uint8_t code[PATTERN_LOAD_BYTES];
+} mode_pattern_load_t;
+
+/* Colors for pattern values, TRIANGLES_PATTERN's data[0] */
+#define PATTERN_WHEEL    0 // Color wheel
+#define PATTERN_GRADIENT 1 // From bgColor to fgColor
+
+#define DITHER_PERIOD_MS 10 // Time between dither frames of a slow mode
+
+#ifndef ADDRESS_SOUND_UNIT
+  #define ADDRESS_SOUND_UNIT 0x08
+#endif
+#define AUDIO_REQUEST_MS 50 // Interval between requests for sound levels
+
+#define CLOCK_BEACON_MS 5000 // Interval between beacons
+
 #define SNAKE_MAX_LENGTH 12
 typedef struct {
-  mode_hdr_t hdr; // 2B
+  mode_hdr_t hdr; // 4B
 
   CRGB bgColor;   // 3B
   byte colorMode; // 1B
@@ -54,6 +135,14 @@ typedef struct {
   unsigned long last_change_ms;
 } mode_snake_data_t;
 
+/*
+ * Bytes of each mode's data that are sent in its program message, anything
+ * after them is working state of the running mode.
+ */
+#define MODE_DATA_MSG_SIZE  offsetof(mode_data_t, last_change_ms)
+#define MODE_SNAKE_MSG_SIZE offsetof(mode_snake_data_t, snakeTriangles)
+#define MODE_CLOCK_MSG_SIZE (sizeof (mode_clock_sync_t))
+
 
 /* Initialize the message and mode handlers */
 void init_modes(Socket **sockets, byte num_sockets);
@@ -67,9 +156,32 @@ void update_mode_from_button();
 /* Set the current mode */
 boolean set_mode(byte mode, boolean broadcast);
 
+/* Broadcast the mode clock if this module is the reference */
+void send_clock_beacon();
+
+/* Load the pattern saved at an EEPROM offset, or -1 for the default */
+void init_pattern(int offset);
+
+/* Write the triangle structure to EEPROM, keeping the saved pattern after it */
+void save_triangle_structure();
+
 /* Issue initial commands */
 void startup_commands();
 
+/* Clock used by all modes, may be stepped manually for rendering tests */
+unsigned long mode_ms();
+
+/* Render frames of a mode from a fixed seed at unlimited speed */
+#define RENDER_HASH   0
+#define RENDER_FRAMES 1
+#define RENDER_TIME   2
+
+#define RENDER_EEPROM      0
+#define RENDER_ICOSOHEDRON 1
+#define RENDER_CYLINDER    2
+void render_frames(byte mode, unsigned long seed, uint16_t frames,
+                   byte topology, byte output);
+
 
 /*
  * Programs
@@ -80,6 +192,22 @@ boolean mode_static_noise(output_hdr_t *output, void *object,
                           program_tracker_t *tracker);
 boolean mode_snakes_2(output_hdr_t *output, void *object,
                           program_tracker_t *tracker);
+boolean mode_spatial(output_hdr_t *output, void *object,
+                     program_tracker_t *tracker);
+boolean mode_ripples(output_hdr_t *output, void *object,
+                     program_tracker_t *tracker);
+boolean mode_diffuse(output_hdr_t *output, void *object,
+                     program_tracker_t *tracker);
+boolean mode_pattern(output_hdr_t *output, void *object,
+                     program_tracker_t *tracker);
+boolean mode_animation(output_hdr_t *output, void *object,
+                       program_tracker_t *tracker);
+boolean mode_glitter(output_hdr_t *output, void *object,
+                     program_tracker_t *tracker);
+boolean mode_sound_bands(output_hdr_t *output, void *object,
+                         program_tracker_t *tracker);
+boolean mode_sound_beat(output_hdr_t *output, void *object,
+                        program_tracker_t *tracker);
 
 boolean mode_generic_init(msg_program_t *msg,
                           program_tracker_t *tracker,
@@ -87,6 +215,27 @@ boolean mode_generic_init(msg_program_t *msg,
 boolean mode_snakes_init(msg_program_t *msg,
                           program_tracker_t *tracker,
                           output_hdr_t *output);
+boolean mode_spatial_init(msg_program_t *msg,
+                          program_tracker_t *tracker,
+                          output_hdr_t *output);
+boolean mode_ripples_init(msg_program_t *msg,
+                          program_tracker_t *tracker,
+                          output_hdr_t *output);
+boolean mode_diffuse_init(msg_program_t *msg,
+                          program_tracker_t *tracker,
+                          output_hdr_t *output);
+boolean mode_pattern_init(msg_program_t *msg,
+                          program_tracker_t *tracker,
+                          output_hdr_t *output);
+boolean mode_animation_init(msg_program_t *msg,
+                            program_tracker_t *tracker,
+                            output_hdr_t *output);
+boolean mode_glitter_init(msg_program_t *msg,
+                          program_tracker_t *tracker,
+                          output_hdr_t *output);
+boolean mode_sound_beat_init(msg_program_t *msg,
+                             program_tracker_t *tracker,
+                             output_hdr_t *output);
 
 void setAllTriangles(Triangle *triangles, int size, uint32_t color);
 
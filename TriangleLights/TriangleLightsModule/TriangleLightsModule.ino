@@ -26,15 +26,12 @@
 #include "Socket.h"
 #include "RS485Utils.h"
 #include "XBeeSocket.h"
-#include "SerialCLI.h"
 
 #include "ObjectConfiguration.h"
 #include "TriangleStructure.h"
 #include "TriangleLights.h"
 #include "TriangleLightsModes.h"
 
-extern SerialCLI serialcli;
-
 PixelUtil pixels;
 
 RS485Socket rs485;
@@ -48,6 +45,7 @@ Socket *sockets[MAX_SOCKETS] = { NULL };
 
 int numTriangles = 0;
 Triangle *triangles;
+int triangleConfigOffset = -1; // EEPROM location of the triangle structure
 
 #define SETUP_STATE 0 // Used during structure configuration
 
@@ -94,9 +92,13 @@ void setup()
   initializePins();
 
   /* Read the triangle structure from EEPROM */
-  readTriangleStructure(configOffset, 
-                        &triangles,
-                        &numTriangles);
+  triangleConfigOffset = configOffset;
+  int patternOffset = readTriangleStructure(configOffset,
+                                            &triangles,
+                                            &numTriangles);
+
+  /* A saved pattern follows the triangle structure */
+  init_pattern(patternOffset);
 
   DEBUG2_VALUELN("Inited with numTriangles:", numTriangles);
 
@@ -106,9 +108,6 @@ void setup()
 
 void loop() {
 
-  // TODO: How to read HTML commands and CLI commands at the same time
-  // serialcli.checkSerial();
-
   // TODO: This should be changing the program
   update_mode_from_button();
 
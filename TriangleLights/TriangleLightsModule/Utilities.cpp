@@ -8,6 +8,7 @@
 #endif
 #include <Debug.h>
 
+#include "Palette.h"
 #include "Utilities.h"
 
 #include "TriangleLights.h"
@@ -38,9 +39,11 @@ void randomTriangles(Triangle *triangles, int size) {
   }
 }
 
+extern Palette mode_palette;
+
 void wheelTriangles(Triangle *triangles, int size) {
   for (int tri = 0; tri < size; tri++) {
-    triangles[tri].setColor(pixel_wheel(map(tri, 0, size - 1, 0, 255)));
+    triangles[tri].setColor(mode_palette.pixel(map(tri, 0, size - 1, 0, 255)));
   }
 }
 
@@ -0,0 +1,145 @@
+#!/usr/bin/env python
+################################################################################
+# Author: Adam Phelps
+# License: Create Commons Attribution-Non-Commercial
+# Copyright: 2016
+#
+# Encode RGB frames as an animation for Animation.h, written as a header with
+# a PROGMEM array.
+#
+# The input is the binary output of the module's 'g' command in frame mode
+# ('g <program> <seed> <frames> <e|i|c> b'), which is an 'F' followed by the
+# RGB bytes of every LED for each frame, or a raw file of RGB frames with
+# --raw.  Any text around the frames is ignored.
+#
+# Colors are reduced to at most 256 by dropping low bits of each channel until
+# they fit in the palette.
+################################################################################
+
+import argparse
+import struct
+import sys
+
+MAX_RUN = 128
+RUN = 0x80
+
+
+def read_frames(data, num_leds, raw):
+    size = num_leds * 3
+    frames = []
+    pos = 0
+    while True:
+        if not raw:
+            pos = data.find(b'F', pos)
+            if pos < 0:
+                break
+            pos += 1
+        if pos + size > len(data):
+            break
+        frame = data[pos:pos + size]
+        frames.append([tuple(bytearray(frame[i:i + 3]))
+                       for i in range(0, size, 3)])
+        pos += size
+    return frames
+
+
+def quantize(frames):
+    """Drop low bits until the frames use at most 256 colors"""
+    for bits in range(0, 8):
+        mask = (0xFF << bits) & 0xFF
+        colors = set()
+        for frame in frames:
+            for rgb in frame:
+                colors.add(tuple(c & mask for c in rgb))
+        if len(colors) <= 256:
+            break
+
+    palette = sorted(colors)
+    index = dict((color, i) for i, color in enumerate(palette))
+    encoded = [[index[tuple(c & mask for c in rgb)] for rgb in frame]
+               for frame in frames]
+    return palette, encoded, bits
+
+
+def encode_frame(frame, previous):
+    out = bytearray()
+    led = 0
+    while led < len(frame):
+        if previous is not None and frame[led] == previous[led]:
+            length = 1
+            while (led + length < len(frame) and length < MAX_RUN and
+                   frame[led + length] == previous[led + length]):
+                length += 1
+            out.append(length - 1)
+        else:
+            length = 1
+            while (led + length < len(frame) and length < MAX_RUN and
+                   frame[led + length] == frame[led]):
+                length += 1
+            out.append(RUN | (length - 1))
+            out.append(frame[led])
+        led += length
+    return out
+
+
+def encode(frames, num_leds, period_ms):
+    palette, indexed, bits = quantize(frames)
+
+    # animation_hdr_t, little endian and packed as on the AVR
+    data = bytearray(struct.pack('<HHHB', num_leds, len(indexed), period_ms,
+                                 len(palette) & 0xFF))
+    for color in palette:
+        data.extend(bytearray(color))
+
+    # The first frame is always complete so that playback can loop to it
+    previous = None
+    for frame in indexed:
+        data.extend(encode_frame(frame, previous))
+        previous = frame
+
+    return data, len(palette), bits
+
+
+def write_header(out, name, data, comment):
+    out.write('/* %s */\n' % comment)
+    out.write('const byte %s[] PROGMEM = {\n' % name)
+    for i in range(0, len(data), 12):
+        line = ', '.join('0x%02X' % b for b in data[i:i + 12])
+        out.write('        %s,\n' % line)
+    out.write('};\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Encode RGB frames as an animation')
+    parser.add_argument('input', help='File of frames')
+    parser.add_argument('-n', '--leds', type=int, required=True,
+                        help='Number of LEDs in each frame')
+    parser.add_argument('-p', '--period', type=int, default=50,
+                        help='Milliseconds per frame')
+    parser.add_argument('--name', default='animation',
+                        help='Name of the array')
+    parser.add_argument('--raw', action='store_true',
+                        help='Input is only RGB frames')
+    parser.add_argument('-o', '--output', help='Header to write')
+    args = parser.parse_args()
+
+    with open(args.input, 'rb') as f:
+        frames = read_frames(f.read(), args.leds, args.raw)
+    if not frames:
+        sys.exit('No frames found')
+
+    data, colors, bits = encode(frames, args.leds, args.period)
+
+    comment = '%d frames of %d LEDs, %d colors, %d bytes' % \
+              (len(frames), args.leds, colors, len(data))
+    if bits > 0:
+        comment += ', %d bits dropped per channel' % bits
+
+    out = open(args.output, 'w') if args.output else sys.stdout
+    write_header(out, args.name, data, comment)
+    sys.stderr.write(comment + '\n')
+
+
+if __name__ == '__main__':
+    main()
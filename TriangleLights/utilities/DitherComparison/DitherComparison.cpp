@@ -0,0 +1,126 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host comparison of a slow fade in 8-bit colors against the same fade in a
+ * ColorAccumulator shown with temporal dithering.
+ *
+ * Every LED fades at the glitter mode's default rate, about 1% per period,
+ * and the accumulator is read out for several dither frames per period.  The
+ * error is the mean difference from an exact floating point fade, with the
+ * dithered value averaged over its frames as the eye would see it.  The CPU
+ * cost is the time per LED of a fade step and of a dithered readout.
+ *
+ * Build, using the host stand ins from the mode regression:
+ *   g++ -std=gnu++11 -O2 -I../ModeRegression/host
+ *       -I../../../Libraries/ObjectLibrary DitherComparison.cpp
+ *       ../../../Libraries/ObjectLibrary/ColorAccumulator.cpp
+ *       -o DitherComparison
+ ******************************************************************************/
+
+#include <chrono>
+#include <math.h>
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+#include "ColorAccumulator.h"
+
+#define NUM_LEDS       174  // 58 triangles
+#define FADE_PERIODS   600
+#define FRAMES_PER_PERIOD 10  // 100ms period, 10ms dither frames
+#define TIMING_ROUNDS  20000
+
+/* The glitter mode's default fade, data[0] of 40 */
+#define FADE_SCALE     (0xFFFF - 40 * 16)
+
+byte buffer[COLOR_ACCUMULATOR_BUFFER_SIZE(NUM_LEDS)];
+byte levels[NUM_LEDS];
+double ideal[NUM_LEDS];
+double average[NUM_LEDS];
+
+typedef std::chrono::steady_clock host_clock;
+
+double ns_per_led(host_clock::time_point start, host_clock::time_point end) {
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+    TIMING_ROUNDS / NUM_LEDS;
+}
+
+void fade_levels() {
+  for (int led = 0; led < NUM_LEDS; led++) {
+    levels[led] = ((uint32_t)levels[led] * FADE_SCALE) >> 16;
+  }
+}
+
+int main(int argc, char **argv) {
+  ColorAccumulator accumulator(NUM_LEDS, buffer);
+
+  /* Start each LED at a different level so the fade covers every level */
+  for (int led = 0; led < NUM_LEDS; led++) {
+    byte level = 255 - led;
+    accumulator.set(led, CRGB(level, level, level));
+    levels[led] = level;
+    ideal[led] = level;
+  }
+
+  double error_8bit = 0;
+  double error_dithered = 0;
+  unsigned long samples = 0;
+
+  for (int period = 0; period < FADE_PERIODS; period++) {
+    accumulator.scaleAll(FADE_SCALE);
+    fade_levels();
+
+    for (int led = 0; led < NUM_LEDS; led++) {
+      ideal[led] *= FADE_SCALE / 65536.0;
+      average[led] = 0;
+    }
+
+    for (int frame = 0; frame < FRAMES_PER_PERIOD; frame++) {
+      accumulator.nextFrame();
+      for (int led = 0; led < NUM_LEDS; led++) {
+        average[led] += accumulator.value(led).r;
+      }
+    }
+
+    for (int led = 0; led < NUM_LEDS; led++) {
+      /* Skip LEDs that have faded below the lowest level */
+      if (ideal[led] < 0.5) continue;
+      error_8bit += fabs(levels[led] - ideal[led]);
+      error_dithered += fabs(average[led] / FRAMES_PER_PERIOD - ideal[led]);
+      samples++;
+    }
+  }
+
+  printf("Mean error in levels over %lu samples: 8-bit %.3f dithered %.3f\n",
+         samples, error_8bit / samples, error_dithered / samples);
+
+  volatile byte sink = 0;
+  host_clock::time_point start = host_clock::now();
+  for (int round = 0; round < TIMING_ROUNDS; round++) {
+    fade_levels();
+    sink += levels[round % NUM_LEDS];
+  }
+
+  host_clock::time_point faded_8bit = host_clock::now();
+  for (int round = 0; round < TIMING_ROUNDS; round++) {
+    accumulator.scaleAll(FADE_SCALE);
+  }
+
+  host_clock::time_point faded_16bit = host_clock::now();
+  for (int round = 0; round < TIMING_ROUNDS; round++) {
+    accumulator.nextFrame();
+    for (int led = 0; led < NUM_LEDS; led++) {
+      sink += accumulator.value(led).r;
+    }
+  }
+  host_clock::time_point dithered = host_clock::now();
+
+  printf("ns per LED: 8-bit fade %.2f, 16-bit fade %.2f, "
+         "dithered readout %.2f\n",
+         ns_per_led(start, faded_8bit), ns_per_led(faded_8bit, faded_16bit),
+         ns_per_led(faded_16bit, dithered));
+
+  return 0;
+}
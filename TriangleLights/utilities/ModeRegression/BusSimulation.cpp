@@ -0,0 +1,181 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host simulation of broadcasts between modules on shared buses.  Every
+ * module on a bus receives whatever is sent on it, and a module on more than
+ * one bus passes a broadcast on to its other buses when its MessageRelay
+ * says to, as relay_msg() does for the triangle modules.  Each module also
+ * keeps the RecentMessages of the ids it has acted on, as the modes do.
+ *
+ * The buses are joined in a loop, so that without the relay's checks a
+ * broadcast would circulate forever.  The checks are that every module acts
+ * on each broadcast once, that a bridging module passes each one on at most
+ * once, and that a storm of broadcasts from more modules than the recent
+ * message cache holds still dies out within the hop limit.
+ * mode_regression.py runs it along with the mode runs.
+ *
+ * Usage:
+ *   BusSimulation
+ *       Prints each failed check and exits non-zero if any failed
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#include "MessageRelay.h"
+#include "RecentMessages.h"
+
+#define NUM_NODES 10
+#define NUM_BUSES 3
+#define MAX_PENDING 256
+
+/*
+ * Buses each node is on, as a bit per bus.  Bus 0 is RS485 and buses 1 and 2
+ * are radios, with nodes 0, 4, 5, 8 and 9 bridging them into a loop.
+ */
+const byte node_buses[NUM_NODES] = {
+  0x5, 0x1, 0x1, 0x1, 0x3, 0x3, 0x2, 0x2, 0x6, 0x6
+};
+
+typedef struct {
+  byte bus;
+  byte sender;
+  uint16_t origin;
+  byte sequence;
+  byte hops;
+} transmission_t;
+
+transmission_t pending[MAX_PENDING];
+uint16_t pending_head, pending_count;
+
+MessageRelay relays[NUM_NODES];
+RecentMessages handled[NUM_NODES];
+uint16_t acted[NUM_NODES];
+uint16_t sent[NUM_NODES];
+uint16_t transmissions;
+byte max_hops;
+
+int failures = 0;
+
+#define CHECK(cond) \
+  if (!(cond)) { printf("FAIL line %d: %s\n", __LINE__, #cond); failures++; }
+
+void reset() {
+  for (byte node = 0; node < NUM_NODES; node++) {
+    relays[node] = MessageRelay();
+    handled[node] = RecentMessages();
+    acted[node] = 0;
+    sent[node] = 0;
+  }
+  pending_head = 0;
+  pending_count = 0;
+  transmissions = 0;
+  max_hops = 0;
+}
+
+/* Queue a message to be sent on every bus of a node but one */
+boolean send(byte node, byte except, uint16_t origin, byte sequence,
+             byte hops) {
+  for (byte bus = 0; bus < NUM_BUSES; bus++) {
+    if (!(node_buses[node] & (1 << bus)) || (bus == except)) continue;
+    if (pending_count == MAX_PENDING) return false;
+
+    transmission_t *t = &pending[(pending_head + pending_count++) %
+                                 MAX_PENDING];
+    t->bus = bus;
+    t->sender = node;
+    t->origin = origin;
+    t->sequence = sequence;
+    t->hops = hops;
+    sent[node]++;
+  }
+  return true;
+}
+
+/* Deliver transmissions until none are left, false if they never stop */
+boolean run() {
+  while (pending_count > 0) {
+    transmission_t t = pending[pending_head];
+    pending_head = (pending_head + 1) % MAX_PENDING;
+    pending_count--;
+
+    if (++transmissions > 10000) return false;
+    if (t.hops > max_hops) max_hops = t.hops;
+
+    for (byte node = 0; node < NUM_NODES; node++) {
+      if ((node == t.sender) || !(node_buses[node] & (1 << t.bus))) continue;
+      if (node == t.origin) continue; // A module ignores its own messages
+
+      if (handled[node].check(t.origin, t.sequence)) acted[node]++;
+      if (relays[node].forward(t.origin, t.sequence, t.hops)) {
+        if (!send(node, t.bus, t.origin, t.sequence, t.hops + 1)) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/* A single broadcast reaches every node once and is relayed once per node */
+void test_single() {
+  for (byte origin = 0; origin < NUM_NODES; origin++) {
+    reset();
+    send(origin, NUM_BUSES, origin, 1, 0);
+    CHECK(run());
+
+    for (byte node = 0; node < NUM_NODES; node++) {
+      if (node == origin) continue;
+      if (acted[node] != 1) {
+        printf("FAIL from %u: node %u acted %u times\n", origin, node,
+               acted[node]);
+        failures++;
+      }
+      byte buses = 0;
+      for (byte bus = 0; bus < NUM_BUSES; bus++) {
+        if (node_buses[node] & (1 << bus)) buses++;
+      }
+      if (sent[node] > buses - 1) {
+        printf("FAIL from %u: node %u sent %u times\n", origin, node,
+               sent[node]);
+        failures++;
+      }
+    }
+    CHECK(max_hops <= MESSAGE_MAX_HOPS);
+  }
+}
+
+/*
+ * Broadcasts from every node at once, several times over, so that the recent
+ * message caches overflow and copies are passed on again.  The hop limit
+ * still ends them and every node acts on every broadcast.
+ */
+#define STORM_ROUNDS 4
+void test_storm() {
+  reset();
+  for (byte round = 0; round < STORM_ROUNDS; round++) {
+    for (byte origin = 0; origin < NUM_NODES; origin++) {
+      send(origin, NUM_BUSES, origin, round, 0);
+    }
+  }
+  CHECK(run());
+  CHECK(max_hops <= MESSAGE_MAX_HOPS);
+
+  for (byte node = 0; node < NUM_NODES; node++) {
+    /* Repeats are only acted on when the ids fell out of the cache */
+    if (acted[node] < (NUM_NODES - 1) * STORM_ROUNDS) {
+      printf("FAIL storm: node %u acted %u times\n", node, acted[node]);
+      failures++;
+    }
+  }
+  printf("storm: transmissions:%u max_hops:%u\n", transmissions, max_hops);
+}
+
+int main() {
+  test_single();
+  test_storm();
+
+  printf("failures:%d\n", failures);
+  return (failures > 0) ? 1 : 0;
+}
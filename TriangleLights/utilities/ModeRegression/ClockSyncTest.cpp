@@ -0,0 +1,109 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host test of ClockSync's latency compensation.  A reference and a follower
+ * whose clocks started at different times exchange beacons, pings and their
+ * answers over a link that takes a fixed time in each direction.  Once a
+ * round trip has been measured the follower's shared clock must match the
+ * reference's to within a millisecond, where before it ran behind by the
+ * link's delay.  mode_regression.py runs it along with the mode runs.
+ *
+ * Usage:
+ *   ClockSyncTest
+ *       Prints each failed check and exits non-zero if any failed
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#include "ClockSync.h"
+
+#define REFERENCE 0x10
+#define FOLLOWER  0x20
+
+/* Local clocks of the two modules, the follower started later */
+#define FOLLOWER_START_MS 7345
+#define BEACON_MS 5000
+
+int failures = 0;
+
+#define CHECK(cond) \
+  if (!(cond)) { printf("FAIL line %d: %s\n", __LINE__, #cond); failures++; }
+
+/* Error of the follower's shared clock at reference time now */
+long clock_error(ClockSync *reference, ClockSync *follower,
+                 unsigned long now) {
+  return (long)(follower->ms(now - FOLLOWER_START_MS) - reference->ms(now));
+}
+
+/*
+ * Run the two modules for a number of beacons with the given delay in each
+ * direction, returning the follower's clock error after the last one.
+ */
+long run(ClockSync *reference, ClockSync *follower, unsigned long *now,
+         byte beacons, uint16_t delay_ms) {
+  for (byte i = 0; i < beacons; i++) {
+    *now += BEACON_MS;
+    unsigned long sent = reference->ms(*now);
+    *now += delay_ms;
+    follower->beacon(REFERENCE, sent, *now - FOLLOWER_START_MS);
+
+    if (follower->ping(*now - FOLLOWER_START_MS)) {
+      uint16_t ping_ms = (uint16_t)(*now - FOLLOWER_START_MS);
+      *now += delay_ms;
+      unsigned long answer = reference->ms(*now);
+      *now += delay_ms;
+      follower->echo(REFERENCE, answer, ping_ms, *now - FOLLOWER_START_MS);
+    }
+  }
+  return clock_error(reference, follower, *now);
+}
+
+int main() {
+  ClockSync reference, follower;
+  reference.setReference(REFERENCE);
+  unsigned long now = 20000;
+
+  /* The first beacon is taken as is and runs behind by the delay */
+  now += BEACON_MS;
+  follower.beacon(REFERENCE, reference.ms(now), now + 30 - FOLLOWER_START_MS);
+  now += 30;
+  CHECK(clock_error(&reference, &follower, now) == -30);
+  CHECK(follower.getLatency() == 0);
+
+  /* Its ping measures the round trip and the answer closes the gap */
+  CHECK(follower.ping(now - FOLLOWER_START_MS));
+  uint16_t ping_ms = (uint16_t)(now - FOLLOWER_START_MS);
+  now += 60;
+  follower.echo(REFERENCE, reference.ms(now - 30), ping_ms,
+                now - FOLLOWER_START_MS);
+  CHECK(follower.getLatency() == 30);
+  CHECK(labs(clock_error(&reference, &follower, now)) <= 1);
+
+  /* Later beacons stay compensated without another ping for a while */
+  CHECK(labs(run(&reference, &follower, &now, 4, 30)) <= 1);
+  CHECK(!follower.ping(now - FOLLOWER_START_MS));
+
+  /* The link slows down, the next pings follow it */
+  now += CLOCK_SYNC_PING_MS;
+  run(&reference, &follower, &now, 40, 60);
+  CHECK(follower.getLatency() >= 55);
+  CHECK(labs(clock_error(&reference, &follower, now)) <= 5);
+
+  /* An answer that took too long is ignored */
+  uint16_t latency = follower.getLatency();
+  ping_ms = (uint16_t)(now - FOLLOWER_START_MS);
+  now += CLOCK_SYNC_MAX_RTT_MS + 1;
+  follower.echo(REFERENCE, reference.ms(now), ping_ms,
+                now - FOLLOWER_START_MS);
+  CHECK(follower.getLatency() == latency);
+
+  /* A new reference starts over without a latency */
+  follower.beacon(REFERENCE + 1, 0, now - FOLLOWER_START_MS);
+  CHECK(follower.getLatency() == 0);
+  CHECK(follower.ping(now - FOLLOWER_START_MS));
+
+  printf("latency:%u failures:%d\n", latency, failures);
+  return (failures > 0) ? 1 : 0;
+}
@@ -0,0 +1,184 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host build of the cube's square modes.  Each 1ms of the stepped clock the
+ * cube's handle_messages() is called and then the mode, as the sketch's loop
+ * does, and the hash of the squares' colors is printed halfway through each
+ * of the mode's periods, or every CUBE_MIN_FRAME_MS for the faster modes.
+ * mode_regression.py compares these against saved runs.  The microseconds
+ * spent in the mode's calls are printed to stderr, for timing a mode between
+ * trees built with --tree.
+ *
+ * A made up sound unit replies to the cube's sensor requests with the levels
+ * from host_sound_msg(), and to the sound test's single byte requests with
+ * the raw levels.  The touch and range sensors are never triggered.
+ *
+ * Usage:
+ *   CubeRegression list
+ *       Print the name of each mode
+ *   CubeRegression <mode> <seed> <frames>
+ *       Render frames of a mode on the cube
+ ******************************************************************************/
+
+#include <sys/time.h>
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include <Debug.h>
+
+#include "CubeConfig.h"
+#include "CubeLights.h"
+
+/* Globals that the sketch and its sensors provide */
+#define NUM_PIXELS (NUM_SQUARES * Square::NUM_LEDS + FIRST_LED)
+PixelUtil pixels(NUM_PIXELS);
+Square *squares;
+
+MPR121 touch_sensor;
+uint32_t sensor_state = 0;
+int range_cm = 0;
+uint16_t photo_value = 0;
+boolean photo_dark = false;
+
+pattern_args_t modeConfigs[MAX_MODES];
+
+void initializeConnect();
+void handle_messages();
+
+/* Only later versions of the cube cache the steps between LEDs */
+void buildSquareSteps(Square *squares, int numSquares) __attribute__((weak));
+
+typedef struct {
+  const char *name;
+  square_mode_t function;
+  byte index; // Into modePeriods
+} cube_mode_t;
+
+cube_mode_t cube_modes[] = {
+  { "AllOn",          squaresAllOn,          MODE_ALL_ON },
+  { "TestPattern",    squaresTestPattern,    MODE_TEST_PATTERN },
+  { "SetupPattern",   squaresSetupPattern,   MODE_SETUP_PATTERN },
+  { "RandomNeighbor", squaresRandomNeighbor, MODE_RANDOM_NEIGHBOR },
+  { "CyclePattern",   squaresCyclePattern,   MODE_CYCLE_PATTERN },
+  { "CirclePattern",  squaresCirclePattern,  MODE_CIRCLE_PATTERN },
+  { "FadeCycle",      squaresFadeCycle,      MODE_FADE_CYCLE },
+  { "CapResponse",    squaresCapResponse,    MODE_CAP_RESPONSE },
+  { "StaticNoise",    squaresStaticNoise,    MODE_STATIC_NOISE },
+  { "SwitchRandom",   squaresSwitchRandom,   MODE_SWITCH_RANDOM },
+  { "LightCenter",    squaresLightCenter,    MODE_LIGHT_CENTER },
+  { "BarCircle",      squaresBarCircle,      MODE_BAR_CIRCLE },
+  { "Crawl",          squaresCrawl,          MODE_CRAWL },
+  { "BlinkPattern",   squaresBlinkPattern,   MODE_BLINK_PATTERN },
+  { "OrbitTest",      squaresOrbitTest,      MODE_ORBIT_TEST },
+  { "Vectors",        squaresVectors,        MODE_VECTORS },
+  { "SimpleLife",     squaresSimpleLife,     MODE_SIMPLE_LIFE },
+  { "SoundTest",      squaresSoundTest,      MODE_SOUND_TEST },
+  { "SoundHMTL",      squaresSoundHMTL,      MODE_SOUND_HMTL },
+  { "Strobe",         squaresStrobe,         MODE_STROBE },
+#ifdef MODE_RIPPLES
+  { "Ripples",        squaresRipples,        MODE_RIPPLES },
+#endif
+};
+#define NUM_CUBE_MODES (sizeof (cube_modes) / sizeof (cube_mode_t))
+
+#define CUBE_MIN_FRAME_MS 20
+
+/* Reply to the requests sent to the sound unit */
+void sound_unit(socket_addr_t address, const byte *data, byte len) {
+  if (address != ADDRESS_SOUND_UNIT) return;
+
+  const msg_hdr_t *msg = (const msg_hdr_t *)data;
+  if ((len >= sizeof (msg_hdr_t)) && (msg->startcode == HMTL_MSG_START)) {
+    if (msg->type == MSG_TYPE_SENSOR) {
+      byte reply[HOST_MSG_SIZE];
+      host_sound_msg(reply, millis());
+      host_queue_msg((msg_hdr_t *)reply);
+    }
+  } else if (len > 0) {
+    uint16_t levels[HOST_SOUND_BANDS];
+    host_sound_levels(levels, millis());
+    host_queue_data((byte *)levels, sizeof (levels));
+  }
+}
+
+/* Wall clock time, as the host's micros() follows the stepped clock */
+uint64_t wall_us() {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (uint64_t)now.tv_sec * 1000000UL + now.tv_usec;
+}
+
+/* FNV-1a over the colors of every LED */
+uint32_t hash_squares() {
+  uint32_t hash = 2166136261UL;
+  for (int face = 0; face < NUM_SQUARES; face++) {
+    for (byte led = 0; led < Square::NUM_LEDS; led++) {
+      PRGB *rgb = &(squares[face].leds[led]);
+      hash = (hash ^ rgb->red) * 16777619UL;
+      hash = (hash ^ rgb->green) * 16777619UL;
+      hash = (hash ^ rgb->blue) * 16777619UL;
+    }
+  }
+  return hash;
+}
+
+int main(int argc, char **argv) {
+  if ((argc == 2) && (strcmp(argv[1], "list") == 0)) {
+    for (byte i = 0; i < NUM_CUBE_MODES; i++) {
+      printf("%s\n", cube_modes[i].name);
+    }
+    return 0;
+  }
+
+  if (argc != 4) {
+    fprintf(stderr, "Usage: %s list | <mode> <seed> <frames>\n", argv[0]);
+    return 1;
+  }
+
+  cube_mode_t *mode = NULL;
+  for (byte i = 0; i < NUM_CUBE_MODES; i++) {
+    if (strcmp(argv[1], cube_modes[i].name) == 0) mode = &cube_modes[i];
+  }
+  if (mode == NULL) {
+    fprintf(stderr, "Unknown mode: %s\n", argv[1]);
+    return 1;
+  }
+
+  int numSquares;
+  squares = buildCube(&numSquares, pixels.numPixels(), FIRST_LED);
+  if (buildSquareSteps) buildSquareSteps(squares, NUM_SQUARES);
+
+  initializeConnect();
+  host_send_hook = sound_unit;
+
+  randomSeed(strtoul(argv[2], NULL, 0));
+  uint16_t frames = strtol(argv[3], NULL, 0);
+
+  pattern_args_t *args = &modeConfigs[0];
+  args->bgColor = pixel_color(0, 0, 0);
+  args->fgColor = pixel_color(0xFF, 0xFF, 0xFF);
+  args->periodms = modePeriods[mode->index];
+
+  unsigned long frame_ms = max(args->periodms, CUBE_MIN_FRAME_MS);
+  uint16_t frame = 0;
+  uint64_t mode_us = 0;
+  while (frame < frames) {
+    host_advance_us(1000);
+    handle_messages();
+
+    uint64_t start = wall_us();
+    mode->function(squares, NUM_SQUARES, args);
+    mode_us += wall_us() - start;
+
+    if (millis() % frame_ms == frame_ms / 2) {
+      printf("frame:%u ms:%lu hash:%08X\n", frame, millis(), hash_squares());
+      frame++;
+    }
+  }
+
+  printf("frames:%u\n", frame);
+  fprintf(stderr, "frames:%u us:%lu\n", frame, (unsigned long)mode_us);
+  return 0;
+}
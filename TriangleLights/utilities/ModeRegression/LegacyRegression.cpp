@@ -0,0 +1,140 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host build of the patterns of the original TriangleLights sketch.  A pattern
+ * is called every 1ms of the stepped clock, as the sketch's loop does, and
+ * the hash of the triangles' colors is printed halfway through each of its
+ * periods.  mode_regression.py compares these against saved runs.
+ *
+ * Usage:
+ *   LegacyRegression list
+ *       Print the name of each pattern
+ *   LegacyRegression <i|c> <pattern> <seed> <frames>
+ *       Render frames of a pattern on the icosohedron or cylinder
+ ******************************************************************************/
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include <Debug.h>
+
+#include "TriangleLights.h"
+
+/* Globals that the sketch provides */
+#define NUM_PIXELS (TRI_ARRAY_SIZE * Triangle::NUM_LEDS)
+PixelUtil pixels(NUM_PIXELS);
+RS485Socket rs485;
+byte my_address = 0;
+
+int numTriangles = 0;
+Triangle *triangles;
+
+/* Inputs that the host doesn't have */
+byte get_button_value() { return 0; }
+uint16_t get_photo_value() { return 0; }
+uint16_t get_pot_value() { return 0; }
+
+/* Every pattern with its period from the sketch's modePeriods */
+#define MODE_PERIOD 50
+typedef struct {
+  const char *name;
+  triangle_mode_t function;
+  int periodms;
+} pattern_t;
+
+pattern_t patterns[] = {
+  { "TestPattern",     trianglesTestPattern,     500 },
+  { "RandomNeighbor",  trianglesRandomNeighbor,  MODE_PERIOD },
+  { "SwapPattern",     trianglesSwapPattern,     10 },
+  { "LifePattern",     trianglesLifePattern,     500 },
+  { "LifePattern2",    trianglesLifePattern2,    500 },
+  { "CircleCorner",    trianglesCircleCorner,    MODE_PERIOD },
+  { "Buildup",         trianglesBuildup,         MODE_PERIOD },
+  { "StaticNoise",     trianglesStaticNoise,     MODE_PERIOD },
+  { "CircleCorner2",   trianglesCircleCorner2,   MODE_PERIOD },
+  { "Circle",          trianglesCircle,          MODE_PERIOD },
+  { "Snake",           trianglesSnake,           MODE_PERIOD },
+  { "Snake2",          trianglesSnake2,          MODE_PERIOD },
+  { "SetAll",          trianglesSetAll,          1000 },
+  { "Looping",         trianglesLooping,         MODE_PERIOD },
+  { "VertexShift",     trianglesVertexShift,     MODE_PERIOD * 2 },
+  { "VertexMerge",     trianglesVertexMerge,     MODE_PERIOD },
+  { "VertexMergeFade", trianglesVertexMergeFade, MODE_PERIOD },
+};
+#define NUM_PATTERNS (sizeof (patterns) / sizeof (pattern_t))
+
+pattern_args_t patternConfig = {
+  pixel_color(0, 0, 0), // bgColor
+  pixel_color(0xFF, 0xFF, 0xFF) // fgColor
+};
+
+/* FNV-1a over the colors of every LED */
+uint32_t hash_triangles() {
+  uint32_t hash = 2166136261UL;
+  for (int tri = 0; tri < numTriangles; tri++) {
+    for (byte led = 0; led < Triangle::NUM_LEDS; led++) {
+      PRGB *rgb = &(triangles[tri].leds[led]);
+      hash = (hash ^ rgb->red) * 16777619UL;
+      hash = (hash ^ rgb->green) * 16777619UL;
+      hash = (hash ^ rgb->blue) * 16777619UL;
+    }
+  }
+  return hash;
+}
+
+int main(int argc, char **argv) {
+  if ((argc == 2) && (strcmp(argv[1], "list") == 0)) {
+    for (byte i = 0; i < NUM_PATTERNS; i++) {
+      printf("%s\n", patterns[i].name);
+    }
+    return 0;
+  }
+
+  if (argc != 5) {
+    fprintf(stderr, "Usage: %s list | <i|c> <pattern> <seed> <frames>\n",
+            argv[0]);
+    return 1;
+  }
+
+  switch (argv[1][0]) {
+    case 'i':
+      triangles = buildIcosohedron(&numTriangles, pixels.numPixels());
+      break;
+    case 'c':
+      triangles = buildCylinder(&numTriangles, pixels.numPixels());
+      break;
+    default:
+      fprintf(stderr, "Unknown topology: %s\n", argv[1]);
+      return 1;
+  }
+
+  pattern_t *pattern = NULL;
+  for (byte i = 0; i < NUM_PATTERNS; i++) {
+    if (strcmp(argv[2], patterns[i].name) == 0) pattern = &patterns[i];
+  }
+  if (pattern == NULL) {
+    fprintf(stderr, "Unknown pattern: %s\n", argv[2]);
+    return 1;
+  }
+
+  randomSeed(strtoul(argv[3], NULL, 0));
+  uint16_t frames = strtol(argv[4], NULL, 0);
+
+  boolean init = true;
+  uint16_t frame = 0;
+  while (frame < frames) {
+    host_advance_us(1000);
+    pattern->function(triangles, numTriangles, pattern->periodms, init,
+                      &patternConfig);
+    init = false;
+
+    if (millis() % pattern->periodms == (unsigned long)pattern->periodms / 2) {
+      printf("frame:%u ms:%lu hash:%08X\n", frame, millis(), hash_triangles());
+      frame++;
+    }
+  }
+
+  printf("frames:%u\n", frame);
+  return 0;
+}
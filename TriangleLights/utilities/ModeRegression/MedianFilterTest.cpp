@@ -0,0 +1,105 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host test of the range finder's MedianFilter.  Each sequence is the
+ * readings that the cube's sensor_range() would add, with PING_MAX_CM for a
+ * ping that timed out or returned no echo, and the median expected after
+ * each reading.  With an even number of readings the median is the upper of
+ * the middle two.  mode_regression.py runs it along with the mode runs.
+ *
+ * Usage:
+ *   MedianFilterTest
+ *       Prints each failed step and exits non-zero if any failed
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#include "MedianFilter.h"
+
+#define MAX_STEPS 12
+
+typedef struct {
+  const char *name;
+  byte steps;
+  uint16_t readings[MAX_STEPS];
+  uint16_t medians[MAX_STEPS];
+} filter_sequence_t;
+
+/* PING_MAX_CM from CubeLights.h, which would pull in the cube's structure */
+#define M 100
+
+filter_sequence_t sequences[] = {
+  {
+    "Steady", 6,
+    { 40, 40, 40, 40, 40, 40 },
+    { 40, 40, 40, 40, 40, 40 }
+  },
+  {
+    /* A single reflection or missed echo doesn't move the range */
+    "Outliers", 10,
+    { 40, 41, 40, 3, 42, 41, M, 40, 39, 41 },
+    { 40, 41, 40, 40, 40, 41, 41, 41, 41, 41 }
+  },
+  {
+    /* Two wild readings in the window are still outvoted */
+    "Outlier pair", 7,
+    { 30, 30, 30, 30, 30, M, M },
+    { 30, 30, 30, 30, 30, 30, 30 }
+  },
+  {
+    /* Pings that time out take over once they are the majority */
+    "Timeouts", 9,
+    { 25, 26, 25, M, M, M, M, M, 25 },
+    { 25, 26, 25, 26, 26, M, M, M, M }
+  },
+  {
+    /* Something approaching is followed after half the window */
+    "Approach", 8,
+    { M, M, M, M, M, 60, 50, 40 },
+    { M, M, M, M, M, M, M, 60 }
+  },
+  {
+    /* Readings dropping out one at a time don't lose the range */
+    "Dropouts", 10,
+    { 70, M, 70, M, 68, 69, M, 70, 71, M },
+    { 70, M, 70, M, 70, 70, 70, 70, 70, 71 }
+  },
+};
+#define NUM_SEQUENCES (sizeof (sequences) / sizeof (filter_sequence_t))
+
+int main() {
+  int failures = 0;
+  MedianFilter filter;
+
+  if ((filter.count() != 0) || (filter.value() != 0)) {
+    printf("FAIL Empty: count %u value %u\n", filter.count(), filter.value());
+    failures++;
+  }
+
+  for (byte i = 0; i < NUM_SEQUENCES; i++) {
+    filter_sequence_t *seq = &sequences[i];
+    filter.clear();
+
+    for (byte step = 0; step < seq->steps; step++) {
+      filter.add(seq->readings[step]);
+      uint16_t median = filter.value();
+      if (median != seq->medians[step]) {
+        printf("FAIL %s step %u: median %u expected %u\n", seq->name, step,
+               median, seq->medians[step]);
+        failures++;
+      }
+    }
+
+    byte expected = min(seq->steps, MEDIAN_FILTER_SIZE);
+    if (filter.count() != expected) {
+      printf("FAIL %s: count %u expected %u\n", seq->name, filter.count(),
+             expected);
+      failures++;
+    }
+  }
+
+  printf("sequences:%u failures:%d\n", (unsigned)NUM_SEQUENCES, failures);
+  return (failures > 0) ? 1 : 0;
+}
@@ -0,0 +1,113 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host test of MessageBatch.  Commands for one or more modules are packed
+ * into a batch as the cube's sendHMTL*() functions do, and must unpack in the
+ * order they were added with their own addresses.  A command that doesn't
+ * fit is refused without harming the batch, and a batch cut short unpacks
+ * only the messages that arrived whole.  mode_regression.py runs it along
+ * with the mode runs.
+ *
+ * Usage:
+ *   MessageBatchTest
+ *       Prints each failed check and exits non-zero if any failed
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#include "MessageBatch.h"
+
+#define POOFER 0x41
+#define LIGHTS 0x42
+#define BUFFER_SIZE 64
+
+byte buffer[BUFFER_SIZE];
+
+int failures = 0;
+
+#define CHECK(cond) \
+  if (!(cond)) { printf("FAIL line %d: %s\n", __LINE__, #cond); failures++; }
+
+boolean add_value(MessageBatch *batch, uint16_t address, int value) {
+  return batch->add(hmtl_value_fmt(batch->tail(), batch->space(),
+                                   address, 3, value));
+}
+
+boolean add_change(MessageBatch *batch, uint16_t address) {
+  return batch->add(hmtl_timed_change_fmt(batch->tail(), batch->space(),
+                                          address, 0, 30000, 0xFFFFFFFF, 0));
+}
+
+/* Check that a message is an output message for the address and output */
+boolean is_output(msg_hdr_t *msg, uint16_t address, byte type) {
+  if ((msg == NULL) || (msg->type != MSG_TYPE_OUTPUT) ||
+      (msg->address != address)) {
+    return false;
+  }
+  return ((output_hdr_t *)(msg + 1))->type == type;
+}
+
+int main() {
+  MessageBatch batch(buffer, BUFFER_SIZE);
+
+  /* Nothing to send */
+  CHECK(batch.finish() == 0);
+
+  /* Commands for one module are addressed to it */
+  CHECK(add_value(&batch, POOFER, 255));
+  CHECK(add_change(&batch, POOFER));
+  CHECK(batch.count() == 2);
+  uint16_t length = batch.finish();
+  msg_hdr_t *hdr = (msg_hdr_t *)buffer;
+  CHECK(length == hdr->length);
+  CHECK(hdr->type == MSG_TYPE_BATCH);
+  CHECK(hdr->address == POOFER);
+
+  msg_hdr_t *msg = MessageBatch::unpack(hdr, NULL);
+  CHECK(is_output(msg, POOFER, HMTL_OUTPUT_VALUE));
+  CHECK(*(uint16_t *)((output_hdr_t *)(msg + 1) + 1) == 255);
+  msg = MessageBatch::unpack(hdr, msg);
+  CHECK(is_output(msg, POOFER, HMTL_OUTPUT_PROGRAM));
+  CHECK(MessageBatch::unpack(hdr, msg) == NULL);
+
+  /* A command that doesn't fit is refused and the rest still unpack */
+  CHECK(!add_change(&batch, POOFER));
+  CHECK(batch.count() == 2);
+  CHECK(batch.finish() == length);
+
+  /* Commands for several modules go to every module */
+  batch.clear();
+  CHECK(add_value(&batch, POOFER, 8));
+  CHECK(add_value(&batch, LIGHTS, 0));
+  CHECK(add_value(&batch, POOFER, 0));
+  length = batch.finish();
+  CHECK(hdr->address == SOCKET_ADDR_ANY);
+
+  uint16_t expected[] = { POOFER, LIGHTS, POOFER };
+  byte count = 0;
+  msg = NULL;
+  while ((msg = MessageBatch::unpack(hdr, msg)) != NULL) {
+    CHECK((count < 3) && is_output(msg, expected[count], HMTL_OUTPUT_VALUE));
+    count++;
+  }
+  CHECK(count == 3);
+
+  /* A batch cut short in its last message stops before it */
+  hdr->length = length - 1;
+  count = 0;
+  msg = NULL;
+  while ((msg = MessageBatch::unpack(hdr, msg)) != NULL) count++;
+  CHECK(count == 2);
+
+  /* A message that isn't HMTL ends the batch */
+  hdr->length = length;
+  msg = MessageBatch::unpack(hdr, NULL);
+  msg = MessageBatch::unpack(hdr, msg);
+  msg->startcode = 0;
+  CHECK(MessageBatch::unpack(hdr, MessageBatch::unpack(hdr, NULL)) == NULL);
+
+  printf("failures:%d\n", failures);
+  return (failures > 0) ? 1 : 0;
+}
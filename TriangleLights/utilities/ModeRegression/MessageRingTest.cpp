@@ -0,0 +1,110 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host test of MessageRing.  Views must keep their data while newer messages
+ * are pushed, and a slot must only be reused once it and every older message
+ * have been released, in whatever order the views are released.
+ * mode_regression.py runs it along with the mode runs.
+ *
+ * Usage:
+ *   MessageRingTest
+ *       Prints each failed check and exits non-zero if any failed
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#include "MessageRing.h"
+
+#define SLOTS 3
+#define SLOT_SIZE 8
+
+byte buffer[MESSAGE_RING_SIZE(SLOTS, SLOT_SIZE)];
+
+int failures = 0;
+
+#define CHECK(cond) \
+  if (!(cond)) { printf("FAIL line %d: %s\n", __LINE__, #cond); failures++; }
+
+/* Push a message of length bytes that all hold value */
+boolean push(MessageRing *ring, byte value, byte length) {
+  byte msg[SLOT_SIZE + 1];
+  memset(msg, value, sizeof (msg));
+  return ring->push(msg, length);
+}
+
+/* Check that a view still holds the message push() made */
+boolean holds(message_view_t *view, byte value, byte length) {
+  if (view->length != length) return false;
+  for (byte i = 0; i < length; i++) {
+    if (view->data[i] != value) return false;
+  }
+  return true;
+}
+
+int main() {
+  MessageRing ring(buffer, SLOTS, SLOT_SIZE);
+  message_view_t views[SLOTS];
+  message_view_t extra;
+
+  CHECK(ring.count() == 0);
+  CHECK(!ring.view(0, &extra));
+
+  /* Fill the ring, the next message is refused and counted */
+  CHECK(push(&ring, 0xA1, 3));
+  CHECK(push(&ring, 0xA2, 8));
+  CHECK(push(&ring, 0xA3, 1));
+  CHECK(ring.full());
+  CHECK(!push(&ring, 0xA4, 2));
+  CHECK(ring.stats.full == 1);
+  CHECK(ring.stats.received == 3);
+  CHECK(ring.stats.high_water == 3);
+
+  for (byte i = 0; i < SLOTS; i++) {
+    CHECK(ring.view(i, &views[i]));
+  }
+  CHECK(holds(&views[0], 0xA1, 3));
+  CHECK(holds(&views[1], 0xA2, 8));
+  CHECK(holds(&views[2], 0xA3, 1));
+
+  /* Releasing a newer message doesn't free its slot before the oldest */
+  ring.release(&views[1]);
+  CHECK(ring.count() == 3);
+  CHECK(ring.full());
+  CHECK(!ring.view(1, &extra));
+  CHECK(holds(&views[0], 0xA1, 3));
+  CHECK(holds(&views[2], 0xA3, 1));
+
+  /* Releasing the oldest frees both */
+  ring.release(&views[0]);
+  CHECK(ring.count() == 1);
+
+  /* New messages wrap into the freed slots without touching the held view */
+  CHECK(push(&ring, 0xB1, 5));
+  CHECK(push(&ring, 0xB2, 2));
+  CHECK(ring.full());
+  CHECK(holds(&views[2], 0xA3, 1));
+
+  CHECK(ring.view(0, &views[0]));
+  CHECK(holds(&views[0], 0xA3, 1));
+  CHECK(ring.view(1, &views[1]));
+  CHECK(holds(&views[1], 0xB1, 5));
+  CHECK(ring.view(2, &extra));
+  CHECK(holds(&extra, 0xB2, 2));
+
+  /* Released in reverse the ring empties on the last release */
+  ring.release(&extra);
+  ring.release(&views[1]);
+  CHECK(ring.count() == 3);
+  ring.release(&views[0]);
+  CHECK(ring.count() == 0);
+
+  /* A message larger than a slot is dropped */
+  CHECK(!push(&ring, 0xC1, SLOT_SIZE + 1));
+  CHECK(ring.stats.oversize == 1);
+  CHECK(ring.count() == 0);
+
+  printf("failures:%d\n", failures);
+  return (failures > 0) ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host build of the triangle module's modes, which starts a mode with the
+ * module's set_mode() and runs it with messages_and_modes() as the module's
+ * loop does, stepping the clock 1ms per call.  The hash of the triangles'
+ * colors is printed for every call that produced a frame, and
+ * mode_regression.py compares these against saved runs.
+ *
+ * Only the functions and globals that every version of the module has are
+ * used, so the same runner can render an earlier tree for comparison.
+ *
+ * Sound levels from a made up sound unit are received every
+ * HOST_SOUND_REPORT_MS, with a beat every HOST_SOUND_BEAT_MS.  If resend is
+ * given the mode is set again every resend frames with new colors, for the
+ * modes that only show their colors, or with the snake's next color mode.
+ *
+ * Usage:
+ *   ModeRegression list
+ *       Print the program type of each triangle mode in the program table
+ *   ModeRegression <i|c> <program> <seed> <frames> [resend]
+ *       Render frames of a program on the icosohedron or cylinder
+ ******************************************************************************/
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include <Debug.h>
+
+#include <HMTLTypes.h>
+#include <MessageHandler.h>
+#include <ProgramManager.h>
+#include <TimeSync.h>
+
+#include "TriangleLights.h"
+#include "TriangleLightsModes.h"
+
+/* Globals that the module's sketch provides */
+#define NUM_PIXELS (TRI_ARRAY_SIZE * Triangle::NUM_LEDS)
+PixelUtil pixels(NUM_PIXELS);
+
+RS485Socket rs485;
+#define SEND_BUFFER_SIZE 64
+byte rs485_data_buffer[RS485_BUFFER_TOTAL(SEND_BUFFER_SIZE)];
+Socket *sockets[1] = { &rs485 };
+
+int numTriangles = 0;
+Triangle *triangles;
+int triangleConfigOffset = -1;
+
+#define MAX_OUTPUTS 1
+config_hdr_t config;
+output_hdr_t pixel_output = { HMTL_OUTPUT_PIXELS, 0 };
+output_hdr_t *outputs[MAX_OUTPUTS] = { &pixel_output };
+void *objects[MAX_OUTPUTS] = { &pixels };
+
+TimeSync time;
+
+/* Inputs that the host doesn't have */
+byte get_button_value() { return 0; }
+byte get_pot_byte() { return 255; }
+void cliHandler(char **, byte) {}
+
+/* Only later versions of the module save a pattern */
+void init_pattern(int offset) __attribute__((weak));
+
+extern ProgramManager manager;
+
+#define MAX_STEP_MS 60000
+
+/* Time the module has been up when the mode is set, as after a button press */
+#define START_MS 10000
+
+/* FNV-1a over the colors of every LED */
+uint32_t hash_triangles() {
+  uint32_t hash = 2166136261UL;
+  for (int tri = 0; tri < numTriangles; tri++) {
+    for (byte led = 0; led < Triangle::NUM_LEDS; led++) {
+      PRGB *rgb = &(triangles[tri].leds[led]);
+      hash = (hash ^ rgb->red) * 16777619UL;
+      hash = (hash ^ rgb->green) * 16777619UL;
+      hash = (hash ^ rgb->blue) * 16777619UL;
+    }
+  }
+  return hash;
+}
+
+/*
+ * When set the next program message gets new colors from color_seed, or the
+ * snake's next color mode
+ */
+boolean vary_colors = false;
+uint16_t color_seed = 0;
+byte snake_color_mode = 0;
+
+byte next_color() {
+  color_seed = (color_seed * 2053) + 13849;
+  return color_seed >> 8;
+}
+
+void set_colors(msg_program_t *msg) {
+  if (!vary_colors) return;
+  vary_colors = false;
+
+  if (msg->type == TRIANGLES_SNAKES_2) {
+    mode_snake_data_t *data = (mode_snake_data_t *)msg->values;
+    data->colorMode = snake_color_mode++;
+    return;
+  }
+
+  mode_data_t *data = (mode_data_t *)msg->values;
+  data->bgColor = CRGB(next_color(), next_color(), next_color());
+  data->fgColor = CRGB(next_color(), next_color(), next_color());
+}
+
+int main(int argc, char **argv) {
+  config.address = 0x100;
+  config.num_outputs = MAX_OUTPUTS;
+  rs485.initBuffer(rs485_data_buffer, SEND_BUFFER_SIZE);
+
+  if ((argc == 2) && (strcmp(argv[1], "list") == 0)) {
+    triangles = buildIcosohedron(&numTriangles, pixels.numPixels());
+    init_modes(sockets, 1);
+    for (byte i = 0; i < manager.num_functions; i++) {
+      hmtl_program_t *function = &manager.functions[i];
+      if ((function->type > HMTL_PROGRAM_SPARKLE) &&
+          (function->program != NULL)) {
+        printf("0x%02X\n", function->type);
+      }
+    }
+    return 0;
+  }
+
+  if ((argc != 5) && (argc != 6)) {
+    fprintf(stderr, "Usage: %s list | "
+            "<i|c> <program> <seed> <frames> [resend]\n", argv[0]);
+    return 1;
+  }
+
+  switch (argv[1][0]) {
+    case 'i':
+      triangles = buildIcosohedron(&numTriangles, pixels.numPixels());
+      break;
+    case 'c':
+      triangles = buildCylinder(&numTriangles, pixels.numPixels());
+      break;
+    default:
+      fprintf(stderr, "Unknown topology: %s\n", argv[1]);
+      return 1;
+  }
+
+  byte program = strtol(argv[2], NULL, 0);
+  unsigned long seed = strtoul(argv[3], NULL, 0);
+  uint16_t frames = strtol(argv[4], NULL, 0);
+  uint16_t resend = (argc == 6) ? strtol(argv[5], NULL, 0) : 0;
+
+  /* The module starts its startup mode before any other is chosen */
+  init_modes(sockets, 1);
+  if (init_pattern) init_pattern(-1);
+
+  randomSeed(seed);
+  random16_set_seed((uint16_t)seed);
+  color_seed = (uint16_t)seed;
+  host_program_hook = set_colors;
+
+  host_advance_us(START_MS * 1000UL);
+
+  uint16_t frame = 0;
+  if (set_mode(program, false)) {
+    unsigned long steps = 0;
+    for (frame = 0; frame < frames; frame++) {
+      boolean rendered;
+      do {
+        host_advance_us(1000);
+        if (millis() % HOST_SOUND_REPORT_MS == 0) {
+          byte msg[HOST_MSG_SIZE];
+          host_sound_msg(msg, millis());
+          host_queue_msg((msg_hdr_t *)msg);
+        }
+        rendered = messages_and_modes();
+      } while (!rendered && (++steps < MAX_STEP_MS));
+      if (!rendered) break;
+      steps = 0;
+
+      printf("frame:%u ms:%lu hash:%08X\n", frame, millis(), hash_triangles());
+
+      if ((resend != 0) && ((frame + 1) % resend == 0)) {
+        vary_colors = true;
+        set_mode(program, false);
+      }
+    }
+  }
+
+  printf("frames:%u\n", frame);
+  return 0;
+}
@@ -0,0 +1,120 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for the parts of the Arduino core used by the modes.  Time
+ * and random() follow the AVR versions so that a render matches the module's
+ * as closely as the differing int size allows.
+ ******************************************************************************/
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+#define INPUT  0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+
+#define DEC 10
+#define HEX 16
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define memcpy_P memcpy
+
+/* Tables of pointers in flash are read as words, which are too small here */
+inline uint16_t pgm_read_word(const void *p) { return *(const uint16_t *)p; }
+template <typename T> inline T *pgm_read_word(T * const *p) { return *p; }
+
+#define _BV(bit) (1 << (bit))
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+#define word(h, l) ((uint16_t)(((h) << 8) | (l)))
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define constrain(amt, low, high) \
+  ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define noInterrupts()
+#define interrupts()
+
+/* Time only moves when the harness advances it, starting from zero */
+unsigned long millis();
+unsigned long micros();
+void host_advance_us(unsigned long us);
+void delay(unsigned long ms);
+
+void randomSeed(unsigned long seed);
+long random(long howbig);
+long random(long howsmall, long howbig);
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+typedef const char __FlashStringHelper;
+
+class Stream {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual size_t write(uint8_t c) = 0;
+};
+
+/* Serial output goes to stdout, and there is never any input */
+class HostSerial : public Stream {
+ public:
+  void begin(unsigned long) {}
+  int available() { return 0; }
+  int read() { return -1; }
+  size_t write(uint8_t c) { return fwrite(&c, 1, 1, stdout); }
+
+  void print(const char *s) { fputs(s, stdout); }
+  void print(char c) { fputc(c, stdout); }
+  void print(unsigned long n, int base = DEC) {
+    printf(base == HEX ? "%lX" : "%lu", n);
+  }
+  void print(long n, int base = DEC) {
+    if (base == HEX) printf("%lX", (unsigned long)n & 0xFFFFFFFFUL);
+    else printf("%ld", n);
+  }
+  void print(unsigned int n, int base = DEC) { print((unsigned long)n, base); }
+  void print(int n, int base = DEC) { print((long)n, base); }
+  void print(unsigned char n, int base = DEC) { print((unsigned long)n, base); }
+  void print(double n) { printf("%.2f", n); }
+
+  void println() { fputc('\n', stdout); }
+  template <typename T> void println(T value) { print(value); println(); }
+  template <typename T> void println(T value, int base) {
+    print(value, base);
+    println();
+  }
+};
+extern HostSerial Serial;
+
+#endif
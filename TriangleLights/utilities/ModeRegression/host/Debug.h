@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for HMTL's Debug.h.  Debug output is compiled out so that
+ * only the rendered frames are printed.
+ ******************************************************************************/
+
+#ifndef HOST_DEBUG_H
+#define HOST_DEBUG_H
+
+#define DEBUG_NONE  0
+#define DEBUG_LOW   1
+#define DEBUG_MID   2
+#define DEBUG_HIGH  3
+#define DEBUG_TRACE 4
+
+#define DEBUG_ERR_UNINIT 1
+#define DEBUG_ERR_MALLOC 2
+
+#define DEBUG_ERR(x)
+#define DEBUG_ERR_STATE(x)
+#define debug_err_state(x)
+#define DEBUG_MEMORY(level)
+#define DEBUG_ENDLN()
+#define DEBUG_PRINT_END()
+#define DEBUG_COMMAND(level, x)
+
+#define DEBUG1_PRINT(x)
+#define DEBUG1_PRINTLN(x)
+#define DEBUG1_VALUE(x, y)
+#define DEBUG1_VALUELN(x, y)
+#define DEBUG1_HEXVAL(x, y)
+#define DEBUG1_HEXVALLN(x, y)
+#define DEBUG1_COMMAND(x)
+
+#define DEBUG2_PRINT(x)
+#define DEBUG2_PRINTLN(x)
+#define DEBUG2_VALUE(x, y)
+#define DEBUG2_VALUELN(x, y)
+#define DEBUG2_HEXVAL(x, y)
+#define DEBUG2_HEXVALLN(x, y)
+#define DEBUG2_COMMAND(x)
+
+#define DEBUG3_PRINT(x)
+#define DEBUG3_PRINTLN(x)
+#define DEBUG3_VALUE(x, y)
+#define DEBUG3_VALUELN(x, y)
+#define DEBUG3_HEXVAL(x, y)
+#define DEBUG3_HEXVALLN(x, y)
+#define DEBUG3_COMMAND(x)
+
+#define DEBUG4_PRINT(x)
+#define DEBUG4_PRINTLN(x)
+#define DEBUG4_VALUE(x, y)
+#define DEBUG4_VALUELN(x, y)
+#define DEBUG4_HEXVAL(x, y)
+#define DEBUG4_HEXVALLN(x, y)
+#define DEBUG4_COMMAND(x)
+
+#define DEBUG5_PRINT(x)
+#define DEBUG5_PRINTLN(x)
+#define DEBUG5_VALUE(x, y)
+#define DEBUG5_VALUELN(x, y)
+#define DEBUG5_HEXVAL(x, y)
+#define DEBUG5_HEXVALLN(x, y)
+#define DEBUG5_COMMAND(x)
+
+#endif
@@ -0,0 +1,12 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for the Arduino EEPROM library, which is read through EEPromUtils.h.
+ ******************************************************************************/
+
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#endif
@@ -0,0 +1,40 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for HMTL's EEPROM access, over an EEPROM in memory that
+ * starts erased so reads fail and the modes fall back to their defaults.
+ * host_eeprom_load() fills it from an image, such as one read back from a
+ * configured module, and host_eeprom_save() writes it out.
+ *
+ * Each record is framed by a start code and its length before the data and
+ * a checksum and end code after, the 4 bytes that EEPROM_SIZE() adds.  The
+ * codes and checksum below are the host's, and an image written by the HMTL
+ * library reads back only where they match the library's.
+ ******************************************************************************/
+
+#ifndef HOST_EEPROMUTILS_H
+#define HOST_EEPROMUTILS_H
+
+#include <Arduino.h>
+
+#define EEPROM_SIZE(x) ((x) + 4)
+
+int EEPROM_safe_read(int offset, uint8_t *data, int max_size);
+int EEPROM_safe_write(int offset, uint8_t *data, int size);
+
+#define HOST_EEPROM_BYTES 4096
+#define HOST_EEPROM_START 0xA5
+#define HOST_EEPROM_END   0x5A
+
+/* Load an image file, returning its length or -1 if it couldn't be read */
+int host_eeprom_load(const char *path);
+
+/* Write the image to a file, returning its length or -1 on failure */
+int host_eeprom_save(const char *path);
+
+/* Offset of the first record of a size, walking the records from the start */
+int host_eeprom_find(int size);
+
+#endif
@@ -0,0 +1,213 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for the FastLED functions used by the modes, following the
+ * library's portable C versions.
+ ******************************************************************************/
+
+#ifndef HOST_FASTLED_H
+#define HOST_FASTLED_H
+
+#include <Arduino.h>
+
+typedef uint8_t fract8;
+
+inline uint8_t scale8(uint8_t i, fract8 scale) {
+  return ((uint16_t)i * (1 + (uint16_t)scale)) >> 8;
+}
+
+inline uint8_t scale8_video(uint8_t i, fract8 scale) {
+  return (((uint16_t)i * (uint16_t)scale) >> 8) + ((i && scale) ? 1 : 0);
+}
+
+inline uint8_t qadd8(uint8_t i, uint8_t j) {
+  unsigned int t = i + j;
+  return (t > 255) ? 255 : t;
+}
+
+inline uint8_t qsub8(uint8_t i, uint8_t j) {
+  int t = i - j;
+  return (t < 0) ? 0 : t;
+}
+
+inline uint8_t lerp8by8(uint8_t a, uint8_t b, fract8 frac) {
+  if (b > a) return a + scale8(b - a, frac);
+  return a - scale8(a - b, frac);
+}
+
+inline uint8_t sin8(uint8_t theta) {
+  static const uint8_t b_m16_interleave[] = { 0, 49, 49, 41, 90, 27, 117, 10 };
+  uint8_t offset = theta;
+  if (theta & 0x40) offset = (uint8_t)255 - offset;
+  offset &= 0x3F;
+
+  uint8_t secoffset = offset & 0x0F;
+  if (theta & 0x40) secoffset++;
+
+  uint8_t section = offset >> 4;
+  uint8_t s2 = section * 2;
+  const uint8_t *p = b_m16_interleave + s2;
+  uint8_t b = *p;
+  p++;
+  uint8_t m16 = *p;
+
+  uint8_t mx = (m16 * secoffset) >> 4;
+  int8_t y = mx + b;
+  if (theta & 0x80) y = -y;
+  y += 128;
+  return y;
+}
+
+inline uint8_t cos8(uint8_t theta) { return sin8(theta + 64); }
+
+inline uint16_t sqrt16(uint16_t x) {
+  if (x <= 1) return x;
+
+  uint8_t low = 1;
+  uint8_t hi, mid;
+  if (x > 7904) {
+    hi = 255;
+  } else {
+    hi = (x >> 5) + 8;
+  }
+
+  do {
+    mid = (low + hi) >> 1;
+    if ((uint16_t)(mid * mid) > x) {
+      hi = mid - 1;
+    } else {
+      if (mid == 255) return 255;
+      low = mid + 1;
+    }
+  } while (hi >= low);
+
+  return low - 1;
+}
+
+/* The 16 bit linear congruential generator behind random8() */
+extern uint16_t rand16seed;
+
+inline uint8_t random8() {
+  rand16seed = (rand16seed * 2053) + 13849;
+  return (uint8_t)(((uint8_t)(rand16seed & 0xFF)) +
+                   ((uint8_t)(rand16seed >> 8)));
+}
+inline uint8_t random8(uint8_t lim) {
+  return (random8() * lim) >> 8;
+}
+inline uint8_t random8(uint8_t min, uint8_t lim) {
+  return random8(lim - min) + min;
+}
+inline uint16_t random16() {
+  rand16seed = (rand16seed * 2053) + 13849;
+  return rand16seed;
+}
+inline uint16_t random16(uint16_t lim) {
+  return ((uint32_t)random16() * lim) >> 16;
+}
+inline void random16_set_seed(uint16_t seed) { rand16seed = seed; }
+
+struct CRGB {
+  union {
+    struct {
+      uint8_t r;
+      uint8_t g;
+      uint8_t b;
+    };
+    uint8_t raw[3];
+  };
+
+  CRGB() {}
+  CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+  CRGB(uint32_t colorcode)
+    : r((colorcode >> 16) & 0xFF), g((colorcode >> 8) & 0xFF),
+      b(colorcode & 0xFF) {}
+
+  uint8_t &operator[](uint8_t x) { return raw[x]; }
+  const uint8_t &operator[](uint8_t x) const { return raw[x]; }
+
+  CRGB &operator=(uint32_t colorcode) {
+    r = (colorcode >> 16) & 0xFF;
+    g = (colorcode >> 8) & 0xFF;
+    b = colorcode & 0xFF;
+    return *this;
+  }
+
+  CRGB &operator+=(const CRGB &rhs) {
+    r = qadd8(r, rhs.r);
+    g = qadd8(g, rhs.g);
+    b = qadd8(b, rhs.b);
+    return *this;
+  }
+
+  CRGB &operator-=(const CRGB &rhs) {
+    r = qsub8(r, rhs.r);
+    g = qsub8(g, rhs.g);
+    b = qsub8(b, rhs.b);
+    return *this;
+  }
+
+  CRGB &nscale8(uint8_t scaledown) {
+    r = scale8(r, scaledown);
+    g = scale8(g, scaledown);
+    b = scale8(b, scaledown);
+    return *this;
+  }
+
+  CRGB &nscale8_video(uint8_t scaledown) {
+    r = scale8_video(r, scaledown);
+    g = scale8_video(g, scaledown);
+    b = scale8_video(b, scaledown);
+    return *this;
+  }
+
+  bool operator==(const CRGB &rhs) const {
+    return (r == rhs.r) && (g == rhs.g) && (b == rhs.b);
+  }
+  bool operator!=(const CRGB &rhs) const { return !(*this == rhs); }
+
+  enum HTMLColorCode {
+    Black = 0x000000,
+    White = 0xFFFFFF,
+    Red   = 0xFF0000,
+    Green = 0x008000,
+    Blue  = 0x0000FF
+  };
+};
+
+inline CRGB operator+(const CRGB &p1, const CRGB &p2) {
+  return CRGB(qadd8(p1.r, p2.r), qadd8(p1.g, p2.g), qadd8(p1.b, p2.b));
+}
+
+inline void fill_solid(CRGB *leds, int numToFill, const CRGB &color) {
+  for (int i = 0; i < numToFill; i++) leds[i] = color;
+}
+
+inline uint8_t blend8(uint8_t a, uint8_t b, uint8_t amountOfB) {
+  uint16_t partial = (a << 8) | b;
+  partial += (b * amountOfB);
+  partial -= (a * amountOfB);
+  return partial >> 8;
+}
+
+inline CRGB blend(const CRGB &p1, const CRGB &p2, fract8 amountOfP2) {
+  if (amountOfP2 == 0) return p1;
+  if (amountOfP2 == 255) return p2;
+  return CRGB(blend8(p1.r, p2.r, amountOfP2),
+              blend8(p1.g, p2.g, amountOfP2),
+              blend8(p1.b, p2.b, amountOfP2));
+}
+
+class CFastLED {
+ public:
+  void setBrightness(uint8_t scale) { brightness = scale; }
+  uint8_t getBrightness() { return brightness; }
+  void show() {}
+ private:
+  uint8_t brightness;
+};
+extern CFastLED FastLED;
+
+#endif
@@ -0,0 +1,7 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for HMTL's GeneralUtils.h, nothing from which is used on the host.
+ ******************************************************************************/
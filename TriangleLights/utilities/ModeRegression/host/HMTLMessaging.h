@@ -0,0 +1,112 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for the HMTL message formats used by the modes.
+ ******************************************************************************/
+
+#ifndef HOST_HMTLMESSAGING_H
+#define HOST_HMTLMESSAGING_H
+
+#include <Arduino.h>
+
+#include "HMTLTypes.h"
+#include "Socket.h"
+
+#define HMTL_MSG_START 0xFC
+#define HMTL_READY     "HMTL Module Ready"
+
+#define MSG_TYPE_OUTPUT 1
+#define MSG_TYPE_POLL   2
+#define MSG_TYPE_SENSOR 4
+
+#define HMTL_SENSOR_SOUND 1
+#define HMTL_SENSOR_LIGHT 2
+#define HMTL_SENSOR_POT   3
+
+#define MAX_PROGRAM_VAL 12
+
+typedef struct __attribute__((packed)) {
+  uint8_t startcode;
+  uint8_t crc;
+  uint8_t version;
+  uint8_t length;
+  uint8_t type;
+  uint8_t flags;
+  uint16_t address;
+} msg_hdr_t;
+
+typedef struct __attribute__((packed)) {
+  output_hdr_t hdr;
+  uint8_t type;
+  uint8_t values[MAX_PROGRAM_VAL];
+} msg_program_t;
+
+typedef struct __attribute__((packed)) {
+  uint8_t sensor_type;
+  uint8_t data_len;
+  uint8_t data;
+} msg_sensor_data_t;
+
+typedef struct __attribute__((packed)) {
+  output_hdr_t hdr;
+  uint8_t data[48];
+} msg_max_t;
+
+msg_hdr_t *hmtl_socket_getmsg(Socket *socket, unsigned int *msglen,
+                              socket_addr_t address = SOCKET_ADDR_ANY);
+
+/*
+ * Queue a message to be received from the next socket read, the message's
+ * length field is its full length in bytes.  A sensor message's readings
+ * follow its header as msg_sensor_data_t records.  host_queue_data() queues
+ * raw bytes, for the replies that aren't HMTL messages.
+ */
+#define HOST_MSG_QUEUE 4
+#define HOST_MSG_SIZE  64
+boolean host_queue_msg(const msg_hdr_t *msg);
+boolean host_queue_data(const byte *data, byte length);
+
+/*
+ * The levels of a made up sound unit at time now, HOST_SOUND_BANDS levels
+ * that change on every report and a beat in the low bands every
+ * HOST_SOUND_BEAT_MS.  host_sound_msg() fills buffer with them as a sensor
+ * message, followed by a knob reading.
+ */
+#define HOST_SOUND_BANDS     8
+#define HOST_SOUND_REPORT_MS 50
+#define HOST_SOUND_BEAT_MS   500
+void host_sound_levels(uint16_t *levels, unsigned long now);
+void host_sound_msg(byte *buffer, unsigned long now);
+msg_sensor_data_t *hmtl_next_sensor(msg_hdr_t *msg,
+                                    msg_sensor_data_t *sensor);
+void hmtl_send_sensor_request(Socket *socket, byte *buff, byte buff_len,
+                              socket_addr_t address);
+
+/* Formatting of the messages sent to other modules, returning the length */
+void hmtl_msg_fmt(msg_hdr_t *msg_hdr, socket_addr_t address, uint8_t length,
+                  uint8_t type, uint8_t flags);
+uint16_t hmtl_value_fmt(byte *buffer, uint16_t buffsize, uint16_t address,
+                        uint8_t output, int value);
+uint16_t hmtl_blink_fmt(byte *buffer, uint16_t buffsize, uint16_t address,
+                        uint8_t output, uint16_t on_period, uint32_t on_color,
+                        uint16_t off_period, uint32_t off_color);
+uint16_t hmtl_timed_change_fmt(byte *buffer, uint16_t buffsize,
+                               uint16_t address, uint8_t output,
+                               uint32_t change_period, uint32_t start_color,
+                               uint32_t stop_color);
+
+void hmtl_send_value(Socket *socket, byte *buff, byte buff_len,
+                     uint16_t address, uint8_t output, int value);
+void hmtl_send_blink(Socket *socket, byte *buff, byte buff_len,
+                     uint16_t address, uint8_t output,
+                     uint16_t on_period, uint32_t on_color,
+                     uint16_t off_period, uint32_t off_color);
+void hmtl_send_timed_change(Socket *socket, byte *buff, byte buff_len,
+                            uint16_t address, uint8_t output,
+                            uint32_t change_period, uint32_t start_color,
+                            uint32_t stop_color);
+void hmtl_update_output(output_hdr_t *output, void *object);
+
+#endif
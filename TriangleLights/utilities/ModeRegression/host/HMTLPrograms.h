@@ -0,0 +1,26 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for HMTL's standard programs, which the regression doesn't
+ * render.
+ ******************************************************************************/
+
+#ifndef HOST_HMTLPROGRAMS_H
+#define HOST_HMTLPROGRAMS_H
+
+#include "ProgramManager.h"
+
+#define HOST_PROGRAM(name)                                              \
+  boolean name(output_hdr_t *output, void *object,                     \
+               program_tracker_t *tracker);                             \
+  boolean name##_init(msg_program_t *msg, program_tracker_t *tracker,  \
+                      output_hdr_t *output);
+
+HOST_PROGRAM(program_blink)
+HOST_PROGRAM(program_timed_change)
+HOST_PROGRAM(program_fade)
+HOST_PROGRAM(program_sparkle)
+
+#endif
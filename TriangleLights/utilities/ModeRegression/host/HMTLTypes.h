@@ -0,0 +1,41 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for the HMTL configuration types used by the modes.
+ ******************************************************************************/
+
+#ifndef HOST_HMTLTYPES_H
+#define HOST_HMTLTYPES_H
+
+#include <Arduino.h>
+
+#define HMTL_OUTPUT_NONE    0
+#define HMTL_OUTPUT_VALUE   1
+#define HMTL_OUTPUT_RGB     2
+#define HMTL_OUTPUT_PROGRAM 3
+#define HMTL_OUTPUT_PIXELS  4
+
+#define HMTL_ALL_OUTPUTS    0xFF
+#define HMTL_MAX_OUTPUTS    8
+
+typedef struct {
+  uint8_t type;
+  uint8_t output;
+} output_hdr_t;
+
+typedef struct {
+  uint8_t protocol_version;
+  uint8_t hardware_version;
+  uint16_t address;
+  uint8_t num_outputs;
+  uint8_t flags;
+} config_hdr_t;
+
+typedef struct {
+  output_hdr_t hdr;
+  uint8_t data[16];
+} config_max_t;
+
+#endif
@@ -0,0 +1,486 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host implementations of the Arduino, FastLED and HMTL functions used by the
+ * modes.
+ ******************************************************************************/
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+#include "PixelUtil.h"
+#include "EEPromUtils.h"
+#include "Geometry.h"
+#include "HMTLMessaging.h"
+#include "HMTLPrograms.h"
+#include "MessageHandler.h"
+#include "ProgramManager.h"
+#include "RS485Utils.h"
+
+HostSerial Serial;
+CFastLED FastLED;
+uint16_t rand16seed = 1337; // FastLED's initial seed
+
+/***** Arduino ****************************************************************/
+
+/* The clock is stepped by the harness so that renders don't depend on speed */
+static unsigned long host_us = 0;
+
+void host_advance_us(unsigned long us) { host_us += us; }
+
+unsigned long micros() { return host_us; }
+unsigned long millis() { return host_us / 1000; }
+void delay(unsigned long ms) { host_advance_us(ms * 1000); }
+
+/* avr-libc's random(), a Park-Miller generator, so seeds match the module */
+static uint32_t random_next = 1;
+
+static int32_t avr_random() {
+  int32_t x = random_next;
+  if (x == 0) x = 123459876L;
+  int32_t hi = x / 127773L;
+  int32_t lo = x % 127773L;
+  x = 16807L * lo - 2836L * hi;
+  if (x < 0) x += 0x7fffffffL;
+  random_next = x;
+  return x % 0x80000000UL;
+}
+
+void randomSeed(unsigned long seed) {
+  if (seed != 0) random_next = (uint32_t)seed;
+}
+
+long random(long howbig) {
+  if (howbig == 0) return 0;
+  return avr_random() % (int32_t)howbig;
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) return howsmall;
+  return random(howbig - howsmall) + howsmall;
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int digitalRead(uint8_t) { return LOW; }
+int analogRead(uint8_t) { return 0; }
+
+/***** EEPROM *****************************************************************/
+
+static byte host_eeprom[HOST_EEPROM_BYTES];
+static boolean host_eeprom_erased = false;
+
+static void host_eeprom_erase() {
+  if (!host_eeprom_erased) {
+    memset(host_eeprom, 0xFF, sizeof (host_eeprom));
+    host_eeprom_erased = true;
+  }
+}
+
+static byte host_eeprom_checksum(const byte *data, int size) {
+  byte sum = 0;
+  for (int i = 0; i < size; i++) sum += data[i];
+  return sum;
+}
+
+/* Length of the record at the offset, or -1 if there isn't a valid one */
+static int host_eeprom_record(int offset) {
+  host_eeprom_erase();
+  if ((offset < 0) || (offset + EEPROM_SIZE(0) > HOST_EEPROM_BYTES)) return -1;
+  if (host_eeprom[offset] != HOST_EEPROM_START) return -1;
+
+  int size = host_eeprom[offset + 1];
+  if (offset + EEPROM_SIZE(size) > HOST_EEPROM_BYTES) return -1;
+  const byte *data = &host_eeprom[offset + 2];
+  if ((data[size] != host_eeprom_checksum(data, size)) ||
+      (data[size + 1] != HOST_EEPROM_END)) {
+    return -1;
+  }
+  return size;
+}
+
+int EEPROM_safe_read(int offset, uint8_t *data, int max_size) {
+  int size = host_eeprom_record(offset);
+  if ((size < 0) || (size > max_size)) return -1;
+
+  memcpy(data, &host_eeprom[offset + 2], size);
+  return offset + EEPROM_SIZE(size);
+}
+
+int EEPROM_safe_write(int offset, uint8_t *data, int size) {
+  host_eeprom_erase();
+  if ((offset < 0) || (size > 255) ||
+      (offset + EEPROM_SIZE(size) > HOST_EEPROM_BYTES)) {
+    return -1;
+  }
+
+  host_eeprom[offset] = HOST_EEPROM_START;
+  host_eeprom[offset + 1] = size;
+  memcpy(&host_eeprom[offset + 2], data, size);
+  host_eeprom[offset + 2 + size] = host_eeprom_checksum(data, size);
+  host_eeprom[offset + 3 + size] = HOST_EEPROM_END;
+  return offset + EEPROM_SIZE(size);
+}
+
+int host_eeprom_load(const char *path) {
+  host_eeprom_erase();
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) return -1;
+  int length = fread(host_eeprom, 1, sizeof (host_eeprom), file);
+  fclose(file);
+  return length;
+}
+
+int host_eeprom_save(const char *path) {
+  host_eeprom_erase();
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) return -1;
+  int length = fwrite(host_eeprom, 1, sizeof (host_eeprom), file);
+  fclose(file);
+  return (length == sizeof (host_eeprom)) ? length : -1;
+}
+
+int host_eeprom_find(int size) {
+  int offset = 0;
+  int found;
+  while ((found = host_eeprom_record(offset)) >= 0) {
+    if (found == size) return offset;
+    offset += EEPROM_SIZE(found);
+  }
+  return -1;
+}
+
+/***** HMTL messages **********************************************************/
+
+static byte host_msgs[HOST_MSG_QUEUE][HOST_MSG_SIZE];
+static byte host_msg_lengths[HOST_MSG_QUEUE];
+static byte host_msg_head = 0;
+static byte host_msg_count = 0;
+
+/* The last message read, which stays valid until the next read */
+static byte host_msg_read[HOST_MSG_SIZE];
+
+boolean host_queue_data(const byte *data, byte length) {
+  if ((host_msg_count == HOST_MSG_QUEUE) || (length > HOST_MSG_SIZE)) {
+    return false;
+  }
+  byte slot = (host_msg_head + host_msg_count) % HOST_MSG_QUEUE;
+  memcpy(host_msgs[slot], data, length);
+  host_msg_lengths[slot] = length;
+  host_msg_count++;
+  return true;
+}
+
+boolean host_queue_msg(const msg_hdr_t *msg) {
+  return host_queue_data((const byte *)msg, msg->length);
+}
+
+msg_hdr_t *hmtl_socket_getmsg(Socket *, unsigned int *msglen,
+                              socket_addr_t) {
+  if (host_msg_count == 0) return NULL;
+
+  memcpy(host_msg_read, host_msgs[host_msg_head], HOST_MSG_SIZE);
+  *msglen = host_msg_lengths[host_msg_head];
+  host_msg_head = (host_msg_head + 1) % HOST_MSG_QUEUE;
+  host_msg_count--;
+
+  return (msg_hdr_t *)host_msg_read;
+}
+
+/* Step through the readings that follow a sensor message's header */
+msg_sensor_data_t *hmtl_next_sensor(msg_hdr_t *msg,
+                                    msg_sensor_data_t *sensor) {
+  byte *end = (byte *)msg + msg->length;
+  byte *next;
+  if (sensor == NULL) {
+    next = (byte *)(msg + 1);
+  } else {
+    next = &sensor->data + sensor->data_len;
+  }
+
+  if (next + offsetof(msg_sensor_data_t, data) > end) return NULL;
+  sensor = (msg_sensor_data_t *)next;
+  if (&sensor->data + sensor->data_len > end) return NULL;
+  return sensor;
+}
+
+void (*host_send_hook)(socket_addr_t address, const byte *data,
+                       byte len) = NULL;
+
+const byte *RS485Socket::getMsg(socket_addr_t address, unsigned int *len) {
+  return (const byte *)hmtl_socket_getmsg(this, len, address);
+}
+
+void RS485Socket::sendMsgTo(socket_addr_t address, const byte *data,
+                            const byte len) {
+  if (host_send_hook != NULL) host_send_hook(address, data, len);
+}
+
+void host_sound_levels(uint16_t *levels, unsigned long now) {
+  unsigned long report = now / HOST_SOUND_REPORT_MS;
+  for (byte band = 0; band < HOST_SOUND_BANDS; band++) {
+    levels[band] = (report * (band * 5 + 3) + band) % 12;
+  }
+  if (now % HOST_SOUND_BEAT_MS < HOST_SOUND_REPORT_MS) {
+    levels[0] += 40;
+    levels[1] += 30;
+  }
+}
+
+void host_sound_msg(byte *buffer, unsigned long now) {
+  msg_hdr_t *msg = (msg_hdr_t *)buffer;
+  memset(buffer, 0, HOST_MSG_SIZE);
+  msg->startcode = HMTL_MSG_START;
+  msg->type = MSG_TYPE_SENSOR;
+  msg->address = SOCKET_ADDR_ANY;
+
+  msg_sensor_data_t *sensor = (msg_sensor_data_t *)(msg + 1);
+  sensor->sensor_type = HMTL_SENSOR_SOUND;
+  sensor->data_len = HOST_SOUND_BANDS * sizeof (uint16_t);
+  host_sound_levels((uint16_t *)&sensor->data, now);
+
+  sensor = (msg_sensor_data_t *)(&sensor->data + sensor->data_len);
+  sensor->sensor_type = HMTL_SENSOR_POT;
+  sensor->data_len = sizeof (uint16_t);
+  *(uint16_t *)&sensor->data = ((now / HOST_SOUND_REPORT_MS) * 16) % 1024;
+
+  msg->length = (&sensor->data + sensor->data_len) - buffer;
+}
+
+void hmtl_msg_fmt(msg_hdr_t *msg_hdr, socket_addr_t address, uint8_t length,
+                  uint8_t type, uint8_t flags) {
+  msg_hdr->startcode = HMTL_MSG_START;
+  msg_hdr->crc = 0;
+  msg_hdr->version = 0;
+  msg_hdr->length = length;
+  msg_hdr->type = type;
+  msg_hdr->flags = flags;
+  msg_hdr->address = address;
+}
+
+/* An output message is the output's header followed by its values */
+static uint16_t host_output_fmt(byte *buffer, uint16_t buffsize,
+                                uint16_t address, uint8_t output,
+                                uint8_t type, const void *values,
+                                uint8_t size) {
+  uint16_t length = sizeof (msg_hdr_t) + sizeof (output_hdr_t) + size;
+  if (length > buffsize) return 0;
+
+  msg_hdr_t *msg_hdr = (msg_hdr_t *)buffer;
+  hmtl_msg_fmt(msg_hdr, address, length, MSG_TYPE_OUTPUT, 0);
+  output_hdr_t *hdr = (output_hdr_t *)(msg_hdr + 1);
+  hdr->type = type;
+  hdr->output = output;
+  memcpy(hdr + 1, values, size);
+  return length;
+}
+
+uint16_t hmtl_value_fmt(byte *buffer, uint16_t buffsize, uint16_t address,
+                        uint8_t output, int value) {
+  uint16_t value16 = value;
+  return host_output_fmt(buffer, buffsize, address, output,
+                         HMTL_OUTPUT_VALUE, &value16, sizeof (value16));
+}
+
+uint16_t hmtl_blink_fmt(byte *buffer, uint16_t buffsize, uint16_t address,
+                        uint8_t output, uint16_t on_period, uint32_t on_color,
+                        uint16_t off_period, uint32_t off_color) {
+  struct __attribute__((packed)) {
+    uint8_t type;
+    uint16_t on_period;
+    uint32_t on_color;
+    uint16_t off_period;
+    uint32_t off_color;
+  } values = { HMTL_PROGRAM_BLINK, on_period, on_color, off_period, off_color };
+  return host_output_fmt(buffer, buffsize, address, output,
+                         HMTL_OUTPUT_PROGRAM, &values, sizeof (values));
+}
+
+uint16_t hmtl_timed_change_fmt(byte *buffer, uint16_t buffsize,
+                               uint16_t address, uint8_t output,
+                               uint32_t change_period, uint32_t start_color,
+                               uint32_t stop_color) {
+  struct __attribute__((packed)) {
+    uint8_t type;
+    uint32_t change_period;
+    uint32_t start_color;
+    uint32_t stop_color;
+  } values = { HMTL_PROGRAM_TIMED_CHANGE, change_period, start_color,
+               stop_color };
+  return host_output_fmt(buffer, buffsize, address, output,
+                         HMTL_OUTPUT_PROGRAM, &values, sizeof (values));
+}
+
+void hmtl_send_value(Socket *socket, byte *buff, byte buff_len,
+                     uint16_t address, uint8_t output, int value) {
+  uint16_t len = hmtl_value_fmt(buff, buff_len, address, output, value);
+  if (len) socket->sendMsgTo(address, buff, len);
+}
+
+void hmtl_send_blink(Socket *socket, byte *buff, byte buff_len,
+                     uint16_t address, uint8_t output,
+                     uint16_t on_period, uint32_t on_color,
+                     uint16_t off_period, uint32_t off_color) {
+  uint16_t len = hmtl_blink_fmt(buff, buff_len, address, output, on_period,
+                                on_color, off_period, off_color);
+  if (len) socket->sendMsgTo(address, buff, len);
+}
+
+void hmtl_send_timed_change(Socket *socket, byte *buff, byte buff_len,
+                            uint16_t address, uint8_t output,
+                            uint32_t change_period, uint32_t start_color,
+                            uint32_t stop_color) {
+  uint16_t len = hmtl_timed_change_fmt(buff, buff_len, address, output,
+                                       change_period, start_color,
+                                       stop_color);
+  if (len) socket->sendMsgTo(address, buff, len);
+}
+
+void hmtl_send_sensor_request(Socket *socket, byte *buff, byte buff_len,
+                              socket_addr_t address) {
+  if (buff_len < sizeof (msg_hdr_t)) return;
+  hmtl_msg_fmt((msg_hdr_t *)buff, address, sizeof (msg_hdr_t),
+               MSG_TYPE_SENSOR, 0);
+  socket->sendMsgTo(address, buff, sizeof (msg_hdr_t));
+}
+
+void hmtl_update_output(output_hdr_t *, void *) {}
+
+/* The standard programs never produce a frame on the host */
+#define HOST_PROGRAM_BODY(name)                                           \
+  boolean name(output_hdr_t *, void *, program_tracker_t *) {             \
+    return false;                                                         \
+  }                                                                       \
+  boolean name##_init(msg_program_t *, program_tracker_t *,              \
+                      output_hdr_t *) {                                   \
+    return true;                                                          \
+  }
+
+HOST_PROGRAM_BODY(program_blink)
+HOST_PROGRAM_BODY(program_timed_change)
+HOST_PROGRAM_BODY(program_fade)
+HOST_PROGRAM_BODY(program_sparkle)
+
+/***** Program manager ********************************************************/
+
+ProgramManager::ProgramManager(output_hdr_t **_outputs,
+                               program_tracker_t **_trackers,
+                               void **_objects, byte _num_outputs,
+                               hmtl_program_t *_functions,
+                               byte _num_functions) {
+  outputs = _outputs;
+  trackers = _trackers;
+  objects = _objects;
+  num_outputs = _num_outputs;
+  functions = _functions;
+  num_functions = _num_functions;
+
+  for (byte i = 0; i < num_outputs; i++) {
+    trackers[i] = NULL;
+  }
+}
+
+byte ProgramManager::lookup_function(byte type) {
+  for (byte i = 0; i < num_functions; i++) {
+    if (functions[i].type == type) return i;
+  }
+  return NO_PROGRAM;
+}
+
+void ProgramManager::free_tracker(byte index) {
+  trackers[index] = NULL;
+}
+
+/*
+ * Start the program on each output the message names, the output is freed
+ * if the program's setup declines it.
+ */
+boolean ProgramManager::handle_msg(msg_program_t *msg) {
+  byte function = lookup_function(msg->type);
+  if ((msg->type != HMTL_PROGRAM_NONE) && (function == NO_PROGRAM)) {
+    return false;
+  }
+
+  for (byte i = 0; i < num_outputs; i++) {
+    if ((msg->hdr.output != HMTL_ALL_OUTPUTS) && (msg->hdr.output != i)) {
+      continue;
+    }
+
+    free_tracker(i);
+    if ((msg->type == HMTL_PROGRAM_NONE) || (outputs[i] == NULL)) continue;
+
+    program_tracker_t *tracker = &tracker_storage[i];
+    tracker->program = &functions[function];
+    tracker->state = NULL;
+    tracker->flags = 0;
+    if (functions[function].setup(msg, tracker, outputs[i])) {
+      trackers[i] = tracker;
+    }
+  }
+
+  return true;
+}
+
+/* Run the program on every output, returns true if any of them changed */
+boolean ProgramManager::run() {
+  boolean changed = false;
+  for (byte i = 0; i < num_outputs; i++) {
+    program_tracker_t *tracker = trackers[i];
+    if ((tracker == NULL) || (tracker->program->program == NULL)) continue;
+
+    if (tracker->program->program(outputs[i], objects[i], tracker)) {
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+void (*host_program_hook)(msg_program_t *msg) = NULL;
+
+/* Handle any messages that have been received */
+boolean MessageHandler::check(config_hdr_t *config) {
+  boolean handled = false;
+  unsigned int msglen;
+  msg_hdr_t *msg;
+  while ((msg = hmtl_socket_getmsg(NULL, &msglen, address))) {
+    if (process_msg(msg, NULL, NULL, config)) handled = true;
+  }
+  return handled;
+}
+
+boolean MessageHandler::process_msg(msg_hdr_t *msg_hdr, Socket *, Socket *,
+                                    config_hdr_t *) {
+  if (msg_hdr->type != MSG_TYPE_OUTPUT) return false;
+
+  msg_program_t *msg = (msg_program_t *)(msg_hdr + 1);
+  if (msg->hdr.type != HMTL_OUTPUT_PROGRAM) return false;
+
+  if (host_program_hook != NULL) host_program_hook(msg);
+  return manager->handle_msg(msg);
+}
+
+/***** Geometry ***************************************************************/
+
+/*
+ * Geometry's own virtual functions are never called, and have no definitions
+ * in the library.  The module's build drops them, here they are defined so
+ * that the class's vtable is emitted.
+ */
+byte Geometry::numEdges() { return 0; }
+byte Geometry::numVertices() { return 0; }
+byte Geometry::numLeds() { return 0; }
+int Geometry::toBytes(byte *, int) { return 0; }
+void Geometry::fromBytes(byte *, int, Geometry *, geo_id_t) {}
+void Geometry::setColor(byte, byte, byte) {}
+void Geometry::setColor(uint32_t) {}
+void Geometry::setColor(byte, byte, byte, byte) {}
+void Geometry::setColor(byte, uint32_t) {}
+uint32_t Geometry::getColor() { return 0; }
+uint32_t Geometry::getColor(byte) { return 0; }
+void Geometry::print() {}
@@ -0,0 +1,16 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for the MPR121 touch sensor, which the modes only name.
+ ******************************************************************************/
+
+#ifndef HOST_MPR121_H
+#define HOST_MPR121_H
+
+#include <Arduino.h>
+
+class MPR121 {};
+
+#endif
@@ -0,0 +1,43 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for HMTL's MessageHandler, passing program messages to the
+ * program manager.  Messages queued by the harness with host_queue_msg() are
+ * received by check() as they would be from the module's sockets.
+ ******************************************************************************/
+
+#ifndef HOST_MESSAGEHANDLER_H
+#define HOST_MESSAGEHANDLER_H
+
+#include <Arduino.h>
+
+#include "HMTLMessaging.h"
+#include "ProgramManager.h"
+
+class MessageHandler {
+ public:
+  MessageHandler() : manager(NULL) {}
+  MessageHandler(socket_addr_t address, ProgramManager *manager,
+                 Socket **, byte)
+    : address(address), manager(manager) {}
+
+  boolean check(config_hdr_t *config);
+  boolean process_msg(msg_hdr_t *msg_hdr, Socket *src, Socket *serial,
+                      config_hdr_t *config);
+  void check_and_forward(msg_hdr_t *, Socket *) {}
+  void serial_ready() {}
+
+ private:
+  socket_addr_t address;
+  ProgramManager *manager;
+};
+
+/*
+ * Called with each program message before it is handled, so that the harness
+ * can vary the message, ie to change a mode's colors.
+ */
+extern void (*host_program_hook)(msg_program_t *msg);
+
+#endif
@@ -0,0 +1,123 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for HMTL's PixelUtil, a strand of pixels held in memory.
+ ******************************************************************************/
+
+#ifndef HOST_PIXELUTIL_H
+#define HOST_PIXELUTIL_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+inline uint32_t pixel_color(byte r, byte g, byte b) {
+  return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+}
+inline byte pixel_red(uint32_t color) { return (color >> 16) & 0xFF; }
+inline byte pixel_green(uint32_t color) { return (color >> 8) & 0xFF; }
+inline byte pixel_blue(uint32_t color) { return color & 0xFF; }
+
+/* Green to red to blue and back to green */
+inline uint32_t pixel_wheel(byte pos) {
+  if (pos < 85) return pixel_color(pos * 3, 255 - pos * 3, 0);
+  if (pos < 170) {
+    pos -= 85;
+    return pixel_color(255 - pos * 3, 0, pos * 3);
+  }
+  pos -= 170;
+  return pixel_color(0, pos * 3, 255 - pos * 3);
+}
+
+/* The primary and secondary colors in turn */
+inline uint32_t pixel_primary(byte index) {
+  switch (index % 6) {
+    case 0: return pixel_color(255, 0, 0);
+    case 1: return pixel_color(0, 255, 0);
+    case 2: return pixel_color(0, 0, 255);
+    case 3: return pixel_color(255, 255, 0);
+    case 4: return pixel_color(0, 255, 255);
+    default: return pixel_color(255, 0, 255);
+  }
+}
+
+/* The secondary colors in turn */
+inline uint32_t pixel_secondary(byte index) {
+  switch (index % 3) {
+    case 0: return pixel_color(255, 255, 0);
+    case 1: return pixel_color(0, 255, 255);
+    default: return pixel_color(255, 0, 255);
+  }
+}
+
+/* Move each channel of a color a percentage of the way towards another */
+inline uint32_t fadeTowards(uint32_t current, uint32_t goal, byte percent) {
+  byte rgb[3];
+  for (byte i = 0; i < 3; i++) {
+    int from = (current >> (16 - 8 * i)) & 0xFF;
+    int to = (goal >> (16 - 8 * i)) & 0xFF;
+    rgb[i] = from + (to - from) * percent / 100;
+  }
+  return pixel_color(rgb[0], rgb[1], rgb[2]);
+}
+
+/* Black through red and yellow to white, as FastLED's HeatColor() */
+inline uint32_t pixel_heat(byte temperature) {
+  byte t192 = scale8_video(temperature, 191);
+  byte heatramp = (t192 & 0x3F) << 2;
+  if (t192 & 0x80) return pixel_color(255, 255, heatramp);
+  if (t192 & 0x40) return pixel_color(255, heatramp, 0);
+  return pixel_color(heatramp, 0, 0);
+}
+
+class PRGB {
+ public:
+  uint16_t pixel;
+  byte red;
+  byte green;
+  byte blue;
+
+  void setColor(byte r, byte g, byte b) { red = r; green = g; blue = b; }
+  void setColor(uint32_t c) {
+    setColor(pixel_red(c), pixel_green(c), pixel_blue(c));
+  }
+  uint32_t color() { return pixel_color(red, green, blue); }
+  CRGB getCRGB() { return CRGB(red, green, blue); }
+};
+
+#define HOST_MAX_PIXELS 512
+
+class PixelUtil {
+ public:
+  PixelUtil() : num_pixels(0) { memset(colors, 0, sizeof (colors)); }
+  PixelUtil(uint16_t count) : num_pixels(count) {
+    memset(colors, 0, sizeof (colors));
+  }
+
+  uint16_t numPixels() { return num_pixels; }
+  void setPixelRGB(uint16_t led, byte r, byte g, byte b) {
+    if (led < num_pixels) colors[led] = pixel_color(r, g, b);
+  }
+  void setPixelRGB(uint16_t led, uint32_t color) {
+    if (led < num_pixels) colors[led] = color;
+  }
+  void setPixelRGB(PRGB *rgb) {
+    setPixelRGB(rgb->pixel, rgb->red, rgb->green, rgb->blue);
+  }
+  uint32_t getColor(uint16_t led) {
+    return (led < num_pixels) ? colors[led] : 0;
+  }
+  void setAllRGB(byte r, byte g, byte b) {
+    for (uint16_t led = 0; led < num_pixels; led++) {
+      colors[led] = pixel_color(r, g, b);
+    }
+  }
+  void update() {}
+
+ private:
+  uint16_t num_pixels;
+  uint32_t colors[HOST_MAX_PIXELS];
+};
+
+#endif
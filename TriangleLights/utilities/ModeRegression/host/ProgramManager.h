@@ -0,0 +1,73 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for HMTL's ProgramManager.  Programs are started by program
+ * messages and run on the outputs named by them, as on the module.
+ ******************************************************************************/
+
+#ifndef HOST_PROGRAMMANAGER_H
+#define HOST_PROGRAMMANAGER_H
+
+#include <Arduino.h>
+
+#include "HMTLTypes.h"
+#include "HMTLMessaging.h"
+
+#define HMTL_PROGRAM_NONE         0x0
+#define HMTL_PROGRAM_BLINK        0x1
+#define HMTL_PROGRAM_TIMED_CHANGE 0x2
+#define HMTL_PROGRAM_LEVEL_VALUE  0x3
+#define HMTL_PROGRAM_SOUND_VALUE  0x4
+#define HMTL_PROGRAM_FADE         0x5
+#define HMTL_PROGRAM_SPARKLE      0x6
+
+typedef struct program_tracker program_tracker_t;
+
+typedef boolean (*hmtl_program_function_t)(output_hdr_t *outputs,
+                                           void *object,
+                                           program_tracker_t *tracker);
+typedef boolean (*hmtl_program_setup_t)(msg_program_t *msg,
+                                        program_tracker_t *tracker,
+                                        output_hdr_t *output);
+
+typedef struct {
+  byte type;
+  hmtl_program_function_t program;
+  hmtl_program_setup_t setup;
+} hmtl_program_t;
+
+struct program_tracker {
+  hmtl_program_t *program;
+  void *state;
+  boolean flags;
+};
+
+class ProgramManager {
+ public:
+  static const byte NO_PROGRAM = (byte)-1;
+
+  ProgramManager() {}
+  ProgramManager(output_hdr_t **outputs, program_tracker_t **trackers,
+                 void **objects, byte num_outputs,
+                 hmtl_program_t *functions, byte num_functions);
+
+  boolean handle_msg(msg_program_t *msg);
+  boolean run();
+
+  output_hdr_t **outputs;
+  program_tracker_t **trackers;
+  void **objects;
+  byte num_outputs;
+
+  hmtl_program_t *functions;
+  byte num_functions;
+
+ private:
+  program_tracker_t tracker_storage[HMTL_MAX_OUTPUTS];
+  byte lookup_function(byte type);
+  void free_tracker(byte index);
+};
+
+#endif
@@ -0,0 +1,41 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for HMTL's RS485 socket.  Messages queued by the harness with
+ * host_queue_msg() are received from it, and messages sent on it are passed
+ * to host_send_hook so that the harness can reply as another module would.
+ ******************************************************************************/
+
+#ifndef HOST_RS485UTILS_H
+#define HOST_RS485UTILS_H
+
+#include "Socket.h"
+
+#define RS485_ADDR_ANY SOCKET_ADDR_ANY
+#define RS485_HDR_SIZE 8
+#define RS485_BUFFER_TOTAL(x) ((x) + RS485_HDR_SIZE)
+
+extern void (*host_send_hook)(socket_addr_t address, const byte *data,
+                              byte len);
+
+class RS485Socket : public Socket {
+ public:
+  boolean initialized() { return true; }
+
+  byte *initBuffer(byte *data) {
+    send_buffer = data + RS485_HDR_SIZE;
+    return send_buffer;
+  }
+  byte *initBuffer(byte *data, uint16_t data_size) {
+    send_buffer = data;
+    send_data_size = data_size;
+    return data;
+  }
+
+  const byte *getMsg(socket_addr_t address, unsigned int *len);
+  void sendMsgTo(socket_addr_t address, const byte *data, const byte len);
+};
+
+#endif
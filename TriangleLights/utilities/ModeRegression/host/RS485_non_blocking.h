@@ -0,0 +1,12 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for the RS485 library, which RS485Utils.h stands in for.
+ ******************************************************************************/
+
+#ifndef HOST_RS485_NON_BLOCKING_H
+#define HOST_RS485_NON_BLOCKING_H
+
+#endif
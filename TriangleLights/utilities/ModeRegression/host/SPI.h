@@ -0,0 +1,12 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for the Arduino SPI library, which the modes don't use.
+ ******************************************************************************/
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#endif
@@ -0,0 +1,31 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for HMTL's sockets, which never receive anything.
+ ******************************************************************************/
+
+#ifndef HOST_SOCKET_H
+#define HOST_SOCKET_H
+
+#include <Arduino.h>
+
+typedef uint16_t socket_addr_t;
+#define SOCKET_ADDR_ANY     ((socket_addr_t)-1)
+#define SOCKET_ADDR_INVALID ((socket_addr_t)-2)
+
+class Socket {
+ public:
+  Socket() : send_buffer(NULL), send_data_size(0) {}
+  virtual ~Socket() {}
+
+  virtual void setup() {}
+  virtual const byte *getMsg(socket_addr_t, unsigned int *) { return NULL; }
+  virtual void sendMsgTo(socket_addr_t, const byte *, const byte) {}
+
+  byte *send_buffer;
+  byte send_data_size;
+};
+
+#endif
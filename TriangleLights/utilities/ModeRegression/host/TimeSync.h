@@ -0,0 +1,21 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for HMTL's TimeSync, which follows the host millis().
+ ******************************************************************************/
+
+#ifndef HOST_TIMESYNC_H
+#define HOST_TIMESYNC_H
+
+#include <Arduino.h>
+
+class TimeSync {
+ public:
+  unsigned long ms() { return millis(); }
+};
+
+extern TimeSync time;
+
+#endif
@@ -0,0 +1,12 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host stand in for the Arduino Wire library, which the modes don't use.
+ ******************************************************************************/
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#endif
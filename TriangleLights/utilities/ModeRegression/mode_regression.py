@@ -0,0 +1,337 @@
+#!/usr/bin/env python
+################################################################################
+# Author: Adam Phelps
+# License: Create Commons Attribution-Non-Commercial
+# Copyright: 2016
+#
+# Regression check for the light modes.  Three host runners are built along
+# with the code they render, and the frame hashes of every mode are compared
+# against the saved runs in golden/<run>/<MODE>.txt:
+#
+#   icosohedron, cylinder - ModeRegression.cpp, the triangle module's modes
+#   legacy                - LegacyRegression.cpp, the TriangleLights sketch's
+#                           patterns, on the icosohedron only as most of them
+#                           follow the cylinder's missing edges
+#   cube                  - CubeRegression.cpp, the cube's square modes
+#
+# The host tests in TESTS are then built and run against the current
+# libraries, and any that exits non-zero is a failure.
+#
+# The sources to build are found by following the #includes from each runner
+# to the matching .cpp in the libraries and sketches, so the same runners can
+# build an earlier tree with --tree <revision>.  The few fixes an earlier tree
+# needs to build and run on the host are in HOST_FIXES.
+#
+# Run with --regenerate to rewrite the saved runs after an intended change to
+# a mode's output, and note the change in golden/CHANGES.  The host hashes do
+# not match a module's 'g' output, as int sizes and struct layout differ, so
+# only compare host runs to host runs.
+################################################################################
+
+import argparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tarfile
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+HOST = os.path.join(HERE, 'host')
+REPO = os.path.abspath(os.path.join(HERE, '..', '..', '..'))
+
+LIBRARIES = ['Libraries/ObjectLibrary', 'Libraries/TriangleLibrary',
+             'Libraries/CubeLibrary']
+MODULE = 'TriangleLights/TriangleLightsModule'
+LEGACY = 'TriangleLights/TriangleLights'
+CUBE = 'CubeLights/CubeLights'
+
+# Sources that talk to the hardware, which the host shims stand in for
+HARDWARE = ['AdcScan', 'CubeConfiguration', 'ObjectConfiguration',
+            'Peripherals']
+
+# -fpack-struct gives the structs the AVR layout the message size checks expect
+FLAGS = ['-std=gnu++11', '-O1', '-fno-rtti', '-fno-exceptions',
+         '-fpack-struct', '-Wno-address-of-packed-member', '-Wall', '-Wextra',
+         '-DTRI_ARRAY_SIZE=35']
+
+# Fixes that earlier trees need on the host, as (file, old, new).  Each is
+# only applied where the old text is still present.
+HOST_FIXES = [
+    # Zero length rather than flexible array, which g++ rejects in a class
+    ('Libraries/ObjectLibrary/Geometry.h',
+     'PRGB leds[];', 'PRGB leds[0];'),
+    # Spatial.cpp included Geometry.h without PixelUtil.h before user-045
+    ('Libraries/ObjectLibrary/Geometry.h',
+     '#define GEOMETRY\n\n/*',
+     '#define GEOMETRY\n\n#include "PixelUtil.h"\n\n/*'),
+    # The snake read past a triangle's LEDs when it reached NO_VERTEX
+    (MODULE + '/TriangleLightsModes.cpp',
+     'if ((triangles[tri].hasLeds()) &&',
+     'if ((vert < Triangle::NUM_LEDS) && (triangles[tri].hasLeds()) &&'),
+    # sizeof a pointer, which is the 2 byte mode data on the AVR
+    (MODULE + '/TriangleLightsModes.cpp',
+     'memcpy(rs485.send_buffer, data, sizeof(data));',
+     'memcpy(rs485.send_buffer, data, 2);'),
+    # Pointers don't fit an unsigned int on the host
+    (CUBE + '/CubeLightsUtil.cpp',
+     '(unsigned int)valptr - (unsigned int)data < msglen',
+     '(const byte *)valptr - data < msglen'),
+    # Without the square ids every edge led to face 0 and crawl never ended
+    ('Libraries/CubeLibrary/SquareStructure.cpp',
+     '  int led = firstLed;\n\n  // XXX: Build topology\n',
+     '  int led = firstLed;\n\n'
+     '  for (int face = 0; face < squareCount; face++) {\n'
+     '    squares[face].id = face;\n'
+     '  }\n'
+     '  // XXX: Build topology\n'),
+]
+
+# Modes that only show their colors are set again with new colors every
+# this many frames, and the snake with its next color mode
+RESEND = {'SET_ALL': 20, 'SNAKES_2': 60}
+
+
+class Runner(object):
+    def __init__(self, name, source, sketch, sources, runs):
+        self.name = name
+        self.source = source    # Relative to this directory
+        self.sketch = sketch
+        self.sources = sources  # Sketch sources no header leads to
+        self.runs = runs        # Golden directory for each topology argument
+
+
+RUNNERS = [
+    Runner('ModeRegression', 'ModeRegression.cpp', MODULE, [],
+           [('icosohedron', ['i']), ('cylinder', ['c'])]),
+    Runner('LegacyRegression', 'LegacyRegression.cpp', LEGACY,
+           ['TriangleLightsUtil.cpp'], [('legacy', ['i'])]),
+    Runner('CubeRegression', 'CubeRegression.cpp', CUBE,
+           ['CubeLightsUtil.cpp', 'CubeLightsMode.cpp',
+            'CubeLightsConnect.cpp'], [('cube', [])]),
+]
+
+# Host tests of the libraries, which exit non-zero on a failure
+TESTS = [
+    Runner('MedianFilterTest', 'MedianFilterTest.cpp', CUBE, [], []),
+    Runner('MessageRingTest', 'MessageRingTest.cpp', CUBE, [], []),
+    Runner('MessageBatchTest', 'MessageBatchTest.cpp', CUBE, [], []),
+    Runner('BusSimulation', 'BusSimulation.cpp', MODULE, [], []),
+    Runner('ClockSyncTest', 'ClockSyncTest.cpp', MODULE, [], []),
+]
+
+# Host tools built from the same sources with --build, which render nothing
+TOOLS = [
+    Runner('RenderFrames', '../RenderFrames/RenderFrames.cpp', MODULE, [],
+           []),
+    Runner('PatternBench', '../PatternBench/PatternBench.cpp', MODULE, [],
+           []),
+]
+
+
+def extract(revision, directory):
+    """Write the libraries and sketches of a revision into directory"""
+    archive = os.path.join(directory, 'tree.tar')
+    subprocess.check_call(['git', '-C', REPO, 'archive', '-o', archive,
+                           revision, 'Libraries', 'TriangleLights',
+                           'CubeLights'])
+    with tarfile.open(archive) as tar:
+        tar.extractall(directory)
+    os.remove(archive)
+
+    for name, old, new in HOST_FIXES:
+        path = os.path.join(directory, name)
+        with open(path) as f:
+            text = f.read()
+        if old in text:
+            with open(path, 'w') as f:
+                f.write(text.replace(old, new))
+
+
+def includes(path):
+    with open(path) as f:
+        return re.findall(r'^\s*#include\s+[<"]([\w/]+\.h)[>"]', f.read(),
+                          re.MULTILINE)
+
+
+def sources(tree, runner):
+    """Follow the #includes from the runner to the sources to build"""
+    dirs = [HOST] + [os.path.join(tree, lib) for lib in LIBRARIES] + \
+        [os.path.join(tree, runner.sketch)]
+    found = [os.path.normpath(os.path.join(HERE, runner.source)),
+             os.path.join(HOST, 'HostShims.cpp')] + \
+        [os.path.join(tree, runner.sketch, name) for name in runner.sources]
+
+    pending = list(found)
+    seen = set()
+    while pending:
+        for header in includes(pending.pop()):
+            if header in seen:
+                continue
+            seen.add(header)
+            for directory in dirs:
+                path = os.path.join(directory, header)
+                if os.path.exists(path):
+                    pending.append(path)
+                    source = path[:-2] + '.cpp'
+                    base = os.path.basename(path)[:-2]
+                    if (directory != HOST and base not in HARDWARE and
+                            os.path.exists(source) and source not in found):
+                        found.append(source)
+                        pending.append(source)
+                    break
+    return dirs, found
+
+
+def build(cxx, tree, runner, output, extra):
+    dirs, files = sources(tree, runner)
+    cmd = [cxx] + FLAGS + extra + ['-I' + d for d in dirs] + files + \
+        ['-o', output]
+    if subprocess.call(cmd) != 0:
+        sys.exit("Build of %s failed" % runner.name)
+
+
+def module_names(tree):
+    """Map program types to their TRIANGLES_ names"""
+    names = {}
+    with open(os.path.join(tree, MODULE, 'TriangleLightsModes.h')) as f:
+        for line in f:
+            match = re.match(r'#define\s+TRIANGLES_(\w+)\s+(0x[0-9A-Fa-f]+)',
+                             line)
+            if match:
+                names[int(match.group(2), 16)] = match.group(1)
+    return names
+
+
+def run(binary, args):
+    output = subprocess.check_output([binary] + args)
+    return output.decode('ascii').splitlines()
+
+
+def modes(tree, runner, binary):
+    """List the (name, argument) of every mode the runner can render"""
+    listed = run(binary, ['list'])
+    if runner.name != 'ModeRegression':
+        return [(name, name) for name in listed]
+
+    names = module_names(tree)
+    return [(names.get(int(line, 16), line), line) for line in listed]
+
+
+def render(binary, args):
+    """Render a mode, keeping only the frame hashes"""
+    return [line for line in run(binary, args)
+            if line.startswith('frame:') or line.startswith('frames:')]
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Compare the modes\' rendered frames against saved runs')
+    parser.add_argument('--regenerate', action='store_true',
+                        help='Rewrite the saved runs from this build')
+    parser.add_argument('--tree', metavar='REVISION',
+                        help='Render the modes of an earlier revision')
+    parser.add_argument('--modes', nargs='+', metavar='MODE',
+                        help='Only render these modes')
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('--frames', type=int, default=300)
+    parser.add_argument('--golden', default=os.path.join(HERE, 'golden'))
+    parser.add_argument('--cxx', default=os.environ.get('CXX', 'g++'))
+    parser.add_argument('--cxxflags', default='',
+                        help='Extra compiler flags, ie "-fsanitize=address"')
+    parser.add_argument('--build', metavar='DIRECTORY',
+                        help='Only build the runners and tools into DIRECTORY')
+    args = parser.parse_args()
+
+    if args.build:
+        tree = REPO
+        if not os.path.isdir(args.build):
+            os.makedirs(args.build)
+        for runner in RUNNERS + TESTS + TOOLS:
+            build(args.cxx, tree, runner, os.path.join(args.build, runner.name),
+                  args.cxxflags.split())
+        return
+
+    tmpdir = tempfile.mkdtemp()
+    try:
+        tree = REPO
+        if args.tree:
+            tree = os.path.join(tmpdir, 'tree')
+            os.makedirs(tree)
+            extract(args.tree, tree)
+
+        failures = 0
+        for runner in RUNNERS:
+            binary = os.path.join(tmpdir, runner.name)
+            build(args.cxx, tree, runner, binary, args.cxxflags.split())
+            available = modes(tree, runner, binary)
+
+            for run_name, run_args in runner.runs:
+                directory = os.path.join(args.golden, run_name)
+                if args.regenerate and not os.path.isdir(directory):
+                    os.makedirs(directory)
+
+                rendered = set()
+                for name, mode in available:
+                    if args.modes and name not in args.modes:
+                        continue
+                    rendered.add(name)
+
+                    path = os.path.join(directory, name + '.txt')
+                    lines = render(binary, run_args + [
+                        mode, str(args.seed), str(args.frames)] +
+                        ([str(RESEND[name])] if name in RESEND else []))
+
+                    if args.regenerate:
+                        with open(path, 'w') as f:
+                            f.write('\n'.join(lines) + '\n')
+                        print("Saved %s" % os.path.relpath(path))
+                        continue
+
+                    if not os.path.exists(path):
+                        print("MISSING %s %s" % (run_name, name))
+                        failures += 1
+                        continue
+
+                    with open(path) as f:
+                        expected = f.read().splitlines()
+                    if lines == expected:
+                        print("ok      %s %s" % (run_name, name))
+                    else:
+                        for i, (got, want) in enumerate(zip(lines, expected)):
+                            if got != want:
+                                break
+                        else:
+                            i = min(len(lines), len(expected))
+                        print("CHANGED %s %s at line %d" % (run_name, name,
+                                                            i + 1))
+                        failures += 1
+
+                # Saved runs of modes that this tree doesn't have yet
+                if os.path.isdir(directory) and not args.regenerate:
+                    for saved in sorted(os.listdir(directory)):
+                        name = saved[:-len('.txt')]
+                        if (saved.endswith('.txt') and name not in rendered
+                                and not (args.modes and
+                                         name not in args.modes)):
+                            print("absent  %s %s" % (run_name, name))
+
+        # The tests are of the current libraries, not an earlier tree's
+        for runner in TESTS if not args.tree else []:
+            binary = os.path.join(tmpdir, runner.name)
+            build(args.cxx, tree, runner, binary, args.cxxflags.split())
+            if subprocess.call([binary]) == 0:
+                print("ok      %s" % runner.name)
+            else:
+                print("FAILED  %s" % runner.name)
+                failures += 1
+    finally:
+        shutil.rmtree(tmpdir)
+
+    if failures:
+        sys.exit("%d mode(s) differ from the saved runs" % failures)
+
+
+if __name__ == '__main__':
+    main()
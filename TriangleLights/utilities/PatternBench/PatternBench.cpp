@@ -0,0 +1,115 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host timing of PatternVM against the same pattern compiled natively.  The
+ * built in wave that TRIANGLES_PATTERN runs until another pattern is loaded,
+ * sin(led * 8 + time), is run by the VM and by a native loop for a number of
+ * frames over every LED of the icosohedron or cylinder, and the microseconds
+ * per frame of each are printed.  The results of the two are first compared
+ * over a full cycle of the wave.
+ *
+ * Host times only show the VM's overhead relative to native code, the module
+ * should be timed with its 'g' command.
+ *
+ * Usage:
+ *   PatternBench <i|c> <frames>
+ *
+ * Build along with the mode regression's runners:
+ *   python ../ModeRegression/mode_regression.py --build <directory>
+ ******************************************************************************/
+
+#include <sys/time.h>
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include <Debug.h>
+
+#include "TriangleLights.h"
+#include "PatternVM.h"
+
+/* Globals that the triangle structure uses */
+#define NUM_PIXELS (TRI_ARRAY_SIZE * Triangle::NUM_LEDS)
+PixelUtil pixels(NUM_PIXELS);
+Triangle *triangles;
+
+const byte wave_pattern[] = {
+        0, // No frame code
+        VM_LED, VM_SHL, 3, VM_TIME, VM_ADD, VM_SIN
+};
+
+byte vm_buffer[PATTERN_VM_BUFFER_SIZE(NUM_PIXELS)];
+byte native_values[NUM_PIXELS];
+
+/* The wave as it would be written as a native mode */
+void native_frame(geo_led_t numLeds, uint16_t time) {
+  for (geo_led_t led = 0; led < numLeds; led++) {
+    native_values[led] = sin8((led << 3) + time);
+  }
+}
+
+/* Wall clock time, as the host's micros() follows the stepped clock */
+uint64_t wall_us() {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (uint64_t)now.tv_sec * 1000000UL + now.tv_usec;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s <i|c> <frames>\n", argv[0]);
+    return 1;
+  }
+
+  int numTriangles;
+  if (strcmp(argv[1], "i") == 0) {
+    triangles = buildIcosohedron(&numTriangles, NUM_PIXELS);
+  } else if (strcmp(argv[1], "c") == 0) {
+    triangles = buildCylinder(&numTriangles, NUM_PIXELS);
+  } else {
+    fprintf(stderr, "Unknown topology: %s\n", argv[1]);
+    return 1;
+  }
+  geo_led_t numLeds = numTriangles * Triangle::NUM_LEDS;
+  unsigned long frames = strtoul(argv[2], NULL, 0);
+
+  PatternVM vm(triangleLedNeighbor, numLeds, vm_buffer);
+  if (!vm.load(wave_pattern, sizeof (wave_pattern))) {
+    fprintf(stderr, "Pattern rejected\n");
+    return 1;
+  }
+
+  /* Check the VM against the native loop over a full cycle of the wave */
+  for (uint16_t time = 0; time < 256; time++) {
+    vm.frame(time);
+    native_frame(numLeds, time);
+    for (geo_led_t led = 0; led < numLeds; led++) {
+      if (vm.value(led) != native_values[led]) {
+        fprintf(stderr, "Time %u LED %u: vm %u native %u\n", time, led,
+                vm.value(led), native_values[led]);
+        return 1;
+      }
+    }
+  }
+
+  uint64_t start = wall_us();
+  for (unsigned long frame = 0; frame < frames; frame++) {
+    vm.frame(frame);
+  }
+  uint64_t vm_us = wall_us() - start;
+
+  start = wall_us();
+  for (unsigned long frame = 0; frame < frames; frame++) {
+    native_frame(numLeds, frame);
+  }
+  uint64_t native_us = wall_us() - start;
+
+  printf("leds:%u frames:%lu vm_us:%lu native_us:%lu\n", numLeds, frames,
+         (unsigned long)vm_us, (unsigned long)native_us);
+  if (frames > 0) {
+    printf("vm:%.3f us/frame native:%.3f us/frame\n",
+           (double)vm_us / frames, (double)native_us / frames);
+  }
+  return 0;
+}
@@ -0,0 +1,299 @@
+/*******************************************************************************
+ * Author: Adam Phelps
+ * License: Create Commons Attribution-Non-Commercial
+ * Copyright: 2016
+ *
+ * Host renderer for the triangle module's modes, for measuring how fast a
+ * mode renders apart from the LEDs and for looking at its frames without
+ * flashing a module.  A mode is started with the module's set_mode() and run
+ * with messages_and_modes(), stepping the clock 1ms per call until each frame
+ * is produced, as the module's 'g' command does.
+ *
+ * The topology is a built in icosohedron or cylinder, or the triangle
+ * structure from an EEPROM image read back from a module configured by
+ * TriangleConfigure.  The structure is the first record of its size unless
+ * an offset is given.  A built in topology can be written to an image with
+ * -w, at the given offset or 0.
+ *
+ * Frames are written as one of:
+ *   hash - A hash of the colors per frame, as the mode regression prints
+ *   raw  - To stdout, a 'F' followed by the RGB of every LED in triangle
+ *          order, as the module's binary output
+ *   ppm  - A PPM image per frame, a row of the triangle's LEDs per triangle
+ *
+ * Once done the number of frames, the microseconds spent in the calls that
+ * rendered them and the frames per second are printed to stderr.
+ *
+ * Usage:
+ *   RenderFrames list
+ *       Print the program type of each triangle mode in the program table
+ *   RenderFrames [-s seed] [-f hash|raw|ppm] [-o prefix] [-e offset]
+ *                <i|c|image> <program> <frames>
+ *   RenderFrames [-e offset] -w image <i|c>
+ *       Write a built in topology to an EEPROM image
+ *
+ * Build along with the mode regression's runners:
+ *   python ../ModeRegression/mode_regression.py --build <directory>
+ ******************************************************************************/
+
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include <Debug.h>
+
+#include <EEPromUtils.h>
+#include <HMTLTypes.h>
+#include <MessageHandler.h>
+#include <ProgramManager.h>
+#include <TimeSync.h>
+
+#include "TriangleLights.h"
+#include "TriangleLightsModes.h"
+
+/* Globals that the module's sketch provides */
+#define NUM_PIXELS (TRI_ARRAY_SIZE * Triangle::NUM_LEDS)
+PixelUtil pixels(NUM_PIXELS);
+
+RS485Socket rs485;
+#define SEND_BUFFER_SIZE 64
+byte rs485_data_buffer[RS485_BUFFER_TOTAL(SEND_BUFFER_SIZE)];
+Socket *sockets[1] = { &rs485 };
+
+int numTriangles = 0;
+Triangle *triangles;
+int triangleConfigOffset = -1;
+
+#define MAX_OUTPUTS 1
+config_hdr_t config;
+output_hdr_t pixel_output = { HMTL_OUTPUT_PIXELS, 0 };
+output_hdr_t *outputs[MAX_OUTPUTS] = { &pixel_output };
+void *objects[MAX_OUTPUTS] = { &pixels };
+
+TimeSync time;
+
+/* Inputs that the host doesn't have */
+byte get_button_value() { return 0; }
+byte get_pot_byte() { return 255; }
+void cliHandler(char **, byte) {}
+
+extern ProgramManager manager;
+
+#define MAX_STEP_MS 60000
+
+/* Time the module has been up when the mode is set */
+#define START_MS 10000
+
+#define FORMAT_HASH 0
+#define FORMAT_RAW  1
+#define FORMAT_PPM  2
+
+/* Wall clock time, as the host's micros() follows the stepped clock */
+uint64_t wall_us() {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (uint64_t)now.tv_sec * 1000000UL + now.tv_usec;
+}
+
+/* FNV-1a over the colors of every LED */
+uint32_t hash_triangles() {
+  uint32_t hash = 2166136261UL;
+  for (int tri = 0; tri < numTriangles; tri++) {
+    for (byte led = 0; led < Triangle::NUM_LEDS; led++) {
+      PRGB *rgb = &(triangles[tri].leds[led]);
+      hash = (hash ^ rgb->red) * 16777619UL;
+      hash = (hash ^ rgb->green) * 16777619UL;
+      hash = (hash ^ rgb->blue) * 16777619UL;
+    }
+  }
+  return hash;
+}
+
+void write_colors(FILE *file) {
+  for (int tri = 0; tri < numTriangles; tri++) {
+    for (byte led = 0; led < Triangle::NUM_LEDS; led++) {
+      PRGB *rgb = &(triangles[tri].leds[led]);
+      fputc(rgb->red, file);
+      fputc(rgb->green, file);
+      fputc(rgb->blue, file);
+    }
+  }
+}
+
+boolean write_ppm(const char *prefix, uint16_t frame) {
+  char path[256];
+  snprintf(path, sizeof (path), "%s%05u.ppm", prefix, frame);
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "Unable to write %s\n", path);
+    return false;
+  }
+  fprintf(file, "P6\n%u %d\n255\n", Triangle::NUM_LEDS, numTriangles);
+  write_colors(file);
+  fclose(file);
+  return true;
+}
+
+/*
+ * Read the triangle structure from an EEPROM image, setting the offset of the
+ * pattern that may be saved after it.
+ */
+boolean load_topology(const char *path, int offset, int *pattern_offset) {
+  if (host_eeprom_load(path) < 0) {
+    fprintf(stderr, "Unable to read %s\n", path);
+    return false;
+  }
+  if (offset < 0) offset = host_eeprom_find(sizeof (geometry_config_t));
+  if (offset >= 0) {
+    *pattern_offset = readTriangleStructure(offset, &triangles,
+                                            &numTriangles);
+  }
+  if ((offset < 0) || (*pattern_offset < 0)) {
+    fprintf(stderr, "No triangle structure in %s\n", path);
+    return false;
+  }
+  return true;
+}
+
+/* Write the triangle structure to an EEPROM image */
+boolean save_topology(const char *path, int offset) {
+  if (offset < 0) offset = 0;
+  if ((writeTriangleStructure(triangles, numTriangles, offset) < 0) ||
+      (host_eeprom_save(path) < 0)) {
+    fprintf(stderr, "Unable to write %s\n", path);
+    return false;
+  }
+  return true;
+}
+
+void usage(const char *name) {
+  fprintf(stderr, "Usage: %s list | [-s seed] [-f hash|raw|ppm] [-o prefix] "
+          "[-e offset] <i|c|image> <program> <frames> | "
+          "[-e offset] -w image <i|c>\n", name);
+}
+
+int main(int argc, char **argv) {
+  config.address = 0x100;
+  config.num_outputs = MAX_OUTPUTS;
+  rs485.initBuffer(rs485_data_buffer, SEND_BUFFER_SIZE);
+
+  if ((argc == 2) && (strcmp(argv[1], "list") == 0)) {
+    triangles = buildIcosohedron(&numTriangles, pixels.numPixels());
+    init_modes(sockets, 1);
+    for (byte i = 0; i < manager.num_functions; i++) {
+      hmtl_program_t *function = &manager.functions[i];
+      if ((function->type > HMTL_PROGRAM_SPARKLE) &&
+          (function->program != NULL)) {
+        printf("0x%02X\n", function->type);
+      }
+    }
+    return 0;
+  }
+
+  unsigned long seed = 1;
+  byte format = FORMAT_HASH;
+  const char *prefix = "frame";
+  const char *image = NULL;
+  int offset = -1;
+  int opt;
+  while ((opt = getopt(argc, argv, "s:f:o:e:w:")) != -1) {
+    switch (opt) {
+      case 's': seed = strtoul(optarg, NULL, 0); break;
+      case 'o': prefix = optarg; break;
+      case 'w': image = optarg; break;
+      case 'e': offset = strtol(optarg, NULL, 0); break;
+      case 'f': {
+        if (strcmp(optarg, "hash") == 0) format = FORMAT_HASH;
+        else if (strcmp(optarg, "raw") == 0) format = FORMAT_RAW;
+        else if (strcmp(optarg, "ppm") == 0) format = FORMAT_PPM;
+        else {
+          usage(argv[0]);
+          return 1;
+        }
+        break;
+      }
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+  if (argc - optind != (image ? 1 : 3)) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  const char *topology = argv[optind];
+  int pattern_offset = -1;
+  if (strcmp(topology, "i") == 0) {
+    triangles = buildIcosohedron(&numTriangles, pixels.numPixels());
+  } else if (strcmp(topology, "c") == 0) {
+    triangles = buildCylinder(&numTriangles, pixels.numPixels());
+  } else if (image || !load_topology(topology, offset, &pattern_offset)) {
+    if (image) usage(argv[0]);
+    return 1;
+  }
+
+  if (image) {
+    return save_topology(image, offset) ? 0 : 1;
+  }
+
+  byte program = strtol(argv[optind + 1], NULL, 0);
+  uint16_t frames = strtol(argv[optind + 2], NULL, 0);
+
+  init_modes(sockets, 1);
+  init_pattern(pattern_offset);
+
+  randomSeed(seed);
+  random16_set_seed((uint16_t)seed);
+  host_advance_us(START_MS * 1000UL);
+
+  if (!set_mode(program, false)) {
+    fprintf(stderr, "Unknown program: %s\n", argv[optind + 1]);
+    return 1;
+  }
+
+  uint64_t render_us = 0;
+  uint16_t frame;
+  for (frame = 0; frame < frames; frame++) {
+    unsigned long steps = 0;
+    boolean rendered;
+    do {
+      host_advance_us(1000);
+      uint64_t start = wall_us();
+      rendered = messages_and_modes();
+      if (rendered) {
+        /* Only count the calls that produced a frame */
+        render_us += wall_us() - start;
+      }
+    } while (!rendered && (++steps < MAX_STEP_MS));
+    if (!rendered) break;
+
+    switch (format) {
+      case FORMAT_HASH: {
+        printf("frame:%u ms:%lu hash:%08X\n", frame, millis(),
+               hash_triangles());
+        break;
+      }
+      case FORMAT_RAW: {
+        fputc('F', stdout);
+        write_colors(stdout);
+        break;
+      }
+      case FORMAT_PPM: {
+        if (!write_ppm(prefix, frame)) return 1;
+        break;
+      }
+    }
+  }
+  fflush(stdout);
+
+  fprintf(stderr, "frames:%u us:%lu", frame, (unsigned long)render_us);
+  if (render_us > 0) {
+    fprintf(stderr, " fps:%lu",
+            (unsigned long)((uint64_t)frame * 1000000UL / render_us));
+  }
+  fprintf(stderr, "\n");
+
+  return 0;
+}
@@ -140,6 +140,7 @@ Serial.print(F(" \n"
   "  R [face] - Reverse the 2nd and 3rd leds (common after T)\n"
   "  e <face> <edge> <neighbor> - Set the neighboring face\n"
   "  E <face> <neighbor> <neighbor> <neighbor> - Set all neighbors of face\n"
+"  o <face> <x> <y> <z> - Set the position of the face's center (+/-100)\n"
   " \n"
   "  l <face> <led> - Toggle the state of an LED on the indicated face\n"
   "  f <face> - Light the indicated face\n"
@@ -320,6 +321,24 @@ void cliHandler(char **tokens, byte numtokens) {
       break;
     }
 
+    case 'o': {
+      if (numtokens < 5) return;
+      byte face = atoi(tokens[1]);
+      int8_t x = constrain(atoi(tokens[2]), -GEO_COORD_MAX, GEO_COORD_MAX);
+      int8_t y = constrain(atoi(tokens[3]), -GEO_COORD_MAX, GEO_COORD_MAX);
+      int8_t z = constrain(atoi(tokens[4]), -GEO_COORD_MAX, GEO_COORD_MAX);
+
+      if (face >= numTriangles) return;
+
+      DEBUG2_VALUE("Set face:", face);
+      DEBUG2_VALUE(" center:", x);
+      DEBUG2_VALUE(",", y);
+      DEBUG2_VALUELN(",", z);
+
+      triangles[face].setCenter(x, y, z);
+      break;
+    }
+
     //XXX - Continue here
     
     /*